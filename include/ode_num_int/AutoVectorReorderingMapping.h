@@ -0,0 +1 @@
+#include "./alg/AutoVectorReorderingMapping.h"
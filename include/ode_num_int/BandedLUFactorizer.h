@@ -0,0 +1 @@
+#include "./lu/BandedLUFactorizer.h"
@@ -0,0 +1 @@
+#include "./lu/BlockLUFactorizer.h"
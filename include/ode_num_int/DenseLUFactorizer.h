@@ -0,0 +1 @@
+#include "./lu/DenseLUFactorizer.h"
@@ -0,0 +1 @@
+#include "./ode/EnsembleOdeRhs.h"
@@ -0,0 +1 @@
+#include "./la/EnsembleVectorData.h"
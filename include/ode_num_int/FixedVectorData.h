@@ -0,0 +1 @@
+#include "./la/FixedVectorData.h"
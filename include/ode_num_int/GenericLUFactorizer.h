@@ -0,0 +1 @@
+#include "./lu/GenericLUFactorizer.h"
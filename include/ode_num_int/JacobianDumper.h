@@ -0,0 +1 @@
+#include "./alg/JacobianDumper.h"
@@ -0,0 +1 @@
+#include "./lu/LUFactorizerSymbolic.h"
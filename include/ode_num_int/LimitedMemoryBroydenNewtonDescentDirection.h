@@ -0,0 +1 @@
+#include "./alg/LimitedMemoryBroydenNewtonDescentDirection.h"
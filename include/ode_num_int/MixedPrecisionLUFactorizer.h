@@ -0,0 +1 @@
+#include "./lu/MixedPrecisionLUFactorizer.h"
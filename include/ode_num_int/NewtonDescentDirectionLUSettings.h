@@ -0,0 +1 @@
+#include "./alg/interfaces/NewtonDescentDirectionLUSettings.h"
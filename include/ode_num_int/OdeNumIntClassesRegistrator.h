@@ -18,6 +18,8 @@ class OdeNumIntClassesRegistrator
     {
     private:
         AlgebraicSolverClassesRegistrator<VD> m_algebraicSolverClassesRegistrator;
+        // Algebraic solvers used by implicit ODE solvers (differ from the above ones for fixed-size VD)
+        AlgebraicSolverClassesRegistrator< typename ResizableVectorData<VD>::type > m_resizableAlgebraicSolverClassesRegistrator;
         OdeEventControllerClassesRegistrator<VD> m_odeEventControllerClassesRegistrator;
         OdeSolverCommonClassesRegistrator<VD> m_odeSolverCommonClassesRegistrator;
         OdeSolverClassesRegistrator<VD> m_odeSolverClassesRegistrator;
@@ -0,0 +1 @@
+#include "./ode/interfaces/OdeSolverLUSettings.h"
@@ -0,0 +1 @@
+#include "./lu/SparseLUFactorizer.h"
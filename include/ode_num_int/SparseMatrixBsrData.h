@@ -0,0 +1 @@
+#include "./la/SparseMatrixBsrData.h"
@@ -0,0 +1 @@
+#include "./la/SparseMatrixBuilder.h"
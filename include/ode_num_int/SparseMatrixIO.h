@@ -0,0 +1 @@
+#include "./la/SparseMatrixIO.h"
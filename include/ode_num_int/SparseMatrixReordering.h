@@ -0,0 +1 @@
+#include "./la/SparseMatrixReordering.h"
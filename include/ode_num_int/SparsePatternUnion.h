@@ -0,0 +1 @@
+#include "./la/SparsePatternUnion.h"
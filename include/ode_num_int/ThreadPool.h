@@ -0,0 +1 @@
+#include "./util/ThreadPool.h"
@@ -0,0 +1 @@
+#include "./la/VectorArena.h"
@@ -0,0 +1 @@
+#include "./la/VectorKernels.h"
@@ -0,0 +1,107 @@
+// AutoVectorReorderingMapping.h
+
+#ifndef _ALG_AUTOVECTORREORDERINGMAPPING_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _ALG_AUTOVECTORREORDERINGMAPPING_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./VectorReorderingMapping.h"
+#include "./computeJacobian.h"
+
+namespace ctm {
+namespace math {
+
+// Reordering mapping that computes the ordering automatically, in order to reduce
+// the envelope of the Jacobian factorized by LUFactorizer. The Jacobian pattern of the
+// mapping is computed once, at the argument passed to initOrdering() (or at zero argument
+// if the mapping is used before that), and the same symmetric permutation is applied
+// to inputs and outputs.
+template< class VD >
+class AutoVectorReorderingMapping :
+    public VectorReorderingMapping<VD>,
+    public FactoryMixin< AutoVectorReorderingMapping<VD>, VectorReorderingMapping<VD> >
+    {
+    public:
+        typedef VectorTemplate<VD> V;
+        typedef typename V::value_type real_type;
+        typedef OptionalParameters::Parameters Parameters;
+
+        AutoVectorReorderingMapping() :
+            m_method( "best" ),
+            m_initialized( false ),
+            m_size( 0 )
+            {
+            this->onMappingChanged( [this]() { m_initialized = false; } );
+            }
+
+        void initOrdering( const V& x )
+            {
+            auto& mapping = *this->mapping();
+            auto n = mapping.inputSize();
+            if( m_initialized   &&   m_size == n )
+                return;
+            if( mapping.outputSize() != n )
+                throw cxx::exception( "AutoVectorReorderingMapping: the mapping must have equal input and output sizes" );
+            computeJacobian( m_jacobian, mapping, x );
+            auto ordering = sparse::computeReordering( m_jacobian, sparse::reorderingMethodFromString( m_method ), &m_stats );
+            if( ordering.empty() ) {
+                ordering.resize( n );
+                for( unsigned int i=0; i<n; ++i )
+                    ordering[i] = i;
+                }
+            this->setInputOrdering( ordering );
+            this->setOutputOrdering( ordering );
+            m_initialized = true;
+            m_size = n;
+            }
+
+        sparse::ReorderingStats reorderingStats() const {
+            return m_stats;
+            }
+
+        Parameters parameters() const
+            {
+            Parameters result;
+            result["method"] = m_method;
+            return result;
+            }
+
+        void setParameters( const Parameters& parameters )
+            {
+            if( OptionalParameters::maybeLoadParameter( parameters, "method", m_method ) ) {
+                sparse::reorderingMethodFromString( m_method );
+                m_initialized = false;
+                }
+            }
+
+        Parameters helpOnParameters() const
+            {
+            Parameters result;
+            result["method"] =
+                    "Reordering method: 'rcm' (reverse Cuthill-McKee), 'sloan',\n"
+                    "'best' (the one of the above giving the smaller envelope), or 'none'";
+            return result;
+            }
+
+        std::string helpOnType() const {
+            return "Computes the ordering of variables and equations from the Jacobian pattern\n"
+                   "so as to reduce the envelope of the matrix factorized by the LU factorizer";
+            }
+
+    protected:
+        void maybeInit()
+            {
+            if( !m_initialized   ||   m_size != this->mapping()->inputSize() )
+                initOrdering( V( this->mapping()->inputSize() ) );
+            }
+
+    private:
+        std::string m_method;
+        bool m_initialized;
+        unsigned int m_size;
+        sparse::ReorderingStats m_stats;
+        sparse::SparseMatrixTemplate< sparse::SparseMatrixFastData< real_type > > m_jacobian;
+    };
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _ALG_AUTOVECTORREORDERINGMAPPING_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
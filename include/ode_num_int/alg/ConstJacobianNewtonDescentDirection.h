@@ -4,7 +4,8 @@
 #define _ALG_CONSTJACOBIANNEWTONDESCENTDIRECTION_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
 
 #include "./interfaces/NewtonDescentDirection.h"
-#include "../lu/LUFactorizer.h"
+#include "./interfaces/NewtonDescentDirectionLUSettings.h"
+#include "../lu/util.h"
 
 namespace ctm {
 namespace math {
@@ -18,11 +19,16 @@ class ConstJacobianNewtonDescentDirection :
     public:
         typedef VectorTemplate< VD > V;
         typedef typename VD::value_type real_type;
+        typedef OptionalParameters::Parameters Parameters;
+
+        ConstJacobianNewtonDescentDirection() :
+            m_luSettings( m_lu )
+            {}
 
         void reset( bool hard ) {
             if( hard ) {
                 this->jacobianProvider()->hardReset();
-                m_lu = decltype(m_lu)();
+                m_lu = decltype(m_lu)( m_lu.kind() );
                 }
             }
 
@@ -52,8 +58,28 @@ class ConstJacobianNewtonDescentDirection :
             this->luTimingStats += m_lu.timingStats();
             }
 
+        Parameters parameters() const
+            {
+            Parameters result;
+            m_luSettings.saveParameters( result );
+            return result;
+            }
+
+        void setParameters( const Parameters& parameters )
+            {
+            m_luSettings.loadParameters( parameters );
+            }
+
+        Parameters helpOnParameters() const
+            {
+            Parameters result;
+            m_luSettings.addHelpOnParameters( result );
+            return result;
+            }
+
     private:
-        LUFactorizer<real_type> m_lu;
+        GenericLUFactorizer<real_type> m_lu;
+        NewtonDescentDirectionLUSettings<real_type> m_luSettings;
     };
 
 } // end namespace math
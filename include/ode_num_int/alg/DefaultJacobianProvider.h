@@ -24,7 +24,7 @@ class DefaultJacobianProvider :
             if( auto jt = this->jacobianTrimmer() )
                 m_J = jt->trimJacobian( math::computeJacobian( *this->mapping(), x0 ) );
             else
-                m_J = math::computeJacobian( *this->mapping(), x0 );
+                math::computeJacobian( m_J, *this->mapping(), x0 );
             }
 
         FastSparseMatrix& jacobian() {
@@ -4,7 +4,7 @@
 #define _ALG_JACOBIANBROYDENUPDATENEWTONDESCENTDIRECTION_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
 
 #include "./interfaces/NewtonDescentDirection.h"
-#include "../lu/LUFactorizer.h"
+#include "./interfaces/NewtonDescentDirectionLUSettings.h"
 
 namespace ctm {
 namespace math {
@@ -21,9 +21,11 @@ class JacobianBroydenUpdateNewtonDescentDirection :
     public:
         typedef VectorTemplate< VD > V;
         typedef typename VD::value_type real_type;
+        typedef OptionalParameters::Parameters Parameters;
 
         JacobianBroydenUpdateNewtonDescentDirection() :
-            m_havePrev( false )
+            m_havePrev( false ),
+            m_luSettings( m_lu )
             {}
 
         void reset( bool hard )
@@ -67,18 +69,40 @@ class JacobianBroydenUpdateNewtonDescentDirection :
             m_fprev = f0;
             m_havePrev = true;
             this->jacobianObservers( J, x0, f0 );
-            LUFactorizer<real_type> lu( J );
+            m_lu.clearTimingStats();
+            m_lu.setMatrix( J );
             dir = f0;
-            lu.solve( &*dir.begin() );
+            m_lu.solve( &*dir.begin() );
             dir *= -1;
             this->ddirPostObservers( dir );
-            this->luTimingStats += lu.timingStats();
+            this->luTimingStats += m_lu.timingStats();
+            }
+
+        Parameters parameters() const
+            {
+            Parameters result;
+            m_luSettings.saveParameters( result );
+            return result;
+            }
+
+        void setParameters( const Parameters& parameters )
+            {
+            m_luSettings.loadParameters( parameters );
+            }
+
+        Parameters helpOnParameters() const
+            {
+            Parameters result;
+            m_luSettings.addHelpOnParameters( result );
+            return result;
             }
 
     private:
         V m_xprev;
         V m_fprev;
         bool m_havePrev;
+        GenericLUFactorizer<real_type> m_lu;
+        NewtonDescentDirectionLUSettings<real_type> m_luSettings;
     };
 
 } // end namespace math
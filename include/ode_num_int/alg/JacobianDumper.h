@@ -0,0 +1,86 @@
+// JacobianDumper.h
+
+#ifndef _ALG_JACOBIANDUMPER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _ALG_JACOBIANDUMPER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./interfaces/NewtonDescentDirection.h"
+#include "../la/SparseMatrixIO.h"
+#include "../util/cxx_str_fmt_num.h"
+#include <fstream>
+
+namespace ctm {
+namespace math {
+
+// Observer of Jacobian refreshes (see JacobianObservers) that writes every period-th
+// Jacobian matrix to a separate file, so that the matrices can be used offline, e.g.,
+// for benchmarking linear solvers. Files are named <prefix><number>.mtx in the Matrix Market
+// format, or <prefix><number>.bin in the binary format (see sparse::writeBinary()),
+// where number is the ordinal number of the dump, starting from zero.
+template< class VD >
+class JacobianDumper
+    {
+    public:
+        typedef VectorTemplate< VD > V;
+        typedef typename VD::value_type real_type;
+        typedef sparse::SparseMatrixTemplate< sparse::SparseMatrixFastData< real_type > > SparseMatrix;
+
+        enum Format { MatrixMarket, Binary };
+
+        explicit JacobianDumper( const std::string& fileNamePrefix, unsigned int period = 1, Format format = MatrixMarket ) :
+            m_fileNamePrefix( fileNamePrefix ),
+            m_period( period ),
+            m_format( format ),
+            m_refreshCount( 0 ),
+            m_dumpCount( 0 )
+            {
+            if( m_period == 0 )
+                throw cxx::exception( "JacobianDumper: period must be positive" );
+            }
+
+        void operator()( const SparseMatrix& J, const V& /*x0*/, const V& /*f0*/ )
+            {
+            if( m_refreshCount++ % m_period != 0 )
+                return;
+            auto fileName = m_fileNamePrefix + cxx::FormatInt( m_dumpCount ) + ( m_format == Binary? ".bin": ".mtx" );
+            std::ofstream os( fileName, m_format == Binary? std::ios::binary: std::ios::openmode() );
+            if( os.fail() )
+                throw cxx::exception( std::string("Failed to open output file '") + fileName + "'" );
+            if( m_format == Binary )
+                sparse::writeBinary( os, J );
+            else
+                sparse::writeMatrixMarket( os, J );
+            ++m_dumpCount;
+            }
+
+        // Returns the number of Jacobian refreshes observed so far
+        unsigned int refreshCount() const {
+            return m_refreshCount;
+            }
+
+        // Returns the number of files written so far
+        unsigned int dumpCount() const {
+            return m_dumpCount;
+            }
+
+        static Format formatFromString( const std::string& format )
+            {
+            if( format == "mtx" )
+                return MatrixMarket;
+            else if( format == "bin" )
+                return Binary;
+            else
+                throw cxx::exception( std::string("JacobianDumper: unknown format '") + format + "', expected 'mtx' or 'bin'" );
+            }
+
+    private:
+        std::string m_fileNamePrefix;
+        unsigned int m_period;
+        Format m_format;
+        unsigned int m_refreshCount;
+        unsigned int m_dumpCount;
+    };
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _ALG_JACOBIANDUMPER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
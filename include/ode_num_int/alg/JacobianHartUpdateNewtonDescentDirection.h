@@ -4,6 +4,7 @@
 #define _ALG_JACOBIANHARTUPDATENEWTONDESCENTDIRECTION_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
 
 #include "./interfaces/NewtonDescentDirection.h"
+#include "./interfaces/NewtonDescentDirectionLUSettings.h"
 #include "../lu/util.h"
 
 namespace ctm {
@@ -20,8 +21,10 @@ class JacobianHartUpdateNewtonDescentDirection :
     public:
         typedef VectorTemplate< VD > V;
         typedef typename VD::value_type real_type;
+        typedef OptionalParameters::Parameters Parameters;
 
         JacobianHartUpdateNewtonDescentDirection() :
+            m_luSettings( m_lu ),
             m_havePrev( false )
             {}
 
@@ -29,7 +32,7 @@ class JacobianHartUpdateNewtonDescentDirection :
             {
             if( hard ) {
                 this->jacobianProvider()->hardReset();
-                m_lu = decltype(m_lu)();
+                m_lu = decltype(m_lu)( m_lu.kind() );
                 }
             m_havePrev = false;
             }
@@ -81,8 +84,28 @@ class JacobianHartUpdateNewtonDescentDirection :
             this->luTimingStats += m_lu.timingStats();
             }
 
+        Parameters parameters() const
+            {
+            Parameters result;
+            m_luSettings.saveParameters( result );
+            return result;
+            }
+
+        void setParameters( const Parameters& parameters )
+            {
+            m_luSettings.loadParameters( parameters );
+            }
+
+        Parameters helpOnParameters() const
+            {
+            Parameters result;
+            m_luSettings.addHelpOnParameters( result );
+            return result;
+            }
+
     private:
-        LUFactorizer<real_type> m_lu;
+        GenericLUFactorizer<real_type> m_lu;
+        NewtonDescentDirectionLUSettings<real_type> m_luSettings;
         V m_xprev;
         V m_fprev;
         bool m_havePrev;
@@ -4,7 +4,7 @@
 #define _ALG_JACOBIANLAZYFAKEBROYDENUPDATENEWTONDESCENTDIRECTION_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
 
 #include "./interfaces/NewtonDescentDirection.h"
-#include "../lu/LUFactorizer.h"
+#include "./interfaces/NewtonDescentDirectionLUSettings.h"
 
 namespace ctm {
 namespace math {
@@ -25,6 +25,7 @@ class JacobianLazyFakeBroydenUpdateNewtonDescentDirection :
 
         JacobianLazyFakeBroydenUpdateNewtonDescentDirection() :
             m_lazyIterations( 10 ),
+            m_luSettings( m_lu ),
             m_havePrev( false ),
             m_lastIterationNumber( 0 ),
             m_jacobianAction ( RecomputeJacobian )
@@ -34,7 +35,7 @@ class JacobianLazyFakeBroydenUpdateNewtonDescentDirection :
             {
             if( hard ) {
                 this->jacobianProvider()->hardReset();
-                m_lu = decltype(m_lu)();
+                m_lu = decltype(m_lu)( m_lu.kind() );
                 m_jacobianAction = RecomputeJacobian;
                 }
             m_havePrev = false;
@@ -100,11 +101,14 @@ class JacobianLazyFakeBroydenUpdateNewtonDescentDirection :
             {
             Parameters result;
             result["lazy_iterations"] = m_lazyIterations;
+            m_luSettings.saveParameters( result );
             return result;
             }
 
-        void setParameters( const Parameters& parameters ) {
+        void setParameters( const Parameters& parameters )
+            {
             this->maybeLoadParameter( parameters, "lazy_iterations", m_lazyIterations );
+            m_luSettings.loadParameters( parameters );
             }
 
         Parameters helpOnParameters() const
@@ -112,6 +116,7 @@ class JacobianLazyFakeBroydenUpdateNewtonDescentDirection :
             Parameters result;
             result["lazy_iterations"] = "Only use the updated Jacobian when newton iteration count reaches this limit;\n"
                                         "or, if 0, use the updated Jacobian each time at first iteration.";
+            m_luSettings.addHelpOnParameters( result );
             return result;
             }
 
@@ -119,7 +124,8 @@ class JacobianLazyFakeBroydenUpdateNewtonDescentDirection :
         typedef sparse::SparseMatrixTemplate< sparse::SparseMatrixFastData< real_type > > FastSparseMatrix;
         unsigned int m_lazyIterations;
         FastSparseMatrix m_dJ;
-        LUFactorizer<real_type> m_lu;
+        GenericLUFactorizer<real_type> m_lu;
+        NewtonDescentDirectionLUSettings<real_type> m_luSettings;
         V m_xprev;
         V m_fprev;
         bool m_havePrev;
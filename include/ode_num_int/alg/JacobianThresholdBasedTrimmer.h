@@ -31,10 +31,11 @@ class JacobianThresholdBasedTrimmer :
             if( jmax == 0 )
                 return J;
             auto absThreshold = m_threshold * jmax;
+            // Note: elements of J are sorted, so the elements appended to the result are sorted as well
             for( const auto& e : J ) {
                 if( e.first.first == e.first.second   ||
                     std::fabs( e.second ) >= absThreshold )
-                    result.at( e.first ) = e.second;
+                    result.append( e.first, e.second );
                 }
             return result;
             }
@@ -51,7 +52,7 @@ class JacobianThresholdBasedTrimmer :
             }
 
     private:
-        double m_threshold;
+        real_type m_threshold;
     };
 
 } // end namespace math
@@ -23,10 +23,11 @@ class JacobianWidthBasedTrimmer :
             if( m_width == 0 )
                 return J;
             SparseMatrix result( J.size() );
+            // Note: elements of J are sorted, so the elements appended to the result are sorted as well
             for( const auto& e : J ) {
                 int d = e.first.first - e.first.second;
                 if( std::abs( d ) < static_cast<int>(m_width) )
-                    result.at( e.first ) = e.second;
+                    result.append( e.first, e.second );
                 }
             return result;
             }
@@ -0,0 +1,197 @@
+// LimitedMemoryBroydenNewtonDescentDirection.h
+
+#ifndef _ALG_LIMITEDMEMORYBROYDENNEWTONDESCENTDIRECTION_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _ALG_LIMITEDMEMORYBROYDENNEWTONDESCENTDIRECTION_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./interfaces/NewtonDescentDirection.h"
+#include "./interfaces/NewtonDescentDirectionLUSettings.h"
+#include <limits>
+#include <utility>
+#include <cmath>
+
+namespace ctm {
+namespace math {
+
+// The Jacobian J is computed and factorized for the first time; then it is updated each next time
+// using the "Broyden good" formula, like in JacobianBroydenUpdateNewtonDescentDirection, but the updated
+// matrix is never formed. Instead, the inverse of the updated matrix is kept in the product form
+// H = (I + a[k-1]*s[k-1]^T)*...*(I + a[0]*s[0]^T)*J^-1, where each factor follows from the Sherman-Morrison formula.
+// Therefore, the direction costs one solve with the factors of J, and a pair of dot product and
+// vector update per each pair (a, s). Only the last 'memory' steps are kept: each of them is stored as
+// the pair (s, z), where z = J^-1*y, so that when the oldest step is dropped, the vectors a are recomputed
+// from the remaining steps without solving with J again.
+template< class VD >
+class LimitedMemoryBroydenNewtonDescentDirection :
+    public NewtonDescentDirection< VD >,
+    public FactoryMixin< LimitedMemoryBroydenNewtonDescentDirection<VD>, NewtonDescentDirection<VD> >
+    {
+    public:
+        typedef VectorTemplate< VD > V;
+        typedef typename VD::value_type real_type;
+        typedef OptionalParameters::Parameters Parameters;
+
+        LimitedMemoryBroydenNewtonDescentDirection() :
+            m_memory( 10 ),
+            m_luSettings( m_lu ),
+            m_pairCount( 0 ),
+            m_havePrev( false )
+            {}
+
+        void reset( bool hard )
+            {
+            if( hard ) {
+                this->jacobianProvider()->hardReset();
+                m_lu = decltype(m_lu)( m_lu.kind() );
+                m_pairCount = 0;
+                }
+            m_havePrev = false;
+            }
+
+        bool hardResetMayHelp() const {
+            return true;
+            }
+
+        void computeDescentDirection( V& dir, const V& x0, const V& f0, unsigned int /*iterationNumber*/ )
+            {
+            m_lu.clearTimingStats();
+            auto jp = this->jacobianProvider();
+            ASSERT( jp );
+            auto& J = jp->jacobian();
+            bool recalcJacobian = !m_lu.isFactorized();
+            if( recalcJacobian ) {
+                this->jacobianRefreshObservers( true );
+                jp->computeJacobian( x0 );
+                m_lu.setMatrix( J );
+                this->jacobianRefreshObservers( false );
+                m_pairCount = 0;
+                }
+            this->ddirPreObservers();
+            bool update = !recalcJacobian   &&   m_havePrev;
+
+            // Note: jacobian observers see J, without the updates
+            this->jacobianObservers( J, x0, f0 );
+
+            // dir = J^-1*f0
+            dir = f0;
+            m_lu.solve( &*dir.begin() );
+
+            if( update ) {
+                // Add the pair for s = x0 - xprev, z = J^-1*y = J^-1*f0 - J^-1*fprev,
+                // dropping the oldest one if there are already 'memory' pairs.
+                // The new pair is skipped if its update is degenerate.
+                if( m_pairCount == m_memory )
+                    dropOldestPair();
+                if( m_a.size() == m_pairCount ) {
+                    m_a.push_back( V() );
+                    m_s.push_back( V() );
+                    m_z.push_back( V() );
+                    }
+                m_s[m_pairCount] = x0;
+                m_s[m_pairCount] -= m_xprev;
+                m_z[m_pairCount] = dir;
+                m_z[m_pairCount] -= m_zprev;
+                if( computeUpdate( m_pairCount ) )
+                    ++m_pairCount;
+                }
+            m_xprev = x0;
+            m_zprev = dir;
+            m_havePrev = true;
+
+            // dir = H*f0
+            applyUpdates( dir, m_pairCount );
+            dir *= -1;
+            this->ddirPostObservers( dir );
+            this->luTimingStats += m_lu.timingStats();
+            }
+
+        // Returns the number of Broyden updates currently applied on top of the factorized Jacobian
+        unsigned int pairCount() const {
+            return m_pairCount;
+            }
+
+        Parameters parameters() const
+            {
+            Parameters result;
+            result["memory"] = m_memory;
+            m_luSettings.saveParameters( result );
+            return result;
+            }
+
+        void setParameters( const Parameters& parameters )
+            {
+            if( this->maybeLoadParameter( parameters, "memory", m_memory ) ) {
+                if( m_memory == 0 )
+                    throw cxx::exception( "LimitedMemoryBroydenNewtonDescentDirection: memory must be positive" );
+                while( m_pairCount > m_memory )
+                    dropOldestPair();
+                }
+            m_luSettings.loadParameters( parameters );
+            }
+
+        Parameters helpOnParameters() const
+            {
+            Parameters result;
+            result["memory"] = "Number of the last Broyden updates applied on top of the factorized Jacobian";
+            m_luSettings.addHelpOnParameters( result );
+            return result;
+            }
+
+    private:
+        unsigned int m_memory;
+        GenericLUFactorizer<real_type> m_lu;
+        NewtonDescentDirectionLUSettings<real_type> m_luSettings;
+        std::vector< V > m_a;       // Update pairs (a, s), oldest first; only the first m_pairCount ones are used
+        std::vector< V > m_s;
+        std::vector< V > m_z;       // z = J^-1*y for each pair
+        unsigned int m_pairCount;
+        V m_xprev;
+        V m_zprev;                  // J^-1*fprev
+        V m_hy;                     // Buffer for H*y
+        bool m_havePrev;
+
+        // x = (I + a[count-1]*s[count-1]^T)*...*(I + a[0]*s[0]^T)*x
+        void applyUpdates( V& x, unsigned int count ) const
+            {
+            for( unsigned int k=0; k<count; ++k )
+                x += m_a[k] * m_s[k].dot( x );
+            }
+
+        // Computes a[k] = (s[k] - H*y[k]) / (s[k]^T*H*y[k]), where H*y[k] is obtained from z[k] by
+        // the updates of the preceding pairs. Returns false, leaving a[k] undefined, if the denominator is too small.
+        bool computeUpdate( unsigned int k )
+            {
+            m_hy = m_z[k];
+            applyUpdates( m_hy, k );
+            auto& s = m_s[k];
+            auto sHy = s.dot( m_hy );
+            auto tol = std::sqrt( std::numeric_limits<real_type>::epsilon() );
+            if( !( std::fabs( sHy ) > tol * std::sqrt( s.euclideanNormSquare() * m_hy.euclideanNormSquare() ) ) )
+                return false;
+            auto& a = m_a[k];
+            a = s;
+            a -= m_hy;
+            a *= 1 / sHy;
+            return true;
+            }
+
+        // Drops the oldest pair and recomputes the vectors a for the remaining ones,
+        // also dropping the pairs whose updates become degenerate; the storage of
+        // the dropped pairs ends up past the used ones and is reused
+        void dropOldestPair()
+            {
+            ASSERT( m_pairCount > 0 );
+            unsigned int count = 0;
+            for( unsigned int k=1; k<m_pairCount; ++k ) {
+                std::swap( m_s[count], m_s[k] );
+                std::swap( m_z[count], m_z[k] );
+                if( computeUpdate( count ) )
+                    ++count;
+                }
+            m_pairCount = count;
+            }
+    };
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _ALG_LIMITEDMEMORYBROYDENNEWTONDESCENTDIRECTION_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
@@ -37,9 +37,9 @@ class MappingNormalizer :
             {
             this->vectorMappingPreObservers( x, this );
             auto& dm = *this->diagonalMapping();
-            V arg = dm.VectorMapping<VD>::map( x );
-            V dstUnscaled = this->mapping()->map( arg );
-            dm.map( dst, dstUnscaled );
+            dm.map( m_arg, x );
+            this->mapping()->map( m_dstUnscaled, m_arg );
+            dm.map( dst, m_dstUnscaled );
             this->vectorMappingPostObservers( x, dst, this );
             }
 
@@ -58,6 +58,10 @@ class MappingNormalizer :
                 }
             this->setDiagonalMapping( std::make_shared< DiagonalMapping<VD> >( d ) );
             }
+
+    private:
+        mutable V m_arg;
+        mutable V m_dstUnscaled;
     };
 
 } // end namespace math
@@ -41,11 +41,11 @@ class NewtonIterationPerformerImpl :
             {
             if( iterationNumber == 0 )
                 m_hardResetTried = false;
-            auto f0 = currentResidual();
+            m_f0 = currentResidual();
             auto ddir = this->newtonDescentDirection();
-            auto dir = ddir->computeDescentDirection( m_x, f0, iterationNumber );
-            m_currentStepRatio = this->newtonLinearSearch()->lineSearch( dir, m_x, f0, &m_f );
-            m_x += dir.scaled( m_currentStepRatio );
+            ddir->computeDescentDirection( m_dir, m_x, m_f0, iterationNumber );
+            m_currentStepRatio = this->newtonLinearSearch()->lineSearch( m_dir, m_x, m_f0, &m_f );
+            m_x += m_dir.scaled( m_currentStepRatio );
             this->errorEstimator()->setCurrentSolution( m_x, m_f );
             auto result = this->errorEstimator()->currentStatus();
             if( m_currentStepRatio == 0   &&   result == ErrorEstimator<VD>::ContinueIterations )
@@ -60,7 +60,7 @@ class NewtonIterationPerformerImpl :
         const V& currentResidual() const
             {
             if( !m_f_valid ) {
-                m_f = this->mapping()->map( m_x );
+                this->mapping()->map( m_f, m_x );
                 m_f_valid = true;
                 }
             return m_f;
@@ -73,6 +73,8 @@ class NewtonIterationPerformerImpl :
     private:
         V m_x;
         mutable V m_f;
+        V m_f0;     // Buffers reused across iterations
+        V m_dir;
         mutable bool m_f_valid;
         real_type m_currentStepRatio;
         bool m_hardResetTried;
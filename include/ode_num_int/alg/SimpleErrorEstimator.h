@@ -21,9 +21,9 @@ class SimpleErrorEstimator :
         typedef typename ErrorEstimator< VD >::Status Status;
 
         SimpleErrorEstimator() :
-            m_absoluteTolerance( 1e-6 ),
-            m_relativeTolerance( 1e-6 ),
-            m_absoluteMaxThreshold( 1e20 ),
+            m_absoluteTolerance( real_type(1e-6) ),
+            m_relativeTolerance( real_type(1e-6) ),
+            m_absoluteMaxThreshold( real_type(1e20) ),
             m_relativeMaxThreshold( 10 ),
             m_absError( 0 ),
             m_relError( 0 )
@@ -38,9 +38,8 @@ class SimpleErrorEstimator :
 
         void setCurrentSolution( const V& solution, const V& residual )
             {
-            V dx = solution - m_currentSolution;
             real_type xnorm = m_currentSolution.infNorm();
-            m_relError = xnorm > 0 ?   dx.infNorm() / xnorm :   0;
+            m_relError = xnorm > 0 ?   ( solution - m_currentSolution ).infNorm() / xnorm :   0;
             m_currentSolution = solution;
             m_absError = residual.infNorm();
             this->errorObservers( solution, residual, this );
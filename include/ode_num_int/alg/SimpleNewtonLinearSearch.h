@@ -30,22 +30,17 @@ class SimpleNewtonLinearSearch :
             real_type alpha = 1;
             real_type alphaBest = 1;
             real_type f_f0Best = 1;
-            const real_type eta = 0.8;
+            const real_type eta = real_type(0.8);
             unsigned int itrunc;
-            auto makeNextState = [&]( real_type beta ) -> V {
-                V x = x0;
-                V dx = dir;
-                dx *= beta;
-                x += dx;
-                return x;
-                };
-            V f;
+            auto& x = m_x;
+            auto& f = m_f;
             auto rhsNormSquare = [&]( real_type beta ) -> real_type {
-                f = m( makeNextState( beta ) );
+                x = x0 + dir.scaled( beta );
+                m.map( f, x );
                 this->lineSearchObservers( iteration++, beta, dir, x0, f0, f );
                 return f.euclideanNormSquare();
                 };
-            for( itrunc=0; itrunc < m_maxStepTruncations; ++itrunc, alpha*=0.5 ) {
+            for( itrunc=0; itrunc < m_maxStepTruncations; ++itrunc, alpha/=2 ) {
                 real_type fNorm2 = rhsNormSquare( alpha );
                 real_type f_f0 = fNorm2 / f0Norm2;
                 if( f_f0Best > f_f0 ) {
@@ -60,7 +55,7 @@ class SimpleNewtonLinearSearch :
             if( itrunc == m_maxStepTruncations   &&   f_f0Best == 1 ) {
                 // cout << "No convergence within max. step truncations, trying the opposite direction" << endl;
                 alpha = alphaBest = -1;
-                for( itrunc=0; itrunc < m_maxStepTruncations; ++itrunc, alpha*=0.5 ) {
+                for( itrunc=0; itrunc < m_maxStepTruncations; ++itrunc, alpha/=2 ) {
                     real_type fNorm2 = rhsNormSquare( alpha );
                     real_type f_f0 = fNorm2 / f0Norm2;
                     if( f_f0Best > f_f0 ) {
@@ -91,6 +86,8 @@ class SimpleNewtonLinearSearch :
     private:
         const unsigned int DefaultMaxStepTruncations = 10;
         unsigned int m_maxStepTruncations;
+        V m_x;      // Buffers reused across calls to lineSearch()
+        V m_f;
     };
 
 } // end namespace math
@@ -44,7 +44,7 @@ class SparseJacobianProvider :
                 m_Jcalc = SparseJacobianCalculator<VD>( &m_J );
                 }
             else
-                m_Jcalc.calculate( *this->mapping(), x0, 1e-6 );
+                m_Jcalc.calculate( *this->mapping(), x0, real_type(1e-6) );
             }
 
         FastSparseMatrix& jacobian() {
@@ -30,6 +30,7 @@ class VectorNarrowingMapping :
             {
             checkIndices( disabledIndices, this->mapping()->inputSize(), "setInputNarrowing" );
             m_disabledInputIndices = normalizedIndices( disabledIndices );
+            m_enabledInputIndices = complementIndices( m_disabledInputIndices, this->mapping()->inputSize() );
             m_state = state;
             }
 
@@ -41,14 +42,17 @@ class VectorNarrowingMapping :
             {
             checkIndices( disabledIndices, this->mapping()->outputSize(), "setOutputNarrowing" );
             m_disabledOutputIndices = normalizedIndices( disabledIndices );
+            m_enabledOutputIndices = complementIndices( m_disabledOutputIndices, this->mapping()->outputSize() );
             }
 
         void narrowInput( V& dst, const V& src ) const {
-            reduce( dst, src, m_disabledInputIndices );
+            narrow( dst, src, m_disabledInputIndices, m_enabledInputIndices );
             }
 
         V narrowInput( const V& src ) const {
-            return reduce( src, m_disabledInputIndices );
+            V result;
+            narrowInput( result, src );
+            return result;
             }
 
         void widenInput( V& dst, const V& src ) const
@@ -56,18 +60,9 @@ class VectorNarrowingMapping :
             if( m_disabledInputIndices.empty() )
                 dst = src;
             else {
-                auto ns = this->mapping()->inputSize();
-                dst.resize( ns );
-                unsigned int is = 0,   in = 0,   id = 0;
-                for( ; is<ns; ++is ) {
-                    for( ; id<m_disabledInputIndices.size() && m_disabledInputIndices[id]<is; ++id ) {}
-                    if( id<m_disabledInputIndices.size() && m_disabledInputIndices[id]==is )
-                        dst[is] = m_state[is];
-                    else
-                        dst[is] = src[in++];
-                    }
-                ASSERT( id == m_disabledInputIndices.size() || id+1 == m_disabledInputIndices.size() );
-                ASSERT( in == src.size() );
+                dst.resize( this->mapping()->inputSize() );
+                dst.indexed( m_enabledInputIndices ) = src;
+                dst.indexed( m_disabledInputIndices ) = m_state.indexed( m_disabledInputIndices );
                 }
             }
 
@@ -78,11 +73,13 @@ class VectorNarrowingMapping :
             }
 
         void narrowOutput( V& dst, const V& src ) const {
-            reduce( dst, src, m_disabledOutputIndices );
+            narrow( dst, src, m_disabledOutputIndices, m_enabledOutputIndices );
             }
 
         V narrowOutput( const V& src ) const {
-            return reduce( src, m_disabledOutputIndices );
+            V result;
+            narrowOutput( result, src );
+            return result;
             }
 
         unsigned int inputSize() const {
@@ -95,26 +92,17 @@ class VectorNarrowingMapping :
 
         void map( V& dst, const V& x ) const
             {
-            V xs, dsts;
-            const V *px;
-            V *pdst;
-            if( m_disabledInputIndices.empty() )
-                px = &x;
-            else {
-                widenInput( xs, x );
-                px = &xs;
+            const V *px = &x;
+            if( !m_disabledInputIndices.empty() ) {
+                widenInput( m_xs, x );
+                px = &m_xs;
                 }
             if( m_disabledOutputIndices.empty() )
-                pdst = &dst;
+                this->mapping()->map( dst, *px );
             else {
-                auto ns = this->mapping()->outputSize();
-                dsts.resize( ns );
-                pdst = &dsts;
+                this->mapping()->map( m_dsts, *px );
+                narrowOutput( dst, m_dsts );
                 }
-            this->mapping()->map( *pdst, *px );
-
-            if( !m_disabledOutputIndices.empty() )
-                reduce( dst, dsts, m_disabledInputIndices );
             }
 
         std::vector<unsigned int> inputIds() const {
@@ -127,7 +115,11 @@ class VectorNarrowingMapping :
     private:
         std::vector< unsigned int > m_disabledInputIndices;
         std::vector< unsigned int > m_disabledOutputIndices;
+        std::vector< unsigned int > m_enabledInputIndices;
+        std::vector< unsigned int > m_enabledOutputIndices;
         V m_state;
+        mutable V m_xs;
+        mutable V m_dsts;
 
         static std::vector<unsigned int> normalizedIndices( const std::vector<unsigned int>& indices )
             {
@@ -139,6 +131,33 @@ class VectorNarrowingMapping :
             return result;
             }
 
+        // Returns indices in the range [0, size) that are not in the sorted array indices
+        static std::vector<unsigned int> complementIndices( const std::vector<unsigned int>& indices, unsigned int size )
+            {
+            std::vector<unsigned int> result;
+            result.reserve( size - indices.size() );
+            auto it = indices.begin();
+            for( unsigned int i=0; i<size; ++i ) {
+                if( it != indices.end() && *it == i )
+                    ++it;
+                else
+                    result.push_back( i );
+                }
+            return result;
+            }
+
+        static void narrow( V& dst, const V& src,
+                            const std::vector< unsigned int >& disabledIndices,
+                            const std::vector< unsigned int >& enabledIndices )
+            {
+            if( disabledIndices.empty() )
+                dst = src;
+            else {
+                ASSERT( src.size() == disabledIndices.size() + enabledIndices.size() );
+                dst = src.indexed( enabledIndices );
+                }
+            }
+
         static void checkIndices( const std::vector<unsigned int>& indices, unsigned int size, const char *methodName )
             {
             for( auto index : indices ) {
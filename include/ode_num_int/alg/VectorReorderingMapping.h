@@ -4,6 +4,7 @@
 #define _ALG_VECTORREORDERINGMAPPING_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
 
 #include "./interfaces/VectorMapping.h"
+#include "../la/SparseMatrixReordering.h"
 
 namespace ctm {
 namespace math {
@@ -37,6 +38,15 @@ class VectorReorderingMapping :
             m_outputOrdering = outputOrdering;
             }
 
+        // Called with a typical argument of the mapping before the mapping is used;
+        // implementations that compute orderings automatically can do it here.
+        virtual void initOrdering( const V& /*x*/ ) {}
+
+        // Returns envelope sizes of the Jacobian before and after reordering, if known.
+        virtual sparse::ReorderingStats reorderingStats() const {
+            return sparse::ReorderingStats();
+            }
+
         unsigned int inputSize() const
             {
             maybeInit();
@@ -114,10 +124,11 @@ class VectorReorderingMapping :
 
         void map( V& dst, const V& x ) const
             {
-            V xu, dstu;
-            unorderInput( xu, x );
-            this->mapping()->map( dstu, xu );
-            orderOutput( dst, dstu );
+            maybeInit();
+            m_xu.resize( x.size() );
+            m_xu.indexed( m_inputOrdering ) = x;
+            this->mapping()->map( m_dstu, m_xu );
+            dst = m_dstu.indexed( m_outputOrdering );
             }
 
         std::vector<unsigned int> inputIds() const
@@ -143,6 +154,8 @@ class VectorReorderingMapping :
     private:
         std::vector< unsigned int > m_inputOrdering;
         std::vector< unsigned int > m_outputOrdering;
+        mutable V m_xu;
+        mutable V m_dstu;
 
         template< class Container >
         void order( Container& dst, const Container& x, const std::vector<unsigned int> ordering ) const
@@ -9,8 +9,11 @@
 namespace ctm {
 namespace math {
 
+// Computes the Jacobian into J, reusing the storage of J
 template< class Mapping, class V >
-inline sparse::SparseMatrix< typename V::value_type > computeJacobian( const Mapping& mapping, const V& x0 )
+inline void computeJacobian(
+        sparse::SparseMatrixTemplate< sparse::SparseMatrixFastData< typename V::value_type > >& J,
+        const Mapping& mapping, const V& x0 )
     {
     typedef typename V::value_type real_type;
 
@@ -25,25 +28,29 @@ inline sparse::SparseMatrix< typename V::value_type > computeJacobian( const Map
     // Compute rhs at x0
     mapping.map( f0, x0 );
 
-    auto makeX = [&]( unsigned int i, real_type dx ) {
+    // Compute the Jacobian; elements are appended column by column and then sorted
+    real_type dx = real_type(1e-6);
+    J.clear();
+    J.resize( n, n );
+    for( unsigned int i=0; i<n; ++i ) {
         x = x0;
         x[i] += dx;
-        };
-
-    // Compute the Jacobian
-    real_type dx = 1e-6;
-    sparse::SparseMatrix< typename V::value_type > result( n, n );
-    for( unsigned int i=0; i<n; ++i ) {
-        makeX( i, dx );
         mapping.map( f, x );
         for( unsigned int j=0; j<n; ++j ) {
             auto df = f[j] - f0[j];
             if( df == 0 )
                 continue;
-            result.at( j, i ) = df / dx;
+            J.append( sparse::SparseMatrixCommonTypes::Index( j, i ), df / dx );
             }
         }
+    J.sortData();
+    }
 
+template< class Mapping, class V >
+inline sparse::SparseMatrixTemplate< sparse::SparseMatrixFastData< typename V::value_type > > computeJacobian( const Mapping& mapping, const V& x0 )
+    {
+    sparse::SparseMatrixTemplate< sparse::SparseMatrixFastData< typename V::value_type > > result;
+    computeJacobian( result, mapping, x0 );
     return result;
     }
 
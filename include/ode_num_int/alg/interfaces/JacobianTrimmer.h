@@ -18,7 +18,7 @@ class JacobianTrimmer :
     public:
         typedef VectorTemplate< VD > V;
         typedef typename VD::value_type real_type;
-        typedef sparse::SparseMatrix< real_type > SparseMatrix;
+        typedef sparse::SparseMatrixTemplate< sparse::SparseMatrixFastData<real_type> > SparseMatrix;
 
         virtual SparseMatrix trimJacobian( const SparseMatrix& J ) = 0;
     };
@@ -0,0 +1,49 @@
+// NewtonDescentDirectionLUSettings.h
+
+#ifndef _ALG_INTERFACES_NEWTONDESCENTDIRECTIONLUSETTINGS_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _ALG_INTERFACES_NEWTONDESCENTDIRECTIONLUSETTINGS_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "../../infra/OptionalParameters.h"
+#include "../../lu/GenericLUFactorizer.h"
+
+namespace ctm {
+namespace math {
+
+// Component of Newton descent directions that solve linear systems with the Jacobian;
+// loads and saves the kind of the LU factorizer owned by the descent direction.
+template< class real_type >
+class NewtonDescentDirectionLUSettings
+    {
+    public:
+        typedef OptionalParameters::Parameters Parameters;
+
+        explicit NewtonDescentDirectionLUSettings( GenericLUFactorizer<real_type>& lu ) :
+            m_lu( lu )
+            {}
+
+        NewtonDescentDirectionLUSettings( const NewtonDescentDirectionLUSettings<real_type>& ) = delete;
+        NewtonDescentDirectionLUSettings<real_type>& operator=( const NewtonDescentDirectionLUSettings<real_type>& ) = delete;
+
+        void saveParameters( Parameters& parameters ) const {
+            parameters["lu"] = luFactorizerKindToString( m_lu.kind() );
+            }
+
+        void loadParameters( const Parameters& parameters )
+            {
+            std::string kind;
+            if( OptionalParameters::maybeLoadParameter( parameters, "lu", kind ) )
+                m_lu.setKind( luFactorizerKindFromString( kind ) );
+            }
+
+        void addHelpOnParameters( Parameters& help ) const {
+            help["lu"] = helpOnLUFactorizerKind();
+            }
+
+    private:
+        GenericLUFactorizer<real_type>& m_lu;
+    };
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _ALG_INTERFACES_NEWTONDESCENTDIRECTIONLUSETTINGS_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
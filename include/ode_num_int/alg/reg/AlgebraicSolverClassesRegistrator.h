@@ -13,10 +13,12 @@
 #include "../JacobianFakeBroydenUpdateNewtonDescentDirection.h"
 #include "../JacobianLazyFakeBroydenUpdateNewtonDescentDirection.h"
 #include "../JacobianHartUpdateNewtonDescentDirection.h"
+#include "../LimitedMemoryBroydenNewtonDescentDirection.h"
 #include "../ConstJacobianNewtonDescentDirection.h"
 #include "../SimpleNewtonLinearSearch.h"
 #include "../NewtonIterationPerformerImpl.h"
 #include "../NewtonSolver.h"
+#include "../AutoVectorReorderingMapping.h"
 
 namespace ctm {
 
@@ -34,6 +36,7 @@ CTM_DECL_IMPLEMENTATION_TEMPLATE_TRAITS( math::JacobianBroydenUpdateNewtonDescen
 CTM_DECL_IMPLEMENTATION_TEMPLATE_TRAITS( math::JacobianFakeBroydenUpdateNewtonDescentDirection, "fake-broyden" )
 CTM_DECL_IMPLEMENTATION_TEMPLATE_TRAITS( math::JacobianLazyFakeBroydenUpdateNewtonDescentDirection, "lazy-fake-broyden" )
 CTM_DECL_IMPLEMENTATION_TEMPLATE_TRAITS( math::JacobianHartUpdateNewtonDescentDirection, "hart" )
+CTM_DECL_IMPLEMENTATION_TEMPLATE_TRAITS( math::LimitedMemoryBroydenNewtonDescentDirection, "lm-broyden" )
 CTM_DECL_IMPLEMENTATION_TEMPLATE_TRAITS( math::ConstJacobianNewtonDescentDirection, "const" )
 
 CTM_DECL_IMPLEMENTATION_TEMPLATE_TRAITS( math::SimpleNewtonLinearSearch, "simple" )
@@ -42,6 +45,8 @@ CTM_DECL_IMPLEMENTATION_TEMPLATE_TRAITS( math::NewtonIterationPerformerImpl, "de
 
 CTM_DECL_IMPLEMENTATION_TEMPLATE_TRAITS( math::NewtonSolver, "newton" )
 
+CTM_DECL_IMPLEMENTATION_TEMPLATE_TRAITS( math::AutoVectorReorderingMapping, "auto" )
+
 namespace math {
 
 template< class VD >
@@ -61,6 +66,7 @@ class AlgebraicSolverClassesRegistrator
         CTM_DECL_IMPLEMENTATION_TEMPLATE_REGISTRATOR( JacobianFakeBroydenUpdateNewtonDescentDirection, VD )
         CTM_DECL_IMPLEMENTATION_TEMPLATE_REGISTRATOR( JacobianLazyFakeBroydenUpdateNewtonDescentDirection, VD )
         CTM_DECL_IMPLEMENTATION_TEMPLATE_REGISTRATOR( JacobianHartUpdateNewtonDescentDirection, VD )
+        CTM_DECL_IMPLEMENTATION_TEMPLATE_REGISTRATOR( LimitedMemoryBroydenNewtonDescentDirection, VD )
         CTM_DECL_IMPLEMENTATION_TEMPLATE_REGISTRATOR( ConstJacobianNewtonDescentDirection, VD )
 
         CTM_DECL_IMPLEMENTATION_TEMPLATE_REGISTRATOR( SimpleNewtonLinearSearch, VD )
@@ -68,6 +74,8 @@ class AlgebraicSolverClassesRegistrator
         CTM_DECL_IMPLEMENTATION_TEMPLATE_REGISTRATOR( NewtonIterationPerformerImpl, VD )
 
         CTM_DECL_IMPLEMENTATION_TEMPLATE_REGISTRATOR( NewtonSolver, VD )
+
+        CTM_DECL_IMPLEMENTATION_TEMPLATE_REGISTRATOR( AutoVectorReorderingMapping, VD )
     };
 
 } // end namespace math
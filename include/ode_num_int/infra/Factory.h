@@ -190,7 +190,10 @@ class FactoryMixin : public TypeIdGetter< Interface >
                 /// \param typeId Type identifier to be associated with \a Type.
                 ///
                 /// Calls Factory::registerType(), passing newInstance() as generator and \a typeId as the type identifier.
+                /// \note Registering \a Type with the same type identifier again has no effect.
                 explicit Registrator( typename Factory<Interface>::TypeId typeId ) {
+                    if( Factory<Interface>::isTypeRegistered( typeId ) && staticTypeId() == typeId )
+                        return;
                     Factory<Interface>::registerType( typeId, &FactoryMixin<Type, Interface>::newInstance );
                     PerTypeStorage::value< FactoryMixin<Type, Interface>, typename Factory<Interface>::TypeId >() = typeId;
                     }
@@ -29,6 +29,7 @@ template< typename T > struct IsValidValueType : std::false_type {};
 template<> struct IsValidValueType<std::string> : std::true_type {};
 template<> struct IsValidValueType<int> : std::true_type {};
 template<> struct IsValidValueType<unsigned int> : std::true_type {};
+template<> struct IsValidValueType<float> : std::true_type {};
 template<> struct IsValidValueType<double> : std::true_type {};
 template<> struct IsValidValueType<bool> : std::true_type {};
 template<class Interface> struct IsValidValueType< std::shared_ptr<Interface> > : std::true_type {};
@@ -88,6 +89,14 @@ class OptionalParameters
                     m_value = s.str();
                     }
 
+                /// \brief Constructor accepting a float initializer (no nested parameters).
+                Value( float x )
+                    {
+                    std::ostringstream s;
+                    s << std::setprecision(8) << x;
+                    m_value = s.str();
+                    }
+
                 /// \brief Constructor accepting a boolean initializer (no nested parameters).
                 Value( bool x ) : m_value(x? "true": "false") {}
 
@@ -155,6 +164,13 @@ class OptionalParameters
                     dst = std::stod( m_value );
                     }
 
+                void toType( float& dst ) const
+                    {
+                    if( !lang::IsNumber( m_value.c_str() ) )
+                        throw cxx::exception( std::string("Not a number: '") + m_value + "'");
+                    dst = std::stof( m_value );
+                    }
+
                 void toType( int& dst ) const
                     {
                     if( !lang::IsIntegerNumber( m_value.c_str() ) )
@@ -0,0 +1,88 @@
+// EnsembleVectorData.h
+
+#ifndef _LA_ENSEMBLEVECTORDATA_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LA_ENSEMBLEVECTORDATA_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "VectorTemplate.h"
+
+namespace ctm {
+namespace math {
+
+// Vector data for an ensemble of M vectors of the same size (e.g., states of
+// M variants of a model), stored in the structure-of-arrays layout: the elements
+// with the same index in all members are interleaved, so that element
+// number i of member m is stored at position i*M + m.
+// The size of the data is M times the size of each member. Since elements of all members
+// are processed by the same loops, vector operations on the data are SIMD-friendly.
+template< class ElementType, unsigned int M >
+class EnsembleVectorData : public VectorData< ElementType >
+    {
+    public:
+        typedef EnsembleVectorData< ElementType, M > vector_data_type;
+        typedef VectorData< ElementType > base_type;
+        typedef typename base_type::value_type value_type;
+        typedef typename base_type::size_type size_type;
+        typedef typename base_type::reference reference;
+        typedef typename base_type::const_reference const_reference;
+
+        EnsembleVectorData() {}
+        explicit EnsembleVectorData( size_type size ) : base_type( size ) {
+            ASSERT( size % M == 0 );
+            }
+
+        static constexpr unsigned int memberCount() {
+            return M;
+            }
+
+        // Returns the size of each member
+        size_type memberSize() const {
+            return this->size() / M;
+            }
+
+        reference at( unsigned int index, unsigned int member ) {
+            ASSERT( member < M );
+            return base_type::at( index*M + member );
+            }
+
+        const_reference at( unsigned int index, unsigned int member ) const {
+            ASSERT( member < M );
+            return base_type::at( index*M + member );
+            }
+
+        using base_type::at;
+
+        // Copies member number member to dst
+        template< class D >
+        void getMember( VectorTemplate<D>& dst, unsigned int member ) const
+            {
+            ASSERT( member < M );
+            auto n = memberSize();
+            dst.resize( n );
+            auto src = this->begin() + member;
+            for( auto it=dst.begin(), end=dst.end(); it!=end; ++it, src+=M )
+                *it = *src;
+            }
+
+        // Copies src to member number member
+        template< class D >
+        void setMember( unsigned int member, const VectorTemplate<D>& src )
+            {
+            ASSERT( member < M );
+            ASSERT( src.size() == memberSize() );
+            auto dst = this->begin() + member;
+            for( auto it=src.begin(), end=src.end(); it!=end; ++it, dst+=M )
+                *dst = *it;
+            }
+    };
+
+template< unsigned int M >
+struct ContiguousVectorData< EnsembleVectorData<double, M> > :
+    ContiguousVectorData< typename EnsembleVectorData<double, M>::base_type > {};
+
+template< class ElementType, unsigned int M >
+struct OwningVectorData< EnsembleVectorData<ElementType, M> > : std::true_type {};
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LA_ENSEMBLEVECTORDATA_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
@@ -0,0 +1,120 @@
+// FixedVectorData.h
+
+#ifndef _LA_FIXEDVECTORDATA_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LA_FIXEDVECTORDATA_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "VectorTemplate.h"
+#include "../infra/cxx_exception.h"
+
+#include <array>
+
+namespace ctm {
+namespace math {
+
+// Vector data of size N known at compile time, stored in std::array.
+// Intended as the VD parameter of solvers for small systems of ODEs, in order
+// to avoid heap allocations and to let the compiler unroll the loops.
+// The size cannot be changed; resizing to any size other than N throws an exception.
+template< class ElementType, std::size_t N >
+class FixedVectorData
+    {
+    public:
+        typedef FixedVectorData< ElementType, N > vector_data_type;
+        typedef ElementType value_type;
+        typedef std::array< ElementType, N > Data;
+        typedef typename Data::size_type size_type;
+        typedef typename Data::iterator iterator;
+        typedef typename Data::reference reference;
+        typedef typename Data::const_reference const_reference;
+        typedef typename Data::const_iterator const_iterator;
+
+        FixedVectorData() : m_data() {}
+        explicit FixedVectorData( size_type size ) : m_data() {
+            resize( size );
+            }
+        explicit FixedVectorData( const Data& data ) : m_data( data ) {}
+
+        void swap( vector_data_type& that ) {
+            std::swap( m_data, that.m_data );
+            }
+
+        reference operator[]( unsigned int index ) {
+            ASSERT( index < N );
+            return m_data[index];
+            }
+
+        const_reference operator[]( unsigned int index ) const {
+            ASSERT( index < N );
+            return m_data[index];
+            }
+
+        reference at( unsigned int index ) {
+            return m_data.at( index );
+            }
+
+        const_reference at( unsigned int index ) const {
+            return m_data.at( index );
+            }
+
+        iterator begin() {
+            return m_data.begin();
+            }
+        const_iterator cbegin() const {
+            return m_data.begin();
+            }
+        const_iterator begin() const {
+            return m_data.begin();
+            }
+
+        iterator end() {
+            return m_data.end();
+            }
+        const_iterator cend() const {
+            return m_data.end();
+            }
+        const_iterator end() const {
+            return m_data.end();
+            }
+
+        void resize( size_type size ) {
+            if( size != N )
+                throw cxx::exception( "FixedVectorData: unable to change vector size" );
+            }
+
+        void clear() {
+            m_data.fill( value_type() );
+            }
+
+        static constexpr size_type size() {
+            return N;
+            }
+
+        Data& data() {
+            return m_data;
+            }
+
+        const Data& data() const {
+            return m_data;
+            }
+
+        template< class ThatD >
+        void assign( const ThatD& that )
+            {
+            resize( that.size() );
+            std::copy( that.begin(), that.end(), begin() );
+            }
+
+    private:
+        Data m_data;
+    };
+
+template< class ElementType, std::size_t N >
+struct ResizableVectorData< FixedVectorData< ElementType, N > >
+    {
+    typedef VectorData< ElementType > type;
+    };
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LA_FIXEDVECTORDATA_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
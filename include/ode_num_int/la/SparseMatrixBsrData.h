@@ -0,0 +1,418 @@
+// SparseMatrixBsrData.h
+
+#ifndef _LA_SPARSEMATRIXBSRDATA_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LA_SPARSEMATRIXBSRDATA_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./SparseMatrixTemplate.h"
+
+namespace ctm {
+namespace math {
+namespace sparse {
+
+// Sparse matrix data in the block compressed sparse row (BSR) format: the matrix consists
+// of dense square blocks of size BlockSize, and the nonzero blocks are stored block row
+// by block row. pointers()[I] is the position of the first block of block row I, indices()
+// are block column indices, and values() are the elements of blocks, BlockSize*BlockSize
+// elements per block, stored row by row.
+// All elements of the stored blocks are elements of the matrix (some of them may be zero);
+// at() inserts a zero block if the element belongs to a block that is not stored, and removeAt()
+// sets the element to zero and removes the block once all its elements are zero.
+// Elements are iterated row by row, so the order of iteration is the same as for SparseMatrixData.
+// Note: the sizes of the matrix must be multiples of BlockSize.
+template< class ElementType, unsigned int BlockSize >
+class SparseMatrixBsrData : public SparseMatrixTypes< ElementType >
+    {
+    public:
+        typedef SparseMatrixBsrData< ElementType, BlockSize > matrix_data_type;
+        typedef SparseMatrixCommonTypes::Index Index;
+        typedef ElementType element_type;
+        typedef std::size_t size_type;
+
+        static const unsigned int B = BlockSize;
+        static const unsigned int BlockArea = BlockSize*BlockSize;
+
+        template<class ActualElementType>
+        using iterator_value_type = std::pair< const Index, ActualElementType& >;
+
+        template< class ActualElementType >
+        class iterator_template : public std::iterator<
+                std::forward_iterator_tag,
+                iterator_value_type<ActualElementType>,
+                std::ptrdiff_t,
+                cxx::mock_ptr< iterator_value_type<ActualElementType> >,
+                iterator_value_type<ActualElementType> >
+            {
+            friend class SparseMatrixBsrData< ElementType, BlockSize >;
+            public:
+                typedef iterator_template< ActualElementType > ThisClass;
+                typedef iterator_value_type<ActualElementType> value_type;
+                typedef cxx::mock_ptr< value_type > pointer;
+                typedef value_type reference;
+
+                reference operator*() const
+                    {
+                    return value_type(
+                                Index( m_row, m_data->m_indices[m_block]*B + m_column ),
+                                m_values[m_block*BlockArea + (m_row%B)*B + m_column] );
+                    }
+                pointer operator->() const {
+                    return pointer( operator*() );
+                    }
+
+                template< class T2 >
+                bool operator==( const iterator_template< T2 >& that ) const {
+                    return m_row == that.m_row   &&   m_block == that.m_block   &&   m_column == that.m_column;
+                    }
+
+                template< class T2 >
+                bool operator!=( const iterator_template< T2 >& that ) const {
+                    return !( *this == that );
+                    }
+
+                iterator_template& operator++()
+                    {
+                    if( ++m_column == B ) {
+                        m_column = 0;
+                        if( ++m_block == m_data->m_pointers[m_row/B + 1] ) {
+                            ++m_row;
+                            m_block = m_data->m_pointers[m_row/B];
+                            normalize();
+                            }
+                        }
+                    return *this;
+                    }
+
+                template< class T2 >
+                iterator_template( const iterator_template< T2 >& that ) :
+                    m_data( that.m_data ),
+                    m_values( that.m_values ),
+                    m_row( that.m_row ),
+                    m_block( that.m_block ),
+                    m_column( that.m_column )
+                    {}
+            private:
+                template< class T2 > friend class iterator_template;
+                const matrix_data_type *m_data;
+                ActualElementType *m_values;
+                unsigned int m_row;     // Row of the element
+                size_type m_block;      // Position of the block containing the element
+                unsigned int m_column;  // Column of the element within the block
+
+                iterator_template( const matrix_data_type *data, ActualElementType *values, unsigned int row ) :
+                    m_data( data ), m_values( values ), m_row( row ), m_column( 0 )
+                    {
+                    auto& p = m_data->m_pointers;
+                    auto rowCount = static_cast< unsigned int >( ( p.size()-1 )*B );
+                    if( m_row > rowCount )
+                        m_row = rowCount;
+                    m_block = p[m_row/B];
+                    normalize();
+                    }
+
+                // Skips empty block rows
+                void normalize()
+                    {
+                    auto& p = m_data->m_pointers;
+                    for( auto blockRowCount=p.size()-1; m_row/B < blockRowCount && m_block == p[m_row/B + 1]; ) {
+                        m_row = ( m_row/B + 1 )*B;
+                        m_block = p[m_row/B];
+                        }
+                    }
+            };
+
+        typedef iterator_template< element_type > iterator;
+        typedef iterator_template< const element_type > const_iterator;
+
+        SparseMatrixBsrData() : m_pointers( 1, 0 ) {}
+
+        template< class That >
+        explicit SparseMatrixBsrData( const That& that ) : m_pointers( 1, 0 ) {
+            copyFrom( that, std::is_base_of< matrix_data_type, That >() );
+            }
+
+        template< class That >
+        matrix_data_type& operator=( const That& that ) {
+            copyFrom( that, std::is_base_of< matrix_data_type, That >() );
+            return *this;
+            }
+
+        element_type get( const Index& index ) const
+            {
+            auto pos = find( index );
+            return pos == npos()?   element_type(0):   m_values[pos];
+            }
+
+        element_type get( unsigned int r, unsigned int c ) const {
+            return get( Index( r, c ) );
+            }
+
+        bool hasIndex( const Index& index ) const {
+            return find( index ) != npos();
+            }
+
+        std::pair< element_type, bool > checkedGet( const Index& index ) const
+            {
+            auto pos = find( index );
+            if( pos == npos() )
+                return std::make_pair( element_type(0), false );
+            else
+                return std::make_pair( m_values[pos], true );
+            }
+
+        element_type operator[]( const Index& index ) const {
+            return get( index );
+            }
+
+        // Note: inserts a zero block if the element belongs to a block that is not stored
+        element_type& at( const Index& index )
+            {
+            auto I = index.first / B,   J = index.second / B;
+            if( I+1 >= m_pointers.size() )
+                m_pointers.resize( I+2, m_pointers.back() );
+            auto b = m_indices.begin() + m_pointers[I],   e = m_indices.begin() + m_pointers[I+1];
+            auto it = std::lower_bound( b, e, J );
+            size_type block = it - m_indices.begin();
+            if( it == e   ||   *it != J ) {
+                m_indices.insert( it, J );
+                m_values.insert( m_values.begin() + block*BlockArea, BlockArea, element_type(0) );
+                for( auto i=I+1; i<m_pointers.size(); ++i )
+                    ++m_pointers[i];
+                }
+            return m_values[block*BlockArea + (index.first%B)*B + index.second%B];
+            }
+
+        element_type& at( unsigned int r, unsigned int c ) {
+            return at( Index( r, c ) );
+            }
+
+        iterator begin() {
+            return iterator( this, m_values.data(), 0 );
+            }
+        const_iterator cbegin() const {
+            return const_iterator( this, m_values.data(), 0 );
+            }
+        const_iterator begin() const {
+            return cbegin();
+            }
+
+        iterator end() {
+            return iterator( this, m_values.data(), ~0u );
+            }
+        const_iterator cend() const {
+            return const_iterator( this, m_values.data(), ~0u );
+            }
+        const_iterator end() const {
+            return cend();
+            }
+
+        const_iterator rowBegin( unsigned int row ) const {
+            return const_iterator( this, m_values.data(), row );
+            }
+
+        const_iterator rowEnd( unsigned int row ) const {
+            return const_iterator( this, m_values.data(), row+1 );
+            }
+
+        void resizeData( const Index& size )
+            {
+            if( size.first % B != 0   ||   size.second % B != 0 )
+                throw cxx::exception( "SparseMatrixBsrData: matrix size must be a multiple of the block size" );
+            auto n = std::min<size_type>( m_pointers.size()-1, size.first/B );
+            auto columnCount = size.second/B;
+            size_type dst = 0;
+            for( size_type I=0; I<n; ++I ) {
+                auto b = m_pointers[I],   e = m_pointers[I+1];
+                m_pointers[I] = dst;
+                for( auto block=b; block<e; ++block )
+                    if( m_indices[block] < columnCount ) {
+                        m_indices[dst] = m_indices[block];
+                        std::copy( m_values.begin() + block*BlockArea, m_values.begin() + (block+1)*BlockArea, m_values.begin() + dst*BlockArea );
+                        ++dst;
+                        }
+                }
+            m_pointers[n] = dst;
+            m_pointers.resize( n+1 );
+            m_indices.resize( dst );
+            m_values.resize( dst*BlockArea );
+            }
+
+        // Sets the element to zero; removes the block if all its elements are zero
+        void removeAt( const Index& index )
+            {
+            auto pos = find( index );
+            if( pos == npos() )
+                return;
+            m_values[pos] = element_type(0);
+            auto block = pos / BlockArea;
+            auto values = m_values.begin() + block*BlockArea;
+            if( std::all_of( values, values + BlockArea, []( element_type x ) { return x == element_type(0); } ) ) {
+                m_indices.erase( m_indices.begin() + block );
+                m_values.erase( values, values + BlockArea );
+                for( auto i=index.first/B + 1; i<m_pointers.size(); ++i )
+                    --m_pointers[i];
+                }
+            }
+
+        // Note: the storage allocated previously is not released
+        void clear()
+            {
+            m_pointers.resize( 1 );
+            m_indices.clear();
+            m_values.clear();
+            }
+
+        size_type count() const {
+            return m_values.size();
+            }
+
+        bool empty() const {
+            return m_values.empty();
+            }
+
+        size_type blockCount() const {
+            return m_indices.size();
+            }
+
+        const std::vector< size_type >& pointers() const {
+            return m_pointers;
+            }
+
+        const std::vector< unsigned int >& indices() const {
+            return m_indices;
+            }
+
+        std::vector< element_type >& values() {
+            return m_values;
+            }
+
+        const std::vector< element_type >& values() const {
+            return m_values;
+            }
+
+        // Computes the product of the matrix of the specified size by the vector vs,
+        // writing the result to vd. Block rows are processed independently, by several
+        // threads in the case of a large matrix (see VectorKernels).
+        template< class It1, class It2 >
+        void multiplyRight( It1 vs, It2 vd, const Index& size ) const
+            {
+            auto p = m_pointers.data();
+            auto ind = m_indices.data();
+            auto v = m_values.data();
+            auto n = std::min<size_type>( m_pointers.size()-1, size.first/B );
+            VectorKernels::forEachChunk( n, [&]( std::size_t begin, std::size_t end ) {
+                for( auto I=begin; I<end; ++I ) {
+                    element_type sum[B];
+                    std::fill( sum, sum+B, element_type(0) );
+                    for( auto block=p[I], blockEnd=p[I+1]; block<blockEnd; ++block ) {
+                        auto a = v + block*BlockArea;
+                        auto x = vs + ind[block]*B;
+                        for( unsigned int i=0; i<B; ++i, a+=B )
+                            for( unsigned int j=0; j<B; ++j )
+                                sum[i] += a[j] * x[j];
+                        }
+                    std::copy( sum, sum+B, vd + I*B );
+                    }
+                } );
+            std::fill( vd + n*B, vd + size.first, 0 );
+            }
+
+        // Computes the product of the vector vs by the matrix of the specified size,
+        // writing the result to vd.
+        template< class It1, class It2 >
+        void multiplyLeft( It1 vs, It2 vd, const Index& size ) const
+            {
+            std::fill( vd, vd + size.second, 0 );
+            auto p = m_pointers.data();
+            auto ind = m_indices.data();
+            auto v = m_values.data();
+            for( size_type I=0, n=m_pointers.size()-1; I<n; ++I ) {
+                auto x = vs + I*B;
+                for( auto block=p[I], blockEnd=p[I+1]; block<blockEnd; ++block ) {
+                    auto a = v + block*BlockArea;
+                    auto y = vd + ind[block]*B;
+                    for( unsigned int i=0; i<B; ++i, a+=B )
+                        for( unsigned int j=0; j<B; ++j )
+                            y[j] += x[i] * a[j];
+                    }
+                }
+            }
+
+    private:
+        std::vector< size_type > m_pointers;
+        std::vector< unsigned int > m_indices;
+        std::vector< element_type > m_values;
+
+        size_type npos() const {
+            return m_values.size();
+            }
+
+        // Returns the position of the element in m_values, or npos()
+        size_type find( const Index& index ) const
+            {
+            auto I = index.first / B,   J = index.second / B;
+            if( I+1 >= m_pointers.size() )
+                return npos();
+            auto b = m_indices.begin() + m_pointers[I],   e = m_indices.begin() + m_pointers[I+1];
+            auto it = std::lower_bound( b, e, J );
+            if( it == e   ||   *it != J )
+                return npos();
+            return ( it - m_indices.begin() )*BlockArea + (index.first%B)*B + index.second%B;
+            }
+
+        template< class That >
+        void copyFrom( const That& that, std::true_type )
+            {
+            const matrix_data_type& d = that;
+            if( this != &d ) {
+                m_pointers = d.m_pointers;
+                m_indices = d.m_indices;
+                m_values = d.m_values;
+                }
+            }
+
+        template< class That >
+        void copyFrom( const That& that, std::false_type )
+            {
+            typedef std::pair< Index, element_type > E;
+            std::vector< E > elements;
+            for( auto it=that.begin(), end=that.end(); it!=end; ++it )
+                elements.push_back( E( it->first, it->second ) );
+            auto blockIndex = []( const Index& index ) { return Index( index.first/B, index.second/B ); };
+            std::stable_sort( elements.begin(), elements.end(), [&]( const E& l, const E& r ) {
+                return blockIndex( l.first ) < blockIndex( r.first );
+                } );
+            clear();
+            for( std::size_t i=0; i<elements.size(); ) {
+                auto blockRow = elements[i].first.first / B;
+                if( blockRow+1 >= m_pointers.size() )
+                    m_pointers.resize( blockRow+2, m_pointers.back() );
+                auto J = elements[i].first.second / B;
+                m_indices.push_back( J );
+                m_values.resize( m_values.size() + BlockArea, element_type(0) );
+                auto values = m_values.end() - BlockArea;
+                for( ; i<elements.size() && blockIndex( elements[i].first ) == Index( blockRow, J ); ++i ) {
+                    auto& index = elements[i].first;
+                    values[(index.first%B)*B + index.second%B] = elements[i].second;
+                    }
+                ++m_pointers.back();
+                }
+            }
+    };
+
+template< class ElementType, unsigned int BlockSize >
+const unsigned int SparseMatrixBsrData< ElementType, BlockSize >::B;
+
+template< class ElementType, unsigned int BlockSize >
+const unsigned int SparseMatrixBsrData< ElementType, BlockSize >::BlockArea;
+
+template< class ElementType, unsigned int BlockSize >
+struct HasMultiplicationKernels< SparseMatrixBsrData< ElementType, BlockSize > > : std::true_type {};
+
+template< class ElementType, unsigned int BlockSize >
+using BsrSparseMatrix = SparseMatrixTemplate< SparseMatrixBsrData< ElementType, BlockSize > >;
+
+} // end namespace sparse
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LA_SPARSEMATRIXBSRDATA_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
@@ -0,0 +1,141 @@
+// SparseMatrixBuilder.h
+
+#ifndef _LA_SPARSEMATRIXBUILDER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LA_SPARSEMATRIXBUILDER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./SparseMatrixTemplate.h"
+
+namespace ctm {
+namespace math {
+namespace sparse {
+
+// Assembles a sparse matrix from entries (row, column, value) added in an arbitrary order.
+// Entries with equal indices are summed. When the matrix is built, entries are sorted
+// in linear time by two passes of the counting sort, and then stored in the matrix.
+// The storage of the builder is reused, so repeated assembly of matrices of the same size
+// and with the same number of entries does not allocate memory.
+template< class ElementType >
+class SparseMatrixBuilder
+    {
+    public:
+        typedef ElementType element_type;
+        typedef SparseMatrixCommonTypes::Index Index;
+
+        void clear() {
+            m_entries.clear();
+            }
+
+        void reserve( std::size_t count ) {
+            m_entries.reserve( count );
+            }
+
+        void add( unsigned int row, unsigned int column, element_type value ) {
+            m_entries.push_back( Entry( row, column, value ) );
+            }
+
+        void add( const Index& index, element_type value ) {
+            add( index.first, index.second, value );
+            }
+
+        // Returns the number of entries added so far
+        std::size_t count() const {
+            return m_entries.size();
+            }
+
+        // Stores the sum of the entries in m, which is resized to size, and clears the builder.
+        // Entries with equal indices are summed in the order in which they have been added.
+        void build( SparseMatrixTemplate< SparseMatrixFastData< element_type > >& m, const Index& size )
+            {
+            sortAndSum( size, false );
+            m.clear();
+            m.resize( size );
+            for( auto& e : m_entries )
+                m.append( Index( e.row, e.column ), e.value );
+            clear();
+            }
+
+        template< bool ColumnMajor >
+        void build( SparseMatrixTemplate< SparseMatrixCompressedData< element_type, ColumnMajor > >& m, const Index& size )
+            {
+            sortAndSum( size, ColumnMajor );
+            auto majorCount = ColumnMajor?   size.second:   size.first;
+            m_pointers.assign( majorCount+1, 0 );
+            m_indices.resize( m_entries.size() );
+            for( std::size_t i=0, n=m_entries.size(); i<n; ++i ) {
+                auto& e = m_entries[i];
+                ++m_pointers[( ColumnMajor? e.column: e.row ) + 1];
+                m_indices[i] = ColumnMajor? e.row: e.column;
+                }
+            for( unsigned int i=0; i<majorCount; ++i )
+                m_pointers[i+1] += m_pointers[i];
+            m.setPattern( m_pointers, m_indices );
+            m.resize( size );
+            auto& values = m.values();
+            for( std::size_t i=0, n=m_entries.size(); i<n; ++i )
+                values[i] = m_entries[i].value;
+            clear();
+            }
+
+    private:
+        struct Entry
+            {
+            unsigned int row;
+            unsigned int column;
+            element_type value;
+            Entry( unsigned int row, unsigned int column, element_type value ) :
+                row( row ), column( column ), value( value ) {}
+            };
+        std::vector< Entry > m_entries;
+        std::vector< Entry > m_buffer;
+        std::vector< std::size_t > m_counts;
+        std::vector< std::size_t > m_pointers;
+        std::vector< unsigned int > m_indices;
+
+        // Sorts m_entries by the minor and then by the major index, and sums entries with equal indices
+        void sortAndSum( const Index& size, bool columnMajor )
+            {
+            for( auto& e : m_entries )
+                if( e.row >= size.first   ||   e.column >= size.second )
+                    throw cxx::exception( "SparseMatrixBuilder: element index is out of range" );
+            auto row = []( const Entry& e ) { return e.row; };
+            auto column = []( const Entry& e ) { return e.column; };
+            m_buffer.resize( m_entries.size(), Entry( 0, 0, element_type(0) ) );
+            if( columnMajor ) {
+                countingSort( m_buffer, m_entries, size.first, row );
+                countingSort( m_entries, m_buffer, size.second, column );
+                }
+            else {
+                countingSort( m_buffer, m_entries, size.second, column );
+                countingSort( m_entries, m_buffer, size.first, row );
+                }
+
+            // Sum entries with equal indices
+            auto dst = m_entries.begin();
+            for( auto it=m_entries.begin(), end=m_entries.end(); it!=end; ++it ) {
+                if( dst != m_entries.begin()   &&   (dst-1)->row == it->row   &&   (dst-1)->column == it->column )
+                    (dst-1)->value += it->value;
+                else
+                    *dst++ = *it;
+                }
+            m_entries.erase( dst, m_entries.end() );
+            }
+
+        // Stable sort of src by key(entry) in the range [0, keyCount); the result is placed into dst
+        template< class Key >
+        void countingSort( std::vector< Entry >& dst, const std::vector< Entry >& src, unsigned int keyCount, Key key )
+            {
+            m_counts.assign( keyCount+1, 0 );
+            for( auto& e : src )
+                ++m_counts[key( e ) + 1];
+            for( unsigned int i=0; i<keyCount; ++i )
+                m_counts[i+1] += m_counts[i];
+            for( auto& e : src )
+                dst[m_counts[key( e )]++] = e;
+            }
+    };
+
+} // end namespace sparse
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LA_SPARSEMATRIXBUILDER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
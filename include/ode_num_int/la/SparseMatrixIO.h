@@ -0,0 +1,228 @@
+// SparseMatrixIO.h
+
+#ifndef _LA_SPARSEMATRIXIO_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LA_SPARSEMATRIXIO_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./SparseMatrixBuilder.h"
+#include <istream>
+#include <ostream>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+
+namespace ctm {
+namespace math {
+namespace sparse {
+
+// Writes matrix m to the stream in the Matrix Market coordinate format
+// (real general matrix; indices are one-based). Values are written with
+// the precision sufficient to read them back exactly.
+template< class D >
+inline void writeMatrixMarket( std::ostream& stream, const SparseMatrixTemplate<D>& m )
+    {
+    auto precision = stream.precision( std::numeric_limits< typename D::element_type >::max_digits10 );
+    stream << "%%MatrixMarket matrix coordinate real general\n"
+           << m.size().first << ' ' << m.size().second << ' ' << m.count() << '\n';
+    for( auto v : m )
+        stream << v.first.first+1 << ' ' << v.first.second+1 << ' ' << v.second << '\n';
+    stream.precision( precision );
+    if( stream.fail() )
+        throw cxx::exception( "writeMatrixMarket: failed to write matrix" );
+    }
+
+// Reads matrix m from the stream in the Matrix Market coordinate format.
+// Real, integer, and pattern matrices are supported, either general, symmetric, or skew-symmetric.
+// M is any matrix type that can be built by SparseMatrixBuilder.
+// The size line is validated as in readBinary() before any memory is allocated.
+template< class M >
+inline void readMatrixMarket( std::istream& stream, M& m )
+    {
+    typedef typename M::element_type element_type;
+    auto fail = []( const std::string& message ) {
+        throw cxx::exception( "readMatrixMarket: " + message );
+        };
+
+    // Header
+    std::string line;
+    if( !std::getline( stream, line ) )
+        fail( "missing header" );
+    std::istringstream header( line );
+    std::string banner, object, format, field, symmetry;
+    header >> banner >> object >> format >> field >> symmetry;
+    auto lower = []( std::string& s ) {
+        std::transform( s.begin(), s.end(), s.begin(), []( char c ) { return static_cast<char>( ::tolower( c ) ); } );
+        };
+    lower( object );
+    lower( format );
+    lower( field );
+    lower( symmetry );
+    if( banner != "%%MatrixMarket"   ||   object != "matrix" )
+        fail( "invalid header" );
+    if( format != "coordinate" )
+        fail( "only the coordinate format is supported" );
+    bool pattern = field == "pattern";
+    if( !( pattern   ||   field == "real"   ||   field == "integer" ) )
+        fail( "unsupported field type '" + field + "'" );
+    bool symmetric = symmetry == "symmetric",   skew = symmetry == "skew-symmetric";
+    if( !( symmetric   ||   skew   ||   symmetry == "general" ) )
+        fail( "unsupported symmetry type '" + symmetry + "'" );
+
+    // Size line, preceded by comments
+    while( std::getline( stream, line ) )
+        if( !line.empty()   &&   line[0] != '%' )
+            break;
+    unsigned long long rows64 = 0,   cols64 = 0,   count64 = 0;
+    std::istringstream sizeLine( line );
+    if( !( sizeLine >> rows64 >> cols64 >> count64 ) )
+        fail( "invalid size line" );
+
+    // Validate the size line before allocating memory for the elements
+    if( rows64 > std::numeric_limits<unsigned int>::max()   ||   cols64 > std::numeric_limits<unsigned int>::max() )
+        fail( "the matrix size is too large" );
+    auto rows = static_cast<unsigned int>( rows64 ),   cols = static_cast<unsigned int>( cols64 );
+    if( count64 > static_cast<unsigned long long>( rows ) * cols )
+        fail( "the number of elements exceeds the matrix size" );
+    // Each element takes at least four characters, e.g., "1 1\n"
+    auto position = stream.tellg();
+    if( position != std::istream::pos_type( -1 ) ) {
+        stream.seekg( 0, std::ios::end );
+        auto end = stream.tellg();
+        stream.seekg( position );
+        if( end != std::istream::pos_type( -1 )   &&   count64 > static_cast<unsigned long long>( end - position ) / 4 )
+            fail( "unexpected end of data" );
+        }
+    auto factor = symmetric || skew?   2u:   1u;
+    if( count64 > std::numeric_limits<std::size_t>::max() / factor )
+        fail( "the number of elements is too large" );
+    auto count = static_cast<std::size_t>( count64 );
+
+    // Entries
+    SparseMatrixBuilder< element_type > builder;
+    builder.reserve( factor*count );
+    for( std::size_t i=0; i<count; ++i ) {
+        unsigned int r,   c;
+        element_type value = element_type(1);
+        if( !( stream >> r >> c )   ||   !( pattern   ||   stream >> value ) )
+            fail( "unexpected end of data" );
+        if( r == 0   ||   c == 0 )
+            fail( "invalid element index" );
+        --r;
+        --c;
+        builder.add( r, c, value );
+        if( ( symmetric || skew )   &&   r != c )
+            builder.add( c, r, skew? -value: value );
+        }
+    builder.build( m, SparseMatrixCommonTypes::Index( rows, cols ) );
+    }
+
+namespace priv {
+
+// Header of the binary matrix format; followed by arrays of row indices,
+// column indices, and values, of length count each.
+struct BinaryMatrixHeader
+    {
+    char magic[8];
+    std::uint32_t elementSize;
+    std::uint32_t rows;
+    std::uint32_t columns;
+    std::uint32_t reserved;
+    std::uint64_t count;
+
+    static const char *expectedMagic() {
+        return "ctmspmx1";
+        }
+    };
+
+} // end namespace priv
+
+// Writes matrix m to the stream in a simple binary format: a fixed-size header followed
+// by the arrays of row indices, column indices, and values. Integers and values are stored
+// in the native byte order, so files are meant to be read on the same kind of machine.
+// Note: the stream should be opened in the binary mode.
+template< class D >
+inline void writeBinary( std::ostream& stream, const SparseMatrixTemplate<D>& m )
+    {
+    typedef typename D::element_type element_type;
+    priv::BinaryMatrixHeader header;
+    std::memcpy( header.magic, priv::BinaryMatrixHeader::expectedMagic(), sizeof(header.magic) );
+    header.elementSize = sizeof( element_type );
+    header.rows = m.size().first;
+    header.columns = m.size().second;
+    header.reserved = 0;
+    header.count = m.count();
+
+    std::vector< std::uint32_t > rows,   columns;
+    std::vector< element_type > values;
+    rows.reserve( header.count );
+    columns.reserve( header.count );
+    values.reserve( header.count );
+    for( auto v : m ) {
+        rows.push_back( v.first.first );
+        columns.push_back( v.first.second );
+        values.push_back( v.second );
+        }
+    stream.write( reinterpret_cast<const char*>( &header ), sizeof(header) );
+    stream.write( reinterpret_cast<const char*>( rows.data() ), rows.size()*sizeof(std::uint32_t) );
+    stream.write( reinterpret_cast<const char*>( columns.data() ), columns.size()*sizeof(std::uint32_t) );
+    stream.write( reinterpret_cast<const char*>( values.data() ), values.size()*sizeof(element_type) );
+    if( stream.fail() )
+        throw cxx::exception( "writeBinary: failed to write matrix" );
+    }
+
+// Reads matrix m from the stream in the binary format written by writeBinary().
+// M is any matrix type that can be built by SparseMatrixBuilder.
+// The number of elements in the header is checked against the matrix size and, if the stream
+// supports seeking, against the length of the remaining data before any memory is allocated.
+template< class M >
+inline void readBinary( std::istream& stream, M& m )
+    {
+    typedef typename M::element_type element_type;
+    auto fail = []( const std::string& message ) {
+        throw cxx::exception( "readBinary: " + message );
+        };
+    priv::BinaryMatrixHeader header;
+    if( !stream.read( reinterpret_cast<char*>( &header ), sizeof(header) ) )
+        fail( "missing header" );
+    if( std::memcmp( header.magic, priv::BinaryMatrixHeader::expectedMagic(), sizeof(header.magic) ) != 0 )
+        fail( "invalid header" );
+    if( header.elementSize != sizeof( element_type ) )
+        fail( "element size mismatch" );
+
+    // Validate the number of elements before allocating memory for them
+    if( header.count > static_cast< std::uint64_t >( header.rows ) * header.columns )
+        fail( "the number of elements exceeds the matrix size" );
+    auto elementBytes = 2*sizeof(std::uint32_t) + sizeof(element_type);
+    auto position = stream.tellg();
+    if( position != std::istream::pos_type( -1 ) ) {
+        stream.seekg( 0, std::ios::end );
+        auto end = stream.tellg();
+        stream.seekg( position );
+        if( end != std::istream::pos_type( -1 )   &&
+            header.count > static_cast< std::uint64_t >( end - position ) / elementBytes )
+            fail( "unexpected end of data" );
+        }
+    if( header.count > std::numeric_limits< std::size_t >::max() / elementBytes )
+        fail( "the number of elements is too large" );
+
+    auto count = static_cast< std::size_t >( header.count );
+    std::vector< std::uint32_t > rows( count ),   columns( count );
+    std::vector< element_type > values( count );
+    stream.read( reinterpret_cast<char*>( rows.data() ), count*sizeof(std::uint32_t) );
+    stream.read( reinterpret_cast<char*>( columns.data() ), count*sizeof(std::uint32_t) );
+    stream.read( reinterpret_cast<char*>( values.data() ), count*sizeof(element_type) );
+    if( stream.fail() )
+        fail( "unexpected end of data" );
+
+    SparseMatrixBuilder< element_type > builder;
+    builder.reserve( count );
+    for( std::size_t i=0; i<count; ++i )
+        builder.add( rows[i], columns[i], values[i] );
+    builder.build( m, SparseMatrixCommonTypes::Index( header.rows, header.columns ) );
+    }
+
+} // end namespace sparse
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LA_SPARSEMATRIXIO_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
@@ -0,0 +1,386 @@
+// SparseMatrixReordering.h
+
+#ifndef _LA_SPARSEMATRIXREORDERING_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LA_SPARSEMATRIXREORDERING_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./SparseMatrixTemplate.h"
+#include <queue>
+
+namespace ctm {
+namespace math {
+namespace sparse {
+
+// Orderings computed by the functions below are symmetric permutations of square matrices.
+// ordering[i] is the original index of the row (and column) placed at position i; this is
+// the convention of VectorReorderingMapping. An empty ordering stands for the identity.
+
+// Undirected graph of a square sparsity pattern: vertices i and j are adjacent if either
+// element (i, j) or element (j, i) is in the pattern, i != j.
+class SparsePatternGraph
+    {
+    public:
+        template< class It >
+        SparsePatternGraph( unsigned int size, It begin, It end )
+            {
+            std::vector< std::pair< unsigned int, unsigned int > > edges;
+            for( auto it=begin; it!=end; ++it ) {
+                auto r = it->first.first,   c = it->first.second;
+                if( r >= size   ||   c >= size )
+                    throw cxx::exception( "SparsePatternGraph: element index is out of range" );
+                if( r != c ) {
+                    edges.push_back( std::make_pair( r, c ) );
+                    edges.push_back( std::make_pair( c, r ) );
+                    }
+                }
+            std::sort( edges.begin(), edges.end() );
+            edges.erase( std::unique( edges.begin(), edges.end() ), edges.end() );
+            m_pointers.assign( size+1, 0 );
+            m_adjacent.resize( edges.size() );
+            for( std::size_t i=0; i<edges.size(); ++i ) {
+                ++m_pointers[edges[i].first + 1];
+                m_adjacent[i] = edges[i].second;
+                }
+            for( unsigned int i=0; i<size; ++i )
+                m_pointers[i+1] += m_pointers[i];
+            }
+
+        template< class D >
+        explicit SparsePatternGraph( const SparseMatrixTemplate<D>& m ) :
+            SparsePatternGraph( m.size().first, m.begin(), m.end() )
+            {
+            ASSERT( m.size().first == m.size().second );
+            }
+
+        unsigned int size() const {
+            return static_cast<unsigned int>( m_pointers.size() - 1 );
+            }
+
+        unsigned int degree( unsigned int vertex ) const {
+            return static_cast<unsigned int>( m_pointers[vertex+1] - m_pointers[vertex] );
+            }
+
+        const unsigned int *adjacentBegin( unsigned int vertex ) const {
+            return m_adjacent.data() + m_pointers[vertex];
+            }
+
+        const unsigned int *adjacentEnd( unsigned int vertex ) const {
+            return m_adjacent.data() + m_pointers[vertex+1];
+            }
+
+    private:
+        std::vector< std::size_t > m_pointers;
+        std::vector< unsigned int > m_adjacent;
+    };
+
+namespace priv {
+
+// Buffers used by the breadth-first searches below, allocated once per ordering.
+// visited is zero for all vertices between the searches.
+struct LevelStructureBuffers
+    {
+    std::vector< unsigned int > distance;
+    std::vector< unsigned char > visited;
+    std::vector< unsigned int > levels;
+    std::vector< unsigned int > lastLevels;
+
+    explicit LevelStructureBuffers( unsigned int size ) :
+        distance( size ), visited( size, 0 )
+        {}
+    };
+
+// Computes the rooted level structure of the connected component containing root;
+// stores the vertices in the order of levels in levels, and the distances from root in
+// buffers.distance (only for the vertices of the component; other elements are not modified).
+// The time is proportional to the size of the component.
+inline void levelStructure(
+        const SparsePatternGraph& g, unsigned int root,
+        std::vector< unsigned int >& levels, LevelStructureBuffers& buffers )
+    {
+    auto& visited = buffers.visited;
+    auto& distance = buffers.distance;
+    levels.assign( 1, root );
+    visited[root] = 1;
+    distance[root] = 0;
+    for( std::size_t i=0; i<levels.size(); ++i ) {
+        auto v = levels[i];
+        for( auto a=g.adjacentBegin( v ), e=g.adjacentEnd( v ); a!=e; ++a )
+            if( !visited[*a] ) {
+                visited[*a] = 1;
+                distance[*a] = distance[v] + 1;
+                levels.push_back( *a );
+                }
+        }
+    for( auto v : levels )
+        visited[v] = 0;
+    }
+
+// Finds a pair of pseudo-peripheral vertices of the component containing start
+// (the algorithm of Gibbs, Poole, and Stockmeyer, as modified by George and Liu)
+inline std::pair< unsigned int, unsigned int > pseudoPeripheralVertices(
+        const SparsePatternGraph& g, unsigned int start, LevelStructureBuffers& buffers )
+    {
+    auto& distance = buffers.distance;
+    auto& levels = buffers.levels;
+    auto& lastLevels = buffers.lastLevels;
+    auto root = start;
+    levelStructure( g, root, levels, buffers );
+    while( true ) {
+        // Vertex of the last level with the minimal degree
+        auto depth = distance[levels.back()];
+        auto last = levels.back();
+        for( auto it=levels.rbegin(); it!=levels.rend() && distance[*it]==depth; ++it )
+            if( g.degree( *it ) <= g.degree( last ) )
+                last = *it;
+        levelStructure( g, last, lastLevels, buffers );
+        if( distance[lastLevels.back()] <= depth )
+            return std::make_pair( root, last );
+        root = last;
+        levels.swap( lastLevels );
+        }
+    }
+
+} // end namespace priv
+
+// Computes the reverse Cuthill-McKee ordering of the graph; each connected component
+// is started from a pseudo-peripheral vertex.
+inline std::vector< unsigned int > reverseCuthillMcKeeOrdering( const SparsePatternGraph& g )
+    {
+    auto n = g.size();
+    std::vector< unsigned int > result;
+    result.reserve( n );
+    std::vector< unsigned char > visited( n, 0 );
+    std::vector< unsigned int > adjacent;
+    priv::LevelStructureBuffers buffers( n );
+    for( unsigned int i=0; i<n; ++i ) {
+        if( visited[i] )
+            continue;
+        auto root = priv::pseudoPeripheralVertices( g, i, buffers ).first;
+        visited[root] = 1;
+        auto k = result.size();
+        result.push_back( root );
+        for( ; k<result.size(); ++k ) {
+            auto v = result[k];
+            adjacent.clear();
+            for( auto a=g.adjacentBegin( v ), e=g.adjacentEnd( v ); a!=e; ++a )
+                if( !visited[*a] ) {
+                    visited[*a] = 1;
+                    adjacent.push_back( *a );
+                    }
+            std::stable_sort( adjacent.begin(), adjacent.end(), [&g]( unsigned int a, unsigned int b ) {
+                return g.degree( a ) < g.degree( b );
+                } );
+            result.insert( result.end(), adjacent.begin(), adjacent.end() );
+            }
+        }
+    std::reverse( result.begin(), result.end() );
+    return result;
+    }
+
+// Computes the profile reducing ordering of the graph by the algorithm of Sloan
+// (S.W. Sloan, A Fortran program for profile and wavefront reduction, International
+// Journal for Numerical Methods in Engineering, 28 (1989), 2651-2679).
+// w1 and w2 are the weights of the distance to the end vertex and of the current degree
+// in the priority of vertices.
+inline std::vector< unsigned int > sloanOrdering( const SparsePatternGraph& g, int w1 = 2, int w2 = 1 )
+    {
+    enum Status { Inactive, Preactive, Active, Postactive };
+    auto n = g.size();
+    std::vector< unsigned int > result;
+    result.reserve( n );
+    std::vector< unsigned char > status( n, Inactive );
+    std::vector< long > priority( n );
+    priv::LevelStructureBuffers buffers( n );
+    auto& distance = buffers.distance;
+
+    // Queue entries are (priority, -vertex); entries with obsolete priorities are skipped
+    typedef std::pair< long, long > Entry;
+    std::priority_queue< Entry > queue;
+    auto push = [&]( unsigned int v ) {
+        queue.push( Entry( priority[v], -static_cast<long>( v ) ) );
+        };
+
+    for( unsigned int i=0; i<n; ++i ) {
+        if( status[i] != Inactive )
+            continue;
+        auto ends = priv::pseudoPeripheralVertices( g, i, buffers );
+        priv::levelStructure( g, ends.second, buffers.levels, buffers );
+        for( auto v : buffers.levels )
+            priority[v] = w1*static_cast<long>( distance[v] ) - w2*static_cast<long>( g.degree( v ) + 1 );
+        status[ends.first] = Preactive;
+        push( ends.first );
+        while( !queue.empty() ) {
+            auto entry = queue.top();
+            queue.pop();
+            auto v = static_cast<unsigned int>( -entry.second );
+            if( status[v] == Postactive   ||   priority[v] != entry.first )
+                continue;
+            if( status[v] == Preactive )
+                for( auto a=g.adjacentBegin( v ), e=g.adjacentEnd( v ); a!=e; ++a ) {
+                    priority[*a] += w2;
+                    if( status[*a] == Inactive )
+                        status[*a] = Preactive;
+                    if( status[*a] != Postactive )
+                        push( *a );
+                    }
+            status[v] = Postactive;
+            result.push_back( v );
+            for( auto a=g.adjacentBegin( v ), e=g.adjacentEnd( v ); a!=e; ++a ) {
+                if( status[*a] != Preactive )
+                    continue;
+                status[*a] = Active;
+                priority[*a] += w2;
+                push( *a );
+                for( auto b=g.adjacentBegin( *a ), be=g.adjacentEnd( *a ); b!=be; ++b )
+                    if( status[*b] != Postactive ) {
+                        priority[*b] += w2;
+                        if( status[*b] == Inactive )
+                            status[*b] = Preactive;
+                        push( *b );
+                        }
+                }
+            }
+        }
+    return result;
+    }
+
+// Returns the number of off-diagonal elements in the envelope (profile) of the square
+// matrix of the specified size with elements in [begin, end), reordered as specified.
+// This is the number of off-diagonal elements of L and U stored by LUFactorizer.
+template< class It >
+inline std::size_t envelopeSize( unsigned int size, It begin, It end, const std::vector< unsigned int >& ordering = std::vector< unsigned int >() )
+    {
+    std::vector< unsigned int > position( size );
+    for( unsigned int i=0; i<size; ++i )
+        position[ordering.empty()? i: ordering[i]] = i;
+    std::vector< unsigned int > p( size ),   q( size );
+    for( unsigned int i=0; i<size; ++i )
+        p[i] = q[i] = i;
+    for( auto it=begin; it!=end; ++it ) {
+        auto r = position[it->first.first],   c = position[it->first.second];
+        p[r] = std::min( p[r], c );
+        q[c] = std::min( q[c], r );
+        }
+    std::size_t result = 0;
+    for( unsigned int i=0; i<size; ++i )
+        result += ( i - p[i] ) + ( i - q[i] );
+    return result;
+    }
+
+template< class D >
+inline std::size_t envelopeSize( const SparseMatrixTemplate<D>& m, const std::vector< unsigned int >& ordering = std::vector< unsigned int >() )
+    {
+    ASSERT( m.size().first == m.size().second );
+    return envelopeSize( m.size().first, m.begin(), m.end(), ordering );
+    }
+
+enum ReorderingMethod {
+    NoReordering,
+    ReverseCuthillMcKeeReordering,
+    SloanReordering,
+    BestReordering      // The one of the above orderings giving the smallest envelope
+    };
+
+inline ReorderingMethod reorderingMethodFromString( const std::string& method )
+    {
+    if( method == "none" )
+        return NoReordering;
+    else if( method == "rcm" )
+        return ReverseCuthillMcKeeReordering;
+    else if( method == "sloan" )
+        return SloanReordering;
+    else if( method == "best" )
+        return BestReordering;
+    else
+        throw cxx::exception( std::string("Unknown reordering method '") + method + "', expected one of 'none', 'rcm', 'sloan', 'best'" );
+    }
+
+struct ReorderingStats
+    {
+    std::size_t envelopeBefore;
+    std::size_t envelopeAfter;
+    ReorderingStats() : envelopeBefore( 0 ), envelopeAfter( 0 ) {}
+    };
+
+// Computes the ordering of the square matrix m by the specified method.
+// Returns an empty ordering if the method is NoReordering or the ordering computed
+// does not reduce the envelope of the matrix.
+template< class D >
+inline std::vector< unsigned int > computeReordering( const SparseMatrixTemplate<D>& m, ReorderingMethod method, ReorderingStats *stats = nullptr )
+    {
+    std::vector< unsigned int > result;
+    auto before = envelopeSize( m );
+    auto after = before;
+    if( method != NoReordering ) {
+        SparsePatternGraph g( m );
+        auto consider = [&]( std::vector< unsigned int >&& ordering ) {
+            auto size = envelopeSize( m, ordering );
+            if( size < after ) {
+                after = size;
+                result = std::move( ordering );
+                }
+            };
+        if( method == ReverseCuthillMcKeeReordering   ||   method == BestReordering )
+            consider( reverseCuthillMcKeeOrdering( g ) );
+        if( method == SloanReordering   ||   method == BestReordering )
+            consider( sloanOrdering( g ) );
+        }
+    if( stats ) {
+        stats->envelopeBefore = before;
+        stats->envelopeAfter = after;
+        }
+    return result;
+    }
+
+// Sets dst to the symmetric permutation of the square matrix src by the ordering,
+// dst(i, j) = src(ordering[i], ordering[j]). Positions of the elements of dst in the
+// value array of src are stored in positions, so that the values of dst can later be
+// updated by permuteValues() as long as the pattern of src remains the same.
+template< class E >
+inline void permutePattern(
+        CsrSparseMatrix<E>& dst, std::vector< std::size_t >& positions,
+        const CsrSparseMatrix<E>& src, const std::vector< unsigned int >& ordering )
+    {
+    auto n = src.size().first;
+    ASSERT( src.size().second == n   &&   ordering.size() == n );
+    std::vector< unsigned int > position( n );
+    for( unsigned int i=0; i<n; ++i )
+        position[ordering[i]] = i;
+    auto& sp = src.pointers();
+    auto& si = src.indices();
+    std::vector< std::size_t > pointers( n+1, 0 );
+    std::vector< unsigned int > indices;
+    indices.reserve( si.size() );
+    positions.clear();
+    std::vector< std::pair< unsigned int, std::size_t > > row;
+    for( unsigned int r=0; r<n; ++r ) {
+        auto sr = ordering[r];
+        row.clear();
+        if( sr+1 < sp.size() )
+            for( auto k=sp[sr]; k<sp[sr+1]; ++k )
+                row.push_back( std::make_pair( position[si[k]], k ) );
+        std::sort( row.begin(), row.end() );
+        for( auto& e : row ) {
+            indices.push_back( e.first );
+            positions.push_back( e.second );
+            }
+        pointers[r+1] = indices.size();
+        }
+    dst.setPattern( pointers, indices );
+    dst.resize( n, n );
+    }
+
+template< class E >
+inline void permuteValues( CsrSparseMatrix<E>& dst, const std::vector< std::size_t >& positions, const CsrSparseMatrix<E>& src )
+    {
+    auto& dv = dst.values();
+    auto& sv = src.values();
+    ASSERT( dv.size() == positions.size() );
+    for( std::size_t k=0, n=positions.size(); k<n; ++k )
+        dv[k] = sv[positions[k]];
+    }
+
+} // end namespace sparse
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LA_SPARSEMATRIXREORDERING_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
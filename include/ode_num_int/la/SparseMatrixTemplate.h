@@ -10,6 +10,7 @@
 #include <functional>
 #include <string>
 #include <sstream>
+#include <type_traits>
 
 #include "../infra/cxx_assert.h"
 #include "../infra/cxx_mock_ptr.h"
@@ -77,7 +78,7 @@ class SparseMatrixData : public SparseMatrixTypes< ElementType >
 
         element_type get( const Index& index ) const {
             auto it = m_data.find( index );
-            return it == m_data.end() ?   0. :   it->second;
+            return it == m_data.end() ?   element_type(0) :   it->second;
             }
 
         element_type get( unsigned int r, unsigned int c ) const {
@@ -91,7 +92,7 @@ class SparseMatrixData : public SparseMatrixTypes< ElementType >
         std::pair< element_type, bool > checkedGet( const Index& index ) const
             {
             auto it = m_data.find( index );
-            return it == m_data.end() ?   std::make_pair( 0., false ) :   std::make_pair( it->second, true );
+            return it == m_data.end() ?   std::make_pair( element_type(0), false ) :   std::make_pair( it->second, true );
             }
 
         element_type operator[]( const Index& index ) const {
@@ -203,7 +204,7 @@ class SparseMatrixFastData : public SparseMatrixTypes< ElementType >
             {
             auto it = std::lower_bound( begin(), end(), index, &matrix_data_type::compare );
             if( it == end()   ||   it->first != index )
-                return element_type( 0. );
+                return element_type( 0 );
             else
                 return it->second;
             }
@@ -222,7 +223,7 @@ class SparseMatrixFastData : public SparseMatrixTypes< ElementType >
             {
             auto it = std::lower_bound( begin(), end(), index, &matrix_data_type::compare );
             if( it == end()   ||   it->first != index )
-                return std::make_pair( element_type(0.), false );
+                return std::make_pair( element_type(0), false );
             else
                 return std::make_pair( it->second, true );
             }
@@ -263,26 +264,46 @@ class SparseMatrixFastData : public SparseMatrixTypes< ElementType >
             return m_data.end();
             }
 
-        const_iterator rowBegin( unsigned int ) const {
-            throw cxx::exception("Not implemented");
+        const_iterator rowBegin( unsigned int row ) const {
+            return std::lower_bound( begin(), end(), Index(row, 0), &matrix_data_type::compare );
             }
 
-        const_iterator rowEnd( unsigned int ) const {
-            throw cxx::exception("Not implemented");
+        const_iterator rowEnd( unsigned int row ) const {
+            return std::lower_bound( rowBegin( row ), end(), Index(row+1, 0), &matrix_data_type::compare );
             }
 
-        void resizeData( const Index& ) {
-            throw cxx::exception("Not implemented");
+        void resizeData( const Index& size )
+            {
+            m_data.erase( std::remove_if( m_data.begin(), m_data.end(), [&]( const data_element_type& e ) {
+                return e.first.first >= size.first   ||   e.first.second >= size.second;
+                } ), m_data.end() );
             }
 
-        void removeAt( const Index& ) {
-            throw cxx::exception("Not implemented");
+        void removeAt( const Index& index )
+            {
+            auto it = std::lower_bound( m_data.begin(), m_data.end(), index, &matrix_data_type::compare );
+            if( !( it == m_data.end()   ||   it->first != index ) )
+                m_data.erase( it );
             }
 
         void clear() {
             m_data.clear();
             }
 
+        // Appends element to the data; unless elements are appended in the order
+        // of their indices, sortData() must be called when all elements are appended.
+        // Note: clear() followed by append() reuses the storage allocated previously.
+        void append( const Index& index, element_type value ) {
+            m_data.push_back( data_element_type( index, value ) );
+            }
+
+        void sortData()
+            {
+            std::sort( m_data.begin(), m_data.end(), []( const data_element_type& l, const data_element_type& r ) {
+                return l.first < r.first;
+                } );
+            }
+
         size_type count() const {
             return m_data.size();
             }
@@ -308,6 +329,459 @@ class SparseMatrixFastData : public SparseMatrixTypes< ElementType >
             }
     };
 
+// Sparse matrix data in the compressed sparse row (CSR) or compressed sparse column (CSC) format.
+// In the CSR format (ColumnMajor = false), the elements are stored row by row; pointers()[r]
+// is the position of the first element of row r, indices() are column indices, and values()
+// are element values. In the CSC format (ColumnMajor = true), the roles of rows and columns
+// are exchanged. Elements are iterated in the order of storage.
+// Element access costs a binary search within a row (column); inserting a new element by at()
+// requires moving all subsequent elements, unless elements are inserted in the order of storage.
+template< class ElementType, bool ColumnMajor >
+class SparseMatrixCompressedData : public SparseMatrixTypes< ElementType >
+    {
+    public:
+        typedef SparseMatrixCompressedData< ElementType, ColumnMajor > matrix_data_type;
+        typedef SparseMatrixCommonTypes::Index Index;
+        typedef ElementType element_type;
+        typedef std::size_t size_type;
+
+        template<class ActualElementType>
+        using iterator_value_type = std::pair< const Index, ActualElementType& >;
+
+        template< class ActualElementType >
+        class iterator_template : public std::iterator<
+                std::forward_iterator_tag,
+                iterator_value_type<ActualElementType>,
+                std::ptrdiff_t,
+                cxx::mock_ptr< iterator_value_type<ActualElementType> >,
+                iterator_value_type<ActualElementType> >
+            {
+            friend class SparseMatrixCompressedData< ElementType, ColumnMajor >;
+            public:
+                typedef iterator_template< ActualElementType > ThisClass;
+                typedef iterator_value_type<ActualElementType> value_type;
+                typedef cxx::mock_ptr< value_type > pointer;
+                typedef value_type reference;
+
+                reference operator*() const
+                    {
+                    auto minor = m_data->m_indices[m_pos];
+                    return value_type( ColumnMajor? Index( minor, m_major ): Index( m_major, minor ), m_values[m_pos] );
+                    }
+                pointer operator->() const {
+                    return pointer( operator*() );
+                    }
+
+                template< class T2 >
+                bool operator==( const iterator_template< T2 >& that ) const {
+                    return m_pos == that.m_pos;
+                    }
+
+                template< class T2 >
+                bool operator!=( const iterator_template< T2 >& that ) const {
+                    return m_pos != that.m_pos;
+                    }
+
+                iterator_template& operator++()
+                    {
+                    if( m_minor == ~0u ) {
+                        ++m_pos;
+                        skipEmpty();
+                        }
+                    else {
+                        ++m_major;
+                        findMinor();
+                        }
+                    return *this;
+                    }
+
+                template< class T2 >
+                iterator_template( const iterator_template< T2 >& that ) :
+                    m_data( that.m_data ),
+                    m_values( that.m_values ),
+                    m_major( that.m_major ),
+                    m_minor( that.m_minor ),
+                    m_pos( that.m_pos )
+                    {}
+            private:
+                template< class T2 > friend class iterator_template;
+                const matrix_data_type *m_data;
+                ActualElementType *m_values;
+                unsigned int m_major;
+                unsigned int m_minor;   // ~0u, unless iterating over a row of CSC or a column of CSR
+                size_type m_pos;
+
+                iterator_template( const matrix_data_type *data, ActualElementType *values,
+                                   unsigned int major, unsigned int minor, size_type pos ) :
+                    m_data( data ), m_values( values ), m_major( major ), m_minor( minor ), m_pos( pos )
+                    {
+                    if( m_minor == ~0u )
+                        skipEmpty();
+                    else
+                        findMinor();
+                    }
+
+                void skipEmpty()
+                    {
+                    auto& p = m_data->m_pointers;
+                    for( auto n=p.size()-1; m_major<n && m_pos>=p[m_major+1]; ++m_major ) {}
+                    }
+
+                void findMinor()
+                    {
+                    auto& p = m_data->m_pointers;
+                    auto& ind = m_data->m_indices;
+                    for( auto n=p.size()-1; m_major<n; ++m_major ) {
+                        auto b = ind.begin() + p[m_major],   e = ind.begin() + p[m_major+1];
+                        auto it = std::lower_bound( b, e, m_minor );
+                        if( it != e   &&   *it == m_minor ) {
+                            m_pos = it - ind.begin();
+                            return;
+                            }
+                        }
+                    m_pos = ind.size();
+                    }
+            };
+
+        typedef iterator_template< element_type > iterator;
+        typedef iterator_template< const element_type > const_iterator;
+
+        SparseMatrixCompressedData() : m_pointers( 1, 0 ) {}
+
+        template< class That >
+        explicit SparseMatrixCompressedData( const That& that ) : m_pointers( 1, 0 ) {
+            copyFrom( that, std::is_base_of< matrix_data_type, That >() );
+            }
+
+        template< class That >
+        matrix_data_type& operator=( const That& that ) {
+            copyFrom( that, std::is_base_of< matrix_data_type, That >() );
+            return *this;
+            }
+
+        element_type get( const Index& index ) const
+            {
+            auto pos = find( index );
+            return pos == npos()?   element_type(0):   m_values[pos];
+            }
+
+        element_type get( unsigned int r, unsigned int c ) const {
+            return get( Index( r, c ) );
+            }
+
+        bool hasIndex( const Index& index ) const {
+            return find( index ) != npos();
+            }
+
+        std::pair< element_type, bool > checkedGet( const Index& index ) const
+            {
+            auto pos = find( index );
+            if( pos == npos() )
+                return std::make_pair( element_type(0), false );
+            else
+                return std::make_pair( m_values[pos], true );
+            }
+
+        element_type operator[]( const Index& index ) const {
+            return get( index );
+            }
+
+        // Note: inserts a zero element if there is no element with the specified index
+        element_type& at( const Index& index )
+            {
+            auto major = majorIndex( index );
+            auto minor = minorIndex( index );
+            if( major+1 >= m_pointers.size() )
+                m_pointers.resize( major+2, m_pointers.back() );
+            auto b = m_indices.begin() + m_pointers[major],   e = m_indices.begin() + m_pointers[major+1];
+            auto it = std::lower_bound( b, e, minor );
+            auto pos = it - m_indices.begin();
+            if( it == e   ||   *it != minor ) {
+                m_indices.insert( it, minor );
+                m_values.insert( m_values.begin() + pos, element_type(0) );
+                for( auto i=major+1; i<m_pointers.size(); ++i )
+                    ++m_pointers[i];
+                }
+            return m_values[pos];
+            }
+
+        element_type& at( unsigned int r, unsigned int c ) {
+            return at( Index( r, c ) );
+            }
+
+        iterator begin() {
+            return iterator( this, m_values.data(), 0, ~0u, 0 );
+            }
+        const_iterator cbegin() const {
+            return const_iterator( this, m_values.data(), 0, ~0u, 0 );
+            }
+        const_iterator begin() const {
+            return cbegin();
+            }
+
+        iterator end() {
+            return iterator( this, m_values.data(), majorCount(), ~0u, count() );
+            }
+        const_iterator cend() const {
+            return const_iterator( this, m_values.data(), majorCount(), ~0u, count() );
+            }
+        const_iterator end() const {
+            return cend();
+            }
+
+        const_iterator rowBegin( unsigned int row ) const {
+            return ColumnMajor?   minorBegin( row ):   majorBegin( row );
+            }
+
+        const_iterator rowEnd( unsigned int row ) const {
+            return ColumnMajor?   cend():   majorEnd( row );
+            }
+
+        const_iterator columnBegin( unsigned int column ) const {
+            return ColumnMajor?   majorBegin( column ):   minorBegin( column );
+            }
+
+        const_iterator columnEnd( unsigned int column ) const {
+            return ColumnMajor?   majorEnd( column ):   cend();
+            }
+
+        void resizeData( const Index& size )
+            {
+            auto majorSize = majorIndex( size );
+            auto minorSize = minorIndex( size );
+            auto n = std::min<size_type>( majorCount(), majorSize );
+            size_type dst = 0;
+            for( size_type major=0; major<n; ++major ) {
+                auto b = m_pointers[major],   e = m_pointers[major+1];
+                m_pointers[major] = dst;
+                for( auto pos=b; pos<e; ++pos )
+                    if( m_indices[pos] < minorSize ) {
+                        m_indices[dst] = m_indices[pos];
+                        m_values[dst] = m_values[pos];
+                        ++dst;
+                        }
+                }
+            m_pointers[n] = dst;
+            m_pointers.resize( n+1 );
+            m_indices.resize( dst );
+            m_values.resize( dst );
+            }
+
+        void removeAt( const Index& index )
+            {
+            auto pos = find( index );
+            if( pos != npos() ) {
+                m_indices.erase( m_indices.begin() + pos );
+                m_values.erase( m_values.begin() + pos );
+                for( auto i=majorIndex( index )+1; i<m_pointers.size(); ++i )
+                    --m_pointers[i];
+                }
+            }
+
+        // Note: the storage allocated previously is not released
+        void clear()
+            {
+            m_pointers.resize( 1 );
+            m_indices.clear();
+            m_values.clear();
+            }
+
+        // Replaces the data with zero elements at the positions specified by pointers and indices
+        // (see pointers() and indices()); indices must be sorted within each row (column).
+        void setPattern( const std::vector< size_type >& pointers, const std::vector< unsigned int >& indices )
+            {
+            ASSERT( !pointers.empty()   &&   pointers.front() == 0   &&   pointers.back() == indices.size() );
+            m_pointers = pointers;
+            m_indices = indices;
+            m_values.assign( indices.size(), element_type(0) );
+            }
+
+        size_type count() const {
+            return m_values.size();
+            }
+
+        bool empty() const {
+            return m_values.empty();
+            }
+
+        const std::vector< size_type >& pointers() const {
+            return m_pointers;
+            }
+
+        const std::vector< unsigned int >& indices() const {
+            return m_indices;
+            }
+
+        std::vector< element_type >& values() {
+            return m_values;
+            }
+
+        const std::vector< element_type >& values() const {
+            return m_values;
+            }
+
+        // Computes the product of the matrix of the specified size by the vector vs,
+        // writing the result to vd.
+        template< class It1, class It2 >
+        void multiplyRight( It1 vs, It2 vd, const Index& size ) const
+            {
+            if( ColumnMajor )
+                scatterMultiply( vs, vd, size.first );
+            else
+                gatherMultiply( vs, vd, size.first );
+            }
+
+        // Computes the product of the vector vs by the matrix of the specified size,
+        // writing the result to vd.
+        template< class It1, class It2 >
+        void multiplyLeft( It1 vs, It2 vd, const Index& size ) const
+            {
+            if( ColumnMajor )
+                gatherMultiply( vs, vd, size.second );
+            else
+                scatterMultiply( vs, vd, size.second );
+            }
+
+    private:
+        std::vector< size_type > m_pointers;
+        std::vector< unsigned int > m_indices;
+        std::vector< element_type > m_values;
+
+        // vd[i] = sum of v*vs[j] over elements v with major index i and minor index j, i < n.
+        // Elements of vd are computed independently, so the work is split between threads
+        // by blocks of rows (columns) without affecting the result (see VectorKernels).
+        template< class It1, class It2 >
+        void gatherMultiply( It1 vs, It2 vd, unsigned int n ) const
+            {
+            auto p = m_pointers.data();
+            auto ind = m_indices.data();
+            auto v = m_values.data();
+            auto nmajor = std::min( n, majorCount() );
+            VectorKernels::forEachChunk( nmajor, [&]( std::size_t begin, std::size_t end ) {
+                for( auto i=begin; i<end; ++i ) {
+                    auto k = p[i],   e = p[i+1];
+                    element_type sum = element_type(0);
+                    for( ; k+4<=e; k+=4 )
+                        sum = sum + v[k]*vs[ind[k]] + v[k+1]*vs[ind[k+1]] + v[k+2]*vs[ind[k+2]] + v[k+3]*vs[ind[k+3]];
+                    for( ; k<e; ++k )
+                        sum += v[k]*vs[ind[k]];
+                    vd[i] = sum;
+                    }
+                } );
+            std::fill( vd+nmajor, vd+n, 0 );
+            }
+
+        // vd[j] = sum of v*vs[i] over elements v with major index i and minor index j, j < n
+        template< class It1, class It2 >
+        void scatterMultiply( It1 vs, It2 vd, unsigned int n ) const
+            {
+            std::fill( vd, vd+n, 0 );
+            auto p = m_pointers.data();
+            auto ind = m_indices.data();
+            auto v = m_values.data();
+            for( unsigned int i=0, nmajor=majorCount(); i<nmajor; ++i ) {
+                auto x = vs[i];
+                for( auto k=p[i], e=p[i+1]; k<e; ++k )
+                    vd[ind[k]] += v[k]*x;
+                }
+            }
+
+        static unsigned int majorIndex( const Index& index ) {
+            return ColumnMajor?   index.second:   index.first;
+            }
+
+        static unsigned int minorIndex( const Index& index ) {
+            return ColumnMajor?   index.first:   index.second;
+            }
+
+        unsigned int majorCount() const {
+            return static_cast< unsigned int >( m_pointers.size() - 1 );
+            }
+
+        size_type npos() const {
+            return m_values.size();
+            }
+
+        size_type find( const Index& index ) const
+            {
+            auto major = majorIndex( index );
+            auto minor = minorIndex( index );
+            if( major+1 >= m_pointers.size() )
+                return npos();
+            auto b = m_indices.begin() + m_pointers[major],   e = m_indices.begin() + m_pointers[major+1];
+            auto it = std::lower_bound( b, e, minor );
+            return it == e   ||   *it != minor?   npos():   it - m_indices.begin();
+            }
+
+        const_iterator majorBegin( unsigned int major ) const
+            {
+            if( major >= majorCount() )
+                return cend();
+            return const_iterator( this, m_values.data(), major, ~0u, m_pointers[major] );
+            }
+
+        const_iterator majorEnd( unsigned int major ) const
+            {
+            if( major >= majorCount() )
+                return cend();
+            return const_iterator( this, m_values.data(), major+1, ~0u, m_pointers[major+1] );
+            }
+
+        const_iterator minorBegin( unsigned int minor ) const {
+            return const_iterator( this, m_values.data(), 0, minor, 0 );
+            }
+
+        template< class That >
+        void copyFrom( const That& that, std::true_type )
+            {
+            const matrix_data_type& d = that;
+            if( this != &d ) {
+                m_pointers = d.m_pointers;
+                m_indices = d.m_indices;
+                m_values = d.m_values;
+                }
+            }
+
+        template< class That >
+        void copyFrom( const That& that, std::false_type )
+            {
+            typedef std::pair< Index, element_type > E;
+            std::vector< E > elements;
+            for( auto it=that.begin(), end=that.end(); it!=end; ++it ) {
+                auto index = it->first;
+                elements.push_back( E( Index( majorIndex( index ), minorIndex( index ) ), it->second ) );
+                }
+            auto less = []( const E& l, const E& r ) { return l.first < r.first; };
+            if( !std::is_sorted( elements.begin(), elements.end(), less ) )
+                std::sort( elements.begin(), elements.end(), less );
+            auto n = elements.empty()?   0u:   elements.back().first.first + 1;
+            m_pointers.assign( n+1, 0 );
+            m_indices.resize( elements.size() );
+            m_values.resize( elements.size() );
+            for( size_type pos=0; pos<elements.size(); ++pos ) {
+                auto& e = elements[pos];
+                ++m_pointers[e.first.first+1];
+                m_indices[pos] = e.first.second;
+                m_values[pos] = e.second;
+                }
+            for( size_type major=0; major<n; ++major )
+                m_pointers[major+1] += m_pointers[major];
+            }
+    };
+
+// Indicates whether D provides the multiplyRight() and multiplyLeft() kernels
+template< class D >
+struct HasMultiplicationKernels : std::false_type {};
+
+template< class ElementType, bool ColumnMajor >
+struct HasMultiplicationKernels< SparseMatrixCompressedData< ElementType, ColumnMajor > > : std::true_type {};
+
+template< class ElementType >
+using SparseMatrixCsrData = SparseMatrixCompressedData< ElementType, false >;
+
+template< class ElementType >
+using SparseMatrixCscData = SparseMatrixCompressedData< ElementType, true >;
+
 namespace SparseMatrixProxy {
 
 template< class D >
@@ -827,6 +1301,112 @@ template< class D > class SparseMatrixTemplate;
 template< class ElementType >
 using SparseMatrix = SparseMatrixTemplate< SparseMatrixData< ElementType > >;
 
+template< class ElementType >
+using CsrSparseMatrix = SparseMatrixTemplate< SparseMatrixCsrData< ElementType > >;
+
+template< class ElementType >
+using CscSparseMatrix = SparseMatrixTemplate< SparseMatrixCscData< ElementType > >;
+
+namespace priv {
+
+// Returns the data of m in the CSR format, using buffer if m is not in this format
+template< class ElementType >
+inline const SparseMatrixCsrData< ElementType >& csrData(
+        const SparseMatrixTemplate< SparseMatrixCsrData< ElementType > >& m,
+        SparseMatrixCsrData< ElementType >& )
+    {
+    return m;
+    }
+
+template< class ElementType, class D >
+inline const SparseMatrixCsrData< ElementType >& csrData(
+        const SparseMatrixTemplate< D >& m,
+        SparseMatrixCsrData< ElementType >& buffer )
+    {
+    buffer = m;
+    return buffer;
+    }
+
+// Symbolic stage of Gustavson's algorithm: sets the pattern of c to the pattern
+// of the product a*b, where a has the specified number of rows and b has the specified
+// number of columns.
+template< class ElementType >
+inline void productPattern(
+        SparseMatrixCsrData< ElementType >& c,
+        const SparseMatrixCsrData< ElementType >& a,
+        const SparseMatrixCsrData< ElementType >& b,
+        unsigned int rows, unsigned int columns )
+    {
+    auto& ap = a.pointers();
+    auto& ai = a.indices();
+    auto& bp = b.pointers();
+    auto& bi = b.indices();
+    std::vector< std::size_t > pointers( rows+1, 0 );
+    std::vector< unsigned int > indices;
+    indices.reserve( a.count() + b.count() );
+    std::vector< unsigned int > marker( columns, ~0u );
+    for( unsigned int r=0, ar=static_cast<unsigned int>( ap.size()-1 ); r<rows; ++r ) {
+        auto rowStart = indices.size();
+        if( r < ar ) {
+            for( auto ka=ap[r], ea=ap[r+1]; ka<ea; ++ka ) {
+                auto k = ai[ka];
+                if( k+1 >= bp.size() )
+                    continue;
+                for( auto kb=bp[k], eb=bp[k+1]; kb<eb; ++kb ) {
+                    auto col = bi[kb];
+                    if( marker[col] != r ) {
+                        marker[col] = r;
+                        indices.push_back( col );
+                        }
+                    }
+                }
+            std::sort( indices.begin() + rowStart, indices.end() );
+            }
+        pointers[r+1] = indices.size();
+        }
+    c.setPattern( pointers, indices );
+    }
+
+// Numeric stage of Gustavson's algorithm: computes the product a*b, whose pattern
+// must be contained in the pattern of c, and stores it in c; accumulator must be
+// an array of zeros of size equal to the number of columns of b, which is left zero.
+template< class ElementType >
+inline void productValues(
+        SparseMatrixCsrData< ElementType >& c,
+        const SparseMatrixCsrData< ElementType >& a,
+        const SparseMatrixCsrData< ElementType >& b,
+        ElementType *accumulator )
+    {
+    auto& ap = a.pointers();
+    auto& ai = a.indices();
+    auto& av = a.values();
+    auto& bp = b.pointers();
+    auto& bi = b.indices();
+    auto& bv = b.values();
+    auto& cp = c.pointers();
+    auto& ci = c.indices();
+    auto& cv = c.values();
+    for( std::size_t r=0, rows=cp.size()-1; r<rows; ++r ) {
+        if( r+1 < ap.size() ) {
+            for( auto ka=ap[r], ea=ap[r+1]; ka<ea; ++ka ) {
+                auto k = ai[ka];
+                if( k+1 >= bp.size() )
+                    continue;
+                auto x = av[ka];
+                for( auto kb=bp[k], eb=bp[k+1]; kb<eb; ++kb )
+                    accumulator[bi[kb]] += x*bv[kb];
+                }
+            }
+        for( auto kc=cp[r], ec=cp[r+1]; kc<ec; ++kc ) {
+            auto& acc = accumulator[ci[kc]];
+            cv[kc] = acc;
+            acc = ElementType(0);
+            }
+        }
+    }
+
+} // namespace priv
+
 template< class D >
 class SparseMatrixTemplate : public D
     {
@@ -896,7 +1476,7 @@ class SparseMatrixTemplate : public D
 
         ThisClass& makeZero()
             {
-            for( auto& v : *this )
+            for( auto&& v : *this )
                 v.second = element_type(0);
             return *this;
             }
@@ -931,23 +1511,21 @@ class SparseMatrixTemplate : public D
             return *this;
             }
 
+        // Note: the result contains all elements of the product that are nonzero structurally,
+        // including those whose values are zero
         template< class ThatD >
-        SparseMatrix<element_type> operator*( const SparseMatrixTemplate< ThatD >& that ) const
+        CsrSparseMatrix<element_type> operator*( const SparseMatrixTemplate< ThatD >& that ) const
             {
             auto thatSize = that.size();
             ASSERT( m_size.second == thatSize.first );
-            SparseMatrix<element_type> result( m_size.first, thatSize.second );
-            for( unsigned int c=0; c<thatSize.second; ++c )
-                for( unsigned int r=0; r<m_size.first; ++r ) {
-                    element_type product = 0;
-                    for( auto it=this->rowBegin(r), end=this->rowEnd(r); it!=end; ++it ) {
-                        auto r = that.checkedGet( Index( it->first.second, c ) );
-                        if( r.second )
-                            product += it->second * r.first;
-                        }
-                    if( product != 0 )
-                        result.at( r, c ) = product;
-                    }
+            SparseMatrixCsrData<element_type> abuf, bbuf;
+            auto& a = priv::csrData( *this, abuf );
+            auto& b = priv::csrData( that, bbuf );
+            CsrSparseMatrix<element_type> result;
+            priv::productPattern( result, a, b, m_size.first, thatSize.second );
+            result.resize( m_size.first, thatSize.second );
+            std::vector<element_type> accumulator( thatSize.second, element_type(0) );
+            priv::productValues( result, a, b, accumulator.data() );
             return result;
             }
 
@@ -961,16 +1539,12 @@ class SparseMatrixTemplate : public D
 
         template< class It1, class It2 >
         void mulVectRight( It1 vs, It2 vd ) const {
-            std::fill( vd, vd+m_size.first, 0 );
-            for( auto v : *this )
-                *( vd + v.first.first ) += v.second * *( vs + v.first.second );
+            mulVectRight( vs, vd, HasMultiplicationKernels< D >() );
             }
 
         template< class It1, class It2 >
         void mulVectLeft( It1 vs, It2 vd ) const {
-            std::fill( vd, vd+m_size.second, 0 );
-            for( auto v : *this )
-                *( vd + v.first.second ) += v.second * *( vs + v.first.first );
+            mulVectLeft( vs, vd, HasMultiplicationKernels< D >() );
             }
 
         SparseMatrixTemplate< SparseMatrixProxy::Block< D > > block( const Index& from, const Index& size )
@@ -1050,6 +1624,30 @@ class SparseMatrixTemplate : public D
     private:
         Index m_size;
 
+        template< class It1, class It2 >
+        void mulVectRight( It1 vs, It2 vd, std::true_type ) const {
+            this->multiplyRight( vs, vd, m_size );
+            }
+
+        template< class It1, class It2 >
+        void mulVectRight( It1 vs, It2 vd, std::false_type ) const {
+            std::fill( vd, vd+m_size.first, 0 );
+            for( auto v : *this )
+                *( vd + v.first.first ) += v.second * *( vs + v.first.second );
+            }
+
+        template< class It1, class It2 >
+        void mulVectLeft( It1 vs, It2 vd, std::true_type ) const {
+            this->multiplyLeft( vs, vd, m_size );
+            }
+
+        template< class It1, class It2 >
+        void mulVectLeft( It1 vs, It2 vd, std::false_type ) const {
+            std::fill( vd, vd+m_size.second, 0 );
+            for( auto v : *this )
+                *( vd + v.first.second ) += v.second * *( vs + v.first.first );
+            }
+
         template< class ThatD >
         ThisClass& doAssign( const SparseMatrixTemplate< ThatD >& that )
             {
@@ -1062,6 +1660,38 @@ class SparseMatrixTemplate : public D
 
 typedef SparseMatrix<double> SparseMatrixD;
 
+// Sets c to the matrix of size equal to the size of a*b, with zero elements at the positions
+// of structurally nonzero elements of a*b. Then c can be passed to product() to compute a*b,
+// possibly many times for different values of elements of a and b.
+template< class ElementType, class DA, class DB >
+inline void productPattern(
+        CsrSparseMatrix< ElementType >& c,
+        const SparseMatrixTemplate< DA >& a,
+        const SparseMatrixTemplate< DB >& b )
+    {
+    ASSERT( a.size().second == b.size().first );
+    SparseMatrixCsrData< ElementType > abuf, bbuf;
+    priv::productPattern( c, priv::csrData( a, abuf ), priv::csrData( b, bbuf ), a.size().first, b.size().second );
+    c.resize( a.size().first, b.size().second );
+    }
+
+// Computes a*b and stores it in c, whose pattern must contain the pattern of a*b (see productPattern()).
+// The pattern of c is not changed. accumulator must be a vector of zeros of size equal
+// to the number of columns of b; it is left zero. Operands not in the CSR format are converted to it.
+template< class ElementType, class DA, class DB >
+inline void product(
+        CsrSparseMatrix< ElementType >& c,
+        const SparseMatrixTemplate< DA >& a,
+        const SparseMatrixTemplate< DB >& b,
+        std::vector< ElementType >& accumulator )
+    {
+    ASSERT( a.size().second == b.size().first );
+    ASSERT( c.size() == SparseMatrixCommonTypes::Index( a.size().first, b.size().second ) );
+    ASSERT( accumulator.size() == b.size().second );
+    SparseMatrixCsrData< ElementType > abuf, bbuf;
+    priv::productValues( c, priv::csrData( a, abuf ), priv::csrData( b, bbuf ), accumulator.data() );
+    }
+
 template< class DM, class DV >
 inline VectorTemplate<typename DV::vector_data_type> operator*( const SparseMatrixTemplate<DM>& m, const VectorTemplate<DV>& v )
     {
@@ -1075,7 +1705,7 @@ template< class DM, class DV >
 inline VectorTemplate<typename DV::vector_data_type> operator*( const VectorTemplate<DV>& v, const SparseMatrixTemplate<DM>& m )
     {
     ASSERT( v.size() == m.size().first );
-    VectorTemplate<typename DV::vector_data_type> result( m.size().first );
+    VectorTemplate<typename DV::vector_data_type> result( m.size().second );
     m.mulVectLeft( v.begin(), result.begin() );
     return result;
     }
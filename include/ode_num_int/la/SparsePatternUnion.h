@@ -0,0 +1,109 @@
+// SparsePatternUnion.h
+
+#ifndef _LA_SPARSEPATTERNUNION_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LA_SPARSEPATTERNUNION_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./SparseMatrixTemplate.h"
+
+namespace ctm {
+namespace math {
+namespace sparse {
+
+// Union of the sparsity patterns of the identity matrix and two square CSR matrices a and b.
+// init() sets the pattern of the destination matrix to the union and maps each of its elements
+// to the elements of a and b at the same position. Then combine() computes linear combinations
+// of I, a, and b by a single pass over the value arrays, as long as the patterns of a and b
+// remain the same.
+template< class ElementType >
+class SparsePatternUnion
+    {
+    public:
+        typedef ElementType element_type;
+        typedef CsrSparseMatrix< element_type > Matrix;
+        typedef typename Matrix::Index Index;
+
+        void init( Matrix& dst, const Matrix& a, const Matrix& b )
+            {
+            auto n = a.size().first;
+            ASSERT( a.size() == Index( n, n )   &&   b.size() == a.size() );
+            auto& ap = a.pointers();
+            auto& ai = a.indices();
+            auto& bp = b.pointers();
+            auto& bi = b.indices();
+            m_pointers.assign( n+1, 0 );
+            m_indices.clear();
+            m_a.clear();
+            m_b.clear();
+            m_diagonal.clear();
+            for( unsigned int r=0; r<n; ++r ) {
+                std::size_t ka = r+1 < ap.size()?   ap[r]: 0,   ea = r+1 < ap.size()?   ap[r+1]: 0;
+                std::size_t kb = r+1 < bp.size()?   bp[r]: 0,   eb = r+1 < bp.size()?   bp[r+1]: 0;
+                bool diagonalDone = false;
+                while( true ) {
+                    // Next column of the union in row r
+                    auto c = ~0u;
+                    if( !diagonalDone )
+                        c = r;
+                    if( ka < ea )
+                        c = std::min( c, ai[ka] );
+                    if( kb < eb )
+                        c = std::min( c, bi[kb] );
+                    if( c == ~0u )
+                        break;
+                    m_indices.push_back( c );
+                    m_diagonal.push_back( c == r );
+                    if( c == r )
+                        diagonalDone = true;
+                    m_a.push_back( ka < ea && ai[ka] == c?   ka++:   npos() );
+                    m_b.push_back( kb < eb && bi[kb] == c?   kb++:   npos() );
+                    }
+                m_pointers[r+1] = m_indices.size();
+                }
+            dst.setPattern( m_pointers, m_indices );
+            dst.resize( n, n );
+            }
+
+        // Computes dst = d*I + alpha*a + beta*b, where dst, a, and b have the same patterns
+        // as in the last call to init().
+        void combine(
+                Matrix& dst, element_type d,
+                const Matrix& a, element_type alpha,
+                const Matrix& b, element_type beta ) const
+            {
+            auto& dv = dst.values();
+            ASSERT( dv.size() == m_a.size() );
+            auto av = a.values().data();
+            auto bv = b.values().data();
+            auto ma = m_a.data();
+            auto mb = m_b.data();
+            auto diag = m_diagonal.data();
+            auto w = dv.data();
+            VectorKernels::forEachChunk( dv.size(), [&]( std::size_t begin, std::size_t end ) {
+                for( auto k=begin; k<end; ++k ) {
+                    element_type x = diag[k]?   d:   element_type(0);
+                    if( ma[k] != npos() )
+                        x += av[ma[k]] * alpha;
+                    if( mb[k] != npos() )
+                        x += bv[mb[k]] * beta;
+                    w[k] = x;
+                    }
+                } );
+            }
+
+    private:
+        std::vector< std::size_t > m_pointers;
+        std::vector< unsigned int > m_indices;
+        std::vector< std::size_t > m_a;             // Positions of elements in a, or npos()
+        std::vector< std::size_t > m_b;             // Positions of elements in b, or npos()
+        std::vector< unsigned char > m_diagonal;    // Nonzero for diagonal elements
+
+        static std::size_t npos() {
+            return ~std::size_t(0);
+            }
+    };
+
+} // end namespace sparse
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LA_SPARSEPATTERNUNION_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
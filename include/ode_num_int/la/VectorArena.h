@@ -0,0 +1,123 @@
+// VectorArena.h
+
+#ifndef _LA_VECTORARENA_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LA_VECTORARENA_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "../defs.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+namespace ctm {
+namespace math {
+
+// Pool of 64-byte aligned memory blocks for vector data.
+// Released blocks are not returned to the heap but are cached (one free list per
+// power-of-two size class) and reused by subsequent allocations of similar size.
+// An arena is activated for the current thread by creating a Scope object;
+// while it is active, vectors using ArenaAllocator take their memory from it.
+// An arena is not thread-safe: memory allocated from it must be released in the same thread.
+class ODE_NUMINT_API VectorArena
+    {
+    public:
+        static const std::size_t Alignment = 64;
+
+        // Makes the arena current for the calling thread during the lifetime of the object;
+        // allocators created meanwhile share the ownership of the arena
+        class ODE_NUMINT_API Scope
+            {
+            public:
+                explicit Scope( const std::shared_ptr<VectorArena>& arena );
+                ~Scope();
+            private:
+                std::shared_ptr<VectorArena> m_arena;
+                const std::shared_ptr<VectorArena> *m_previous;
+                Scope( const Scope& ) = delete;
+                Scope& operator=( const Scope& ) = delete;
+            };
+
+        VectorArena();
+        ~VectorArena();
+
+        void *allocate( std::size_t bytes );
+        void deallocate( void *p, std::size_t bytes );
+
+        // Returns all cached blocks to the heap
+        void clear();
+
+        // Returns the number of blocks allocated on the heap so far
+        std::size_t heapAllocationCount() const {
+            return m_heapAllocationCount;
+            }
+
+        // Returns the arena current for the calling thread, or null if there is no one
+        static std::shared_ptr<VectorArena> current();
+
+        static void *alignedAllocate( std::size_t bytes );
+        static void alignedDeallocate( void *p );
+
+    private:
+        std::vector< std::vector<void*> > m_freeBlocks;     // Indexed by size class
+        std::size_t m_heapAllocationCount;
+
+        VectorArena( const VectorArena& ) = delete;
+        VectorArena& operator=( const VectorArena& ) = delete;
+    };
+
+// Allocator providing 64-byte aligned memory. The memory is taken from the arena that
+// has been current when the allocator was constructed, or from the heap if there was no one.
+template< class T >
+class ArenaAllocator
+    {
+    public:
+        typedef T value_type;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        ArenaAllocator() : m_arena( VectorArena::current() ) {}
+
+        template< class U >
+        ArenaAllocator( const ArenaAllocator<U>& that ) : m_arena( that.arena() ) {}
+
+        T *allocate( std::size_t n )
+            {
+            auto bytes = n*sizeof(T);
+            return static_cast<T*>( m_arena ? m_arena->allocate( bytes ) : VectorArena::alignedAllocate( bytes ) );
+            }
+
+        void deallocate( T *p, std::size_t n )
+            {
+            if( m_arena )
+                m_arena->deallocate( p, n*sizeof(T) );
+            else
+                VectorArena::alignedDeallocate( p );
+            }
+
+        // Copies of containers take memory from the arena current at the moment of copying
+        ArenaAllocator select_on_container_copy_construction() const {
+            return ArenaAllocator();
+            }
+
+        const std::shared_ptr<VectorArena>& arena() const {
+            return m_arena;
+            }
+
+    private:
+        std::shared_ptr<VectorArena> m_arena;
+    };
+
+template< class T, class U >
+inline bool operator==( const ArenaAllocator<T>& a, const ArenaAllocator<U>& b ) {
+    return a.arena() == b.arena();
+    }
+
+template< class T, class U >
+inline bool operator!=( const ArenaAllocator<T>& a, const ArenaAllocator<U>& b ) {
+    return !( a == b );
+    }
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LA_VECTORARENA_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
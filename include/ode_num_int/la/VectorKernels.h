@@ -0,0 +1,74 @@
+// VectorKernels.h
+
+#ifndef _LA_VECTORKERNELS_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LA_VECTORKERNELS_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "../defs.h"
+#include <cstddef>
+#include <functional>
+
+namespace ctm {
+namespace math {
+
+// Kernels for the basic operations on contiguous arrays of doubles.
+// The implementation (AVX-512, AVX2 or portable) is chosen at runtime, on first use,
+// according to the features supported by the CPU.
+// All implementations accumulate sums in the same order, so they produce bitwise identical results.
+// Multithreading is opt-in (see setThreadCount()). Arrays longer than ChunkSize are always
+// processed in chunks of ChunkSize elements, and the sums over chunks are added in the order
+// of chunks, so the results do not depend on the number of threads either.
+class ODE_NUMINT_API VectorKernels
+    {
+    public:
+        static const std::size_t ChunkSize = 32768;
+
+        static double dot( const double *a, const double *b, std::size_t n );
+        static double infNorm( const double *a, std::size_t n );
+        static double oneNorm( const double *a, std::size_t n );
+        static double euclideanNormSquare( const double *a, std::size_t n );
+        static void add( double *dst, const double *src, std::size_t n );       // dst += src
+        static void subtract( double *dst, const double *src, std::size_t n );  // dst -= src
+        static void scale( double *dst, double factor, std::size_t n );         // dst *= factor
+
+        // Returns the name of the implementation in use ("avx512", "avx2", or "portable")
+        static const char *implementation();
+
+        // Selects implementation by name; returns false if it is not supported by the CPU.
+        // Not thread-safe; intended for testing and benchmarking.
+        static bool setImplementation( const char *name );
+
+        // Returns the number of threads used to process large arrays (1 by default)
+        static unsigned int threadCount();
+
+        // Sets the number of threads used to process large arrays; 1 disables multithreading.
+        // Not thread-safe; should be called before the kernels are used.
+        static void setThreadCount( unsigned int threadCount );
+
+        // Returns true if arrays of size n are processed by more than one thread
+        static bool isParallel( std::size_t n ) {
+            return n >= 2*ChunkSize && threadCount() > 1;
+            }
+
+        // Calls f(begin, end) for the chunks [begin, end) of the range [0, n), in parallel
+        // if isParallel(n) is true, and f(0, n) otherwise. f must not throw exceptions.
+        template< class F >
+        static void forEachChunk( std::size_t n, F f )
+            {
+            if( isParallel( n ) )
+                parallelForEachChunk( n, std::ref( f ) );
+            else
+                f( 0, n );
+            }
+
+        // Calls f(i) for each i in [0, count) on the threads used by the kernels,
+        // or sequentially if multithreading is disabled. f must not throw exceptions.
+        static void parallelFor( std::size_t count, const std::function<void(std::size_t)>& f );
+
+    private:
+        static void parallelForEachChunk( std::size_t n, const std::function<void(std::size_t, std::size_t)>& f );
+    };
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LA_VECTORKERNELS_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
@@ -7,21 +7,27 @@
 #include <algorithm>
 #include <cmath>
 #include <sstream>
+#include <type_traits>
 
 #include "../infra/cxx_assert.h"
 #include "../infra/cxx_mock_ptr.h"
 #include "../util/m_inline.h"
+#include "VectorKernels.h"
+#include "VectorArena.h"
 
 namespace ctm {
 namespace math {
 
-template< class ElementType >
+// Vector data stored in std::vector; by default, the memory is 64-byte aligned
+// and is taken from the VectorArena current at the moment of construction (see ArenaAllocator).
+template< class ElementType, class Allocator = ArenaAllocator< ElementType > >
 class VectorData
     {
     public:
-        typedef VectorData< ElementType > vector_data_type;
+        typedef VectorData< ElementType, Allocator > vector_data_type;
         typedef ElementType value_type;
-        typedef std::vector< ElementType > Data;
+        typedef Allocator allocator_type;
+        typedef std::vector< ElementType, Allocator > Data;
         typedef typename Data::size_type size_type;
         typedef typename Data::iterator iterator;
         typedef typename Data::reference reference;
@@ -31,6 +37,12 @@ class VectorData
         VectorData() {}
         explicit VectorData( size_type size ) : m_data( size ) {}
         explicit VectorData( const Data& data ) : m_data( data ) {}
+        explicit VectorData( Data&& data ) : m_data( std::move(data) ) {}
+
+        template< class ThatAllocator >
+        explicit VectorData( const std::vector< ElementType, ThatAllocator >& data ) :
+            m_data( data.begin(), data.end() )
+            {}
 
         void swap( vector_data_type& that ) {
             std::swap( m_data, that.m_data );
@@ -88,6 +100,10 @@ class VectorData
             return m_data;
             }
 
+        const Data& data() const {
+            return m_data;
+            }
+
         template< class ThatD >
         void assign( const ThatD& that )
             {
@@ -101,6 +117,15 @@ class VectorData
 
 namespace VectorProxy {
 
+// Determines how a proxy stores its operand of type D. Vectors owning their data
+// are stored by reference; proxies are lightweight and are stored by value,
+// so that nested expressions do not refer to destroyed temporaries.
+template< class D >
+struct OperandTraits
+    {
+    typedef const D& storage_type;
+    };
+
 template< class D >
 class Block
     {
@@ -173,12 +198,175 @@ class Block
             std::copy( that.begin(), that.end(), begin() );
             }
 
+        D& source() {
+            return m_source;
+            }
+
+        const D& source() const {
+            return m_source;
+            }
+
+        size_type from() const {
+            return m_from;
+            }
+
     private:
         D& m_source;
         size_type m_from;
         size_type m_size;
     };
 
+// View of the elements of D with the specified indices: element i of the view is element
+// indices[i] of the source. Reading from the view gathers the elements, and assigning
+// to the view scatters them. The view refers to the array of indices, which must outlive it.
+template< class D >
+class Indexed
+    {
+    public:
+        typedef typename D::vector_data_type vector_data_type;
+        typedef typename D::value_type value_type;
+        typedef typename D::size_type size_type;
+        typedef typename D::reference reference;
+        typedef typename D::const_reference const_reference;
+
+        template< class EmbeddedIterator >
+        class iterator_template : public std::iterator<
+                std::forward_iterator_tag,
+                value_type,
+                std::ptrdiff_t,
+                typename std::iterator_traits< EmbeddedIterator >::pointer,
+                typename std::iterator_traits< EmbeddedIterator >::reference >
+            {
+            friend class Indexed<D>;
+            public:
+                typedef iterator_template< EmbeddedIterator > ThisClass;
+                typedef typename std::iterator_traits< EmbeddedIterator >::pointer pointer;
+                typedef typename std::iterator_traits< EmbeddedIterator >::reference reference;
+                const EmbeddedIterator& unwrap() const {
+                    return m_it;
+                    }
+                const unsigned int *index() const {
+                    return m_index;
+                    }
+                reference operator*() const {
+                    return m_it[*m_index];
+                    }
+
+                pointer operator->() const {
+                    return &m_it[*m_index];
+                    }
+
+                template< class E2 >
+                ThisClass& operator=( const iterator_template< E2 >& that ) {
+                    m_it = that.unwrap();
+                    m_index = that.index();
+                    return *this;
+                    }
+
+                template< class E2 >
+                bool operator==( const iterator_template< E2 >& that ) const {
+                    return m_index == that.index();
+                    }
+
+                template< class E2 >
+                bool operator!=( const iterator_template< E2 >& that ) const {
+                    return m_index != that.index();
+                    }
+
+                iterator_template& operator++()
+                    {
+                    ++m_index;
+                    return *this;
+                    }
+
+                template< class E2 >
+                iterator_template( const iterator_template< E2 >& that ) :
+                    m_it( that.unwrap() ),
+                    m_index( that.index() )
+                    {}
+            private:
+                EmbeddedIterator m_it;
+                const unsigned int *m_index;
+
+                iterator_template( const EmbeddedIterator& it, const unsigned int *index ) :
+                    m_it( it ), m_index( index )
+                    {
+                    }
+            };
+
+        typedef iterator_template< typename D::iterator > iterator;
+        typedef iterator_template< typename D::const_iterator > const_iterator;
+
+        Indexed( D& source, const unsigned int *indices, size_type size ) :
+            m_source( source ), m_indices( indices ), m_size( size )
+            {
+            }
+
+        reference operator[]( unsigned int index ) {
+            ASSERT( index < m_size );
+            return m_source.at( m_indices[index] );
+            }
+
+        const_reference operator[]( unsigned int index ) const {
+            ASSERT( index < m_size );
+            return m_source.at( m_indices[index] );
+            }
+
+        reference at( unsigned int index ) {
+            ASSERT( index < m_size );
+            return m_source.at( m_indices[index] );
+            }
+
+        const_reference at( unsigned int index ) const {
+            ASSERT( index < m_size );
+            return m_source.at( m_indices[index] );
+            }
+
+        iterator begin() {
+            return iterator( m_source.begin(), m_indices );
+            }
+        const_iterator cbegin() const {
+            return const_iterator( m_source.begin(), m_indices );
+            }
+        const_iterator begin() const {
+            return const_iterator( m_source.begin(), m_indices );
+            }
+
+        iterator end() {
+            return iterator( m_source.begin(), m_indices + m_size );
+            }
+        const_iterator cend() const {
+            return const_iterator( m_source.begin(), m_indices + m_size );
+            }
+        const_iterator end() const {
+            return const_iterator( m_source.begin(), m_indices + m_size );
+            }
+
+        void clear() {
+            std::fill( begin(), end(), value_type() );
+            }
+
+        size_type size() const {
+            return m_size;
+            }
+
+        template< class ThatD >
+        void assign( const ThatD& that )
+            {
+            ASSERT( size() == that.size() );
+            std::copy( that.begin(), that.end(), begin() );
+            }
+
+        const unsigned int *indices() const {
+            return m_indices;
+            }
+
+    private:
+        D& m_source;
+        const unsigned int *m_indices;
+        size_type m_size;
+    };
+
 template< class D >
 class Scale
     {
@@ -252,8 +440,9 @@ class Scale
         typedef iterator_template< typename D::const_iterator > const_iterator;
         typedef iterator_template< typename D::const_iterator > iterator;
 
-        Scale( const D& source, value_type scaleFactor ) :
-            m_source( source ), m_scaleFactor( scaleFactor )
+        template< class S >
+        Scale( S&& source, value_type scaleFactor ) :
+            m_source( std::forward<S>( source ) ), m_scaleFactor( scaleFactor )
             {}
 
         value_type operator[]( unsigned int index ) const {
@@ -285,15 +474,329 @@ class Scale
             }
 
     private:
-        const D& m_source;
+        typename OperandTraits<D>::storage_type m_source;
         value_type m_scaleFactor;
     };
 
+struct Plus {
+    template< class T >
+    static T apply( T a, T b ) {
+        return a + b;
+        }
+    };
+
+struct Minus {
+    template< class T >
+    static T apply( T a, T b ) {
+        return a - b;
+        }
+    };
+
+// Lazy memberwise binary operation; elements are computed on access,
+// so an expression like x0 + h*(a1*k1 + a2*k2) is evaluated in one loop
+// when it is assigned to a vector.
+template< class D1, class D2, class Op >
+class Binary
+    {
+    public:
+        typedef typename D1::vector_data_type vector_data_type;
+        typedef typename D1::value_type value_type;
+        typedef typename D1::size_type size_type;
+        typedef typename D1::value_type reference;
+        typedef typename D1::value_type const_reference;
+
+        template< class EmbeddedIterator1, class EmbeddedIterator2 >
+        class iterator_template : public std::iterator<
+                std::forward_iterator_tag,
+                value_type,
+                std::ptrdiff_t,
+                cxx::mock_ptr< value_type >,
+                value_type >
+            {
+            friend class Binary<D1, D2, Op>;
+            public:
+                typedef iterator_template< EmbeddedIterator1, EmbeddedIterator2 > ThisClass;
+                typedef cxx::mock_ptr< value_type > pointer;
+                const EmbeddedIterator1& unwrap() const {
+                    return m_it1;
+                    }
+                const EmbeddedIterator2& unwrap2() const {
+                    return m_it2;
+                    }
+                value_type operator*() const {
+                    return Op::apply( value_type( *m_it1 ), value_type( *m_it2 ) );
+                    }
+
+                pointer operator->() const {
+                    return pointer( operator*() );
+                    }
+
+                template< class E1, class E2 >
+                ThisClass& operator=( const iterator_template< E1, E2 >& that ) {
+                    m_it1 = that.unwrap();
+                    m_it2 = that.unwrap2();
+                    return *this;
+                    }
+
+                template< class E1, class E2 >
+                bool operator==( const iterator_template< E1, E2 >& that ) const {
+                    return m_it1 == that.unwrap();
+                    }
+
+                template< class E1, class E2 >
+                bool operator!=( const iterator_template< E1, E2 >& that ) const {
+                    return m_it1 != that.unwrap();
+                    }
+
+                iterator_template& operator++()
+                    {
+                    ++m_it1;
+                    ++m_it2;
+                    return *this;
+                    }
+
+                template< class E1, class E2 >
+                iterator_template( const iterator_template< E1, E2 >& that ) :
+                    m_it1( that.unwrap() ),
+                    m_it2( that.unwrap2() )
+                    {}
+            private:
+                EmbeddedIterator1 m_it1;
+                EmbeddedIterator2 m_it2;
+
+                iterator_template( const EmbeddedIterator1& it1, const EmbeddedIterator2& it2 ) :
+                    m_it1( it1 ), m_it2( it2 )
+                    {
+                    }
+            };
+
+        typedef iterator_template< typename D1::const_iterator, typename D2::const_iterator > const_iterator;
+        typedef const_iterator iterator;
+
+        template< class A, class B >
+        Binary( A&& a, B&& b ) :
+            m_a( std::forward<A>( a ) ), m_b( std::forward<B>( b ) )
+            {
+            ASSERT( m_a.size() == m_b.size() );
+            }
+
+        value_type operator[]( unsigned int index ) const {
+            ASSERT( index < size() );
+            return Op::apply( value_type( m_a.at( index ) ), value_type( m_b.at( index ) ) );
+            }
+
+        value_type at( unsigned int index ) const {
+            ASSERT( index < size() );
+            return Op::apply( value_type( m_a.at( index ) ), value_type( m_b.at( index ) ) );
+            }
+
+        const_iterator cbegin() const {
+            return const_iterator( m_a.begin(), m_b.begin() );
+            }
+        const_iterator begin() const {
+            return const_iterator( m_a.begin(), m_b.begin() );
+            }
+
+        const_iterator cend() const {
+            return const_iterator( m_a.end(), m_b.end() );
+            }
+        const_iterator end() const {
+            return const_iterator( m_a.end(), m_b.end() );
+            }
+
+        size_type size() const {
+            return m_a.size();
+            }
+
+    private:
+        typename OperandTraits<D1>::storage_type m_a;
+        typename OperandTraits<D2>::storage_type m_b;
+    };
+
+// Holds the data of a temporary vector used as an operand of a lazy expression,
+// so that the expression may outlive the temporary (e.g., auto e = a + f();)
+template< class D >
+class Temporary
+    {
+    public:
+        typedef typename D::vector_data_type vector_data_type;
+        typedef typename D::value_type value_type;
+        typedef typename D::size_type size_type;
+        typedef typename D::const_reference reference;
+        typedef typename D::const_reference const_reference;
+        typedef typename D::const_iterator const_iterator;
+        typedef const_iterator iterator;
+
+        explicit Temporary( D&& data ) : m_data( std::move(data) ) {}
+
+        const_reference operator[]( unsigned int index ) const {
+            return m_data.at( index );
+            }
+
+        const_reference at( unsigned int index ) const {
+            return m_data.at( index );
+            }
+
+        const_iterator cbegin() const {
+            return m_data.begin();
+            }
+        const_iterator begin() const {
+            return m_data.begin();
+            }
+
+        const_iterator cend() const {
+            return m_data.end();
+            }
+        const_iterator end() const {
+            return m_data.end();
+            }
+
+        size_type size() const {
+            return m_data.size();
+            }
+
+    private:
+        D m_data;
+    };
+
+template< class D >
+struct OperandTraits< Block<D> >
+    {
+    typedef const Block<D> storage_type;
+    };
+
+template< class D >
+struct OperandTraits< Indexed<D> >
+    {
+    typedef const Indexed<D> storage_type;
+    };
+
+// Note: expressions that may hold temporaries are stored as non-const, so that they can be moved
+
+template< class D >
+struct OperandTraits< Scale<D> >
+    {
+    typedef Scale<D> storage_type;
+    };
+
+template< class D1, class D2, class Op >
+struct OperandTraits< Binary<D1, D2, Op> >
+    {
+    typedef Binary<D1, D2, Op> storage_type;
+    };
+
+template< class D >
+struct OperandTraits< Temporary<D> >
+    {
+    typedef Temporary<D> storage_type;
+    };
+
+// Type of the operand of an expression for a temporary vector with data D: the data
+// that expressions refer to (see OperandTraits) are moved into Temporary<D>, and
+// the data stored by value anyway are moved as they are.
+template< class D, bool byReference = std::is_reference< typename OperandTraits<D>::storage_type >::value >
+struct RvalueOperand
+    {
+    typedef D type;
+    };
+
+template< class D >
+struct RvalueOperand< D, true >
+    {
+    typedef Temporary<D> type;
+    };
+
 } // namespace VectorProxy
 
+// Provides access to the elements of D stored contiguously in memory;
+// specialized for vector data types whose operations are delegated to VectorKernels.
+template< class D >
+struct ContiguousVectorData
+    {
+    static const bool value = false;
+    };
+
+template< class D >
+struct ContiguousVectorData< const D > : ContiguousVectorData< D > {};
+
+template< class Allocator >
+struct ContiguousVectorData< VectorData<double, Allocator> >
+    {
+    static const bool value = true;
+    static double *data( VectorData<double, Allocator>& d ) {
+        return d.data().data();
+        }
+    static const double *data( const VectorData<double, Allocator>& d ) {
+        return d.data().data();
+        }
+    };
+
+template< class D >
+struct ContiguousVectorData< VectorProxy::Block<D> >
+    {
+    static const bool value = ContiguousVectorData<D>::value;
+    static double *data( VectorProxy::Block<D>& d ) {
+        return ContiguousVectorData<D>::data( d.source() ) + d.from();
+        }
+    static const double *data( const VectorProxy::Block<D>& d ) {
+        return ContiguousVectorData<D>::data( d.source() ) + d.from();
+        }
+    };
+
+// Indicates that D owns its elements, so they can be moved from one vector to another
+// by the move assignment of VectorTemplate<D>; otherwise, the elements are copied.
+template< class D >
+struct OwningVectorData : std::false_type {};
+
+template< class ElementType, class Allocator >
+struct OwningVectorData< VectorData<ElementType, Allocator> > : std::true_type {};
+
+template< class D1, class D2 = D1 >
+struct UseVectorKernels : std::integral_constant< bool,
+    ContiguousVectorData<D1>::value && ContiguousVectorData<D2>::value > {};
+
 
 template< class D > class VectorTemplate;
 
+namespace VectorProxy {
+
+// Determines the type an expression stores its operand as, given the type X of the argument
+// of the expression operator, deduced from a forwarding reference; X is not a vector if there
+// is no such type. Temporary vectors are moved into the expression (see RvalueOperand).
+template< class X >
+struct ExpressionOperand {};
+
+template< class D >
+struct ExpressionOperand< VectorTemplate<D>& >
+    {
+    typedef D type;
+    static const D& get( const VectorTemplate<D>& x ) {
+        return x;
+        }
+    };
+
+template< class D >
+struct ExpressionOperand< const VectorTemplate<D>& > : ExpressionOperand< VectorTemplate<D>& > {};
+
+template< class D >
+struct ExpressionOperand< VectorTemplate<D> >
+    {
+    typedef typename RvalueOperand<D>::type type;
+    static type get( VectorTemplate<D>&& x ) {
+        return type( static_cast< D&& >( x ) );
+        }
+    };
+
+} // namespace VectorProxy
+
+// Vector data type for vectors related to VD whose size is not necessarily the same
+// (e.g., zero functions, or parts of the state vector); only differs from VD for fixed-size data.
+template< class VD >
+struct ResizableVectorData
+    {
+    typedef VD type;
+    };
+
 template< class ElementType >
 using Vector = VectorTemplate< VectorData< ElementType > >;
 
@@ -310,6 +813,8 @@ class VectorTemplate : public D
         VectorTemplate( size_type size ) : D( size ) {}
         explicit VectorTemplate( const D& data ) : D( data ) {}
         explicit VectorTemplate( D&& data ) : D( std::move(data) ) {}
+        VectorTemplate( const ThisClass& ) = default;
+        VectorTemplate( ThisClass&& that ) : D( std::move(that) ) {}
 
         template< class ThatD >
         VectorTemplate( const VectorTemplate< ThatD >& that ) : D( that.size() ) {
@@ -337,12 +842,18 @@ class VectorTemplate : public D
                 }
             }
 
+        ThisClass& operator=( ThisClass&& that )
+            {
+            if( &that != this )
+                moveAssign( that, OwningVectorData< D >() );
+            return *this;
+            }
+
         template< class ThatD >
         ThisClass& operator+=( const VectorTemplate< ThatD >& that )
             {
             ASSERT( this->size() == that.size() );
-            for( size_type i=0, n=this->size(); i<n; ++i )
-                this->at( i ) += that.at( i );
+            addAssign( that, UseVectorKernels< D, ThatD >() );
             return *this;
             }
 
@@ -350,15 +861,13 @@ class VectorTemplate : public D
         ThisClass& operator-=( const VectorTemplate< ThatD >& that )
             {
             ASSERT( this->size() == that.size() );
-            for( size_type i=0, n=this->size(); i<n; ++i )
-                this->at( i ) -= that.at( i );
+            subtractAssign( that, UseVectorKernels< D, ThatD >() );
             return *this;
             }
 
         ThisClass& operator*=( value_type that )
             {
-            for( size_type i=0, n=this->size(); i<n; ++i )
-                this->at( i ) *= that;
+            multiplyAssign( that, UseVectorKernels< D >() );
             return *this;
             }
 
@@ -366,10 +875,7 @@ class VectorTemplate : public D
         value_type dot( const VectorTemplate< ThatD >& that ) const
             {
             ASSERT( this->size() == that.size() );
-            value_type result = value_type();
-            for( size_type i=0, n=this->size(); i<n; ++i )
-                result += this->at(i) * that.at(i);
-            return result;
+            return dot( that, UseVectorKernels< D, ThatD >() );
             }
 
         VectorTemplate< VectorProxy::Block< D > > block( size_type from, size_type size )
@@ -386,58 +892,51 @@ class VectorTemplate : public D
                         VectorProxy::Block< const D >( *this, from, size ) );
             }
 
-        VectorTemplate< VectorProxy::Scale< D > > scaled( value_type scaleFactor )
+        // Note: the view refers to indices, which must outlive it
+        VectorTemplate< VectorProxy::Indexed< D > > indexed( const std::vector<unsigned int>& indices )
             {
-            return VectorTemplate< VectorProxy::Scale< D > >(
-                        VectorProxy::Scale< D >( *this, scaleFactor ) );
+            return VectorTemplate< VectorProxy::Indexed< D > >(
+                        VectorProxy::Indexed< D >( *this, indices.data(), indices.size() ) );
             }
 
-        VectorTemplate<vector_data_type> clone() const {
-            return VectorTemplate<vector_data_type>( *this );
+        VectorTemplate< VectorProxy::Indexed< const D > > indexed( const std::vector<unsigned int>& indices ) const
+            {
+            return VectorTemplate< VectorProxy::Indexed< const D > >(
+                        VectorProxy::Indexed< const D >( *this, indices.data(), indices.size() ) );
             }
 
-        value_type infNorm() const
+        // Note: the scaled vector is a lazy expression, see operator+
+        VectorTemplate< VectorProxy::Scale< D > > scaled( value_type scaleFactor ) const &
             {
-            value_type result = value_type ();
-            for( const auto& v : *this )
-                result = std::max( result, std::fabs( v ) );
-            return result;
+            return VectorTemplate< VectorProxy::Scale< D > >(
+                        VectorProxy::Scale< D >( *this, scaleFactor ) );
             }
 
-        value_type oneNorm() const
+        VectorTemplate< VectorProxy::Scale< typename VectorProxy::RvalueOperand< D >::type > > scaled( value_type scaleFactor ) &&
             {
-            value_type result = value_type ();
-            for( const auto& v : *this )
-                result += std::fabs( v );
-            return result;
+            typedef VectorProxy::ExpressionOperand< ThisClass > Operand;
+            return VectorTemplate< VectorProxy::Scale< typename Operand::type > >(
+                        VectorProxy::Scale< typename Operand::type >( Operand::get( std::move(*this) ), scaleFactor ) );
             }
 
-        value_type euclideanNormSquare() const
-            {
-            value_type result = value_type ();
-            for( const auto& v : *this )
-                result += v*v;
-            return result;
+        VectorTemplate<vector_data_type> clone() const {
+            return VectorTemplate<vector_data_type>( *this );
             }
 
-        value_type euclideanNorm() const {
-            return std::sqrt( euclideanNormSquare() );
+        value_type infNorm() const {
+            return infNorm( UseVectorKernels< D >() );
             }
 
-        template< class ThatD >
-        VectorTemplate<vector_data_type> operator+( const VectorTemplate< ThatD >& that ) const
-            {
-            auto result = clone();
-            result += that;
-            return result;
+        value_type oneNorm() const {
+            return oneNorm( UseVectorKernels< D >() );
             }
 
-        template< class ThatD >
-        VectorTemplate<vector_data_type> operator-( const VectorTemplate< ThatD >& that ) const
-            {
-            auto result = clone();
-            result -= that;
-            return result;
+        value_type euclideanNormSquare() const {
+            return euclideanNormSquare( UseVectorKernels< D >() );
+            }
+
+        value_type euclideanNorm() const {
+            return std::sqrt( euclideanNormSquare() );
             }
 
         std::string toString( unsigned int sizeHalfLimit = ~0u ) const
@@ -457,8 +956,154 @@ class VectorTemplate : public D
             s << ']';
             return s.str();
             }
+
+    private:
+        void moveAssign( ThisClass& that, std::true_type ) {
+            D::operator=( std::move(that) );
+            }
+
+        void moveAssign( ThisClass& that, std::false_type ) {
+            this->assign( that );
+            }
+
+        // Generic implementations of the operations, used unless both operands are
+        // contiguous arrays of doubles, in which case VectorKernels are called.
+        template< class ThatD >
+        void addAssign( const VectorTemplate< ThatD >& that, std::false_type )
+            {
+            auto src = that.begin();
+            for( auto dst=this->begin(), end=this->end(); dst!=end; ++dst, ++src )
+                *dst += *src;
+            }
+
+        template< class ThatD >
+        void addAssign( const VectorTemplate< ThatD >& that, std::true_type ) {
+            VectorKernels::add( ContiguousVectorData<D>::data( *this ), ContiguousVectorData<ThatD>::data( that ), this->size() );
+            }
+
+        template< class ThatD >
+        void subtractAssign( const VectorTemplate< ThatD >& that, std::false_type )
+            {
+            auto src = that.begin();
+            for( auto dst=this->begin(), end=this->end(); dst!=end; ++dst, ++src )
+                *dst -= *src;
+            }
+
+        template< class ThatD >
+        void subtractAssign( const VectorTemplate< ThatD >& that, std::true_type ) {
+            VectorKernels::subtract( ContiguousVectorData<D>::data( *this ), ContiguousVectorData<ThatD>::data( that ), this->size() );
+            }
+
+        void multiplyAssign( value_type that, std::false_type )
+            {
+            for( auto& x : *this )
+                x *= that;
+            }
+
+        void multiplyAssign( value_type that, std::true_type ) {
+            VectorKernels::scale( ContiguousVectorData<D>::data( *this ), that, this->size() );
+            }
+
+        template< class ThatD >
+        value_type dot( const VectorTemplate< ThatD >& that, std::false_type ) const
+            {
+            value_type result = value_type();
+            auto src = that.begin();
+            for( auto it=this->begin(), end=this->end(); it!=end; ++it, ++src )
+                result += *it * *src;
+            return result;
+            }
+
+        template< class ThatD >
+        value_type dot( const VectorTemplate< ThatD >& that, std::true_type ) const {
+            return VectorKernels::dot( ContiguousVectorData<D>::data( *this ), ContiguousVectorData<ThatD>::data( that ), this->size() );
+            }
+
+        value_type infNorm( std::false_type ) const
+            {
+            value_type result = value_type ();
+            for( const auto& v : *this )
+                result = std::max( result, std::fabs( v ) );
+            return result;
+            }
+
+        value_type infNorm( std::true_type ) const {
+            return VectorKernels::infNorm( ContiguousVectorData<D>::data( *this ), this->size() );
+            }
+
+        value_type oneNorm( std::false_type ) const
+            {
+            value_type result = value_type ();
+            for( const auto& v : *this )
+                result += std::fabs( v );
+            return result;
+            }
+
+        value_type oneNorm( std::true_type ) const {
+            return VectorKernels::oneNorm( ContiguousVectorData<D>::data( *this ), this->size() );
+            }
+
+        value_type euclideanNormSquare( std::false_type ) const
+            {
+            value_type result = value_type ();
+            for( const auto& v : *this )
+                result += v*v;
+            return result;
+            }
+
+        value_type euclideanNormSquare( std::true_type ) const {
+            return VectorKernels::euclideanNormSquare( ContiguousVectorData<D>::data( *this ), this->size() );
+            }
     };
 
+namespace VectorProxy {
+
+template< class Op, class X, class Y >
+inline VectorTemplate< Binary< typename ExpressionOperand<X>::type, typename ExpressionOperand<Y>::type, Op > >
+    binaryExpression( X&& x, Y&& y )
+    {
+    typedef Binary< typename ExpressionOperand<X>::type, typename ExpressionOperand<Y>::type, Op > Result;
+    ASSERT( x.size() == y.size() );
+    return VectorTemplate< Result >( Result(
+                ExpressionOperand<X>::get( std::forward<X>( x ) ),
+                ExpressionOperand<Y>::get( std::forward<Y>( y ) ) ) );
+    }
+
+} // namespace VectorProxy
+
+// Note: the sum and the difference are lazy expressions referring to the operands, except
+// temporary vectors, which are moved into the expression; assign them to a vector
+// (or call clone()) to obtain the result.
+template< class X, class Y >
+inline VectorTemplate< VectorProxy::Binary<
+        typename VectorProxy::ExpressionOperand<X>::type,
+        typename VectorProxy::ExpressionOperand<Y>::type, VectorProxy::Plus > >
+    operator+( X&& x, Y&& y )
+    {
+    return VectorProxy::binaryExpression< VectorProxy::Plus >( std::forward<X>( x ), std::forward<Y>( y ) );
+    }
+
+template< class X, class Y >
+inline VectorTemplate< VectorProxy::Binary<
+        typename VectorProxy::ExpressionOperand<X>::type,
+        typename VectorProxy::ExpressionOperand<Y>::type, VectorProxy::Minus > >
+    operator-( X&& x, Y&& y )
+    {
+    return VectorProxy::binaryExpression< VectorProxy::Minus >( std::forward<X>( x ), std::forward<Y>( y ) );
+    }
+
+template< class X >
+inline VectorTemplate< VectorProxy::Scale< typename VectorProxy::ExpressionOperand<X>::type > > operator*(
+        typename std::decay<X>::type::value_type scaleFactor, X&& x ) {
+    return std::forward<X>( x ).scaled( scaleFactor );
+    }
+
+template< class X >
+inline VectorTemplate< VectorProxy::Scale< typename VectorProxy::ExpressionOperand<X>::type > > operator*(
+        X&& x, typename std::decay<X>::type::value_type scaleFactor ) {
+    return std::forward<X>( x ).scaled( scaleFactor );
+    }
+
 template< class S, class VD >
 inline S& operator<<( S& s, const VectorTemplate<VD>& x )
     {
@@ -494,7 +1139,7 @@ inline ctm::math::VectorTemplate< typename VD1::vector_data_type > vectorMemberw
 
 template< class VD >
 ctm::math::VectorTemplate< typename VD::vector_data_type > sqr( const ctm::math::VectorTemplate<VD>& a ) {
-    return ctm::math::vectorMemberwiseUnaryOp( a, &sqr<double> );
+    return ctm::math::vectorMemberwiseUnaryOp( a, &sqr<typename VD::value_type> );
     }
 
 } // end namespace math
@@ -0,0 +1,345 @@
+// BandedLUFactorizer.h
+
+#ifndef _LU_BANDEDLUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LU_BANDEDLUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./LUFactorizerTimingStats.h"
+#include "../infra/cxx_zeroinit.h"
+#include "../infra/cxx_exception.h"
+#include "../infra/cxx_assert.h"
+#include <vector>
+#include <algorithm>
+
+namespace ctm {
+namespace math {
+
+// LU factorization of a band matrix with kl subdiagonals and ku superdiagonals, without pivoting.
+// The matrix is stored by columns in the LAPACK band layout (as in dgbtrf, but without the
+// additional kl rows needed for pivoting): element (r, c) is at position c*ldab + ku + r - c,
+// where ldab = kl + ku + 1. L and U replace the matrix.
+// Unlike LUFactorizer, there is no per-row profile: loop bounds are given by the bandwidths,
+// the factorization and the solves run over contiguous columns, and there are no tests in the
+// inner loops. This pays off for narrow bands; for wider ones, the dot products of LUFactorizer
+// are faster.
+template< class RealType >
+class BandedLUFactorizer
+    {
+    public:
+        typedef RealType real_type;
+
+        BandedLUFactorizer() : m_n( 0 ), m_kl( 0 ), m_ku( 0 ), m_factorized( false ) {}
+
+        bool empty() const {
+            return m_n == 0;
+            }
+
+        template< class Container >
+        explicit BandedLUFactorizer( const Container& matrix ) : m_n( 0 ), m_kl( 0 ), m_ku( 0 ) {
+            setMatrix( matrix );
+            }
+
+        template< class It >
+        BandedLUFactorizer( It matrixBegin, It matrixEnd ) : m_n( 0 ), m_kl( 0 ), m_ku( 0 ) {
+            setMatrix( matrixBegin, matrixEnd );
+            }
+
+        // Sets the matrix; the bandwidths are determined from its sparsity pattern
+        template< class It >
+        void setMatrix( It matrixBegin, It matrixEnd )
+            {
+            sys::ScopedTimeMeasurer tm( m_timingStats.setMatrixTiming );
+            unsigned int nr = 0,   nc = 0,   kl = 0,   ku = 0;
+            for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
+                auto r = it->first.first;
+                auto c = it->first.second;
+                nr = std::max( nr, r + 1 );
+                nc = std::max( nc, c + 1 );
+                if( r > c )
+                    kl = std::max( kl, r - c );
+                else
+                    ku = std::max( ku, c - r );
+                }
+            if( nr != nc )
+                throw cxx::exception("Invalid matrix stencil: matrix is not square");
+            m_n = nr;
+            m_kl = kl;
+            m_ku = ku;
+            m_ab.resize( static_cast<std::size_t>( m_n ) * ldab() );
+            m_rdiag.resize( m_n );
+            scatter( matrixBegin, matrixEnd );
+            }
+
+        template< class Container >
+        void setMatrix( const Container& matrix ) {
+            setMatrix( matrix.begin(), matrix.end() );
+            }
+
+        // Sets the matrix, assuming that it fits into the current band;
+        // falls back to setMatrix() if an element is outside the band.
+        template< class It >
+        void setMatrixFast( It matrixBegin, It matrixEnd )
+            {
+            if( !trySetMatrixFast( matrixBegin, matrixEnd ) )
+                setMatrix( matrixBegin, matrixEnd );
+            }
+
+        // Does the same as setMatrixFast(), but returns false instead of falling back to setMatrix()
+        // if an element is outside the current band; the matrix must then be set by setMatrix().
+        template< class It >
+        bool trySetMatrixFast( It matrixBegin, It matrixEnd )
+            {
+            sys::ScopedTimeMeasurer tm( m_timingStats.setMatrixFastTiming );
+            return scatter( matrixBegin, matrixEnd );
+            }
+
+        template< class Container >
+        void setMatrixFast( const Container& matrix ) {
+            setMatrixFast( matrix.begin(), matrix.end() );
+            }
+
+        void solve( real_type *rhs )
+            {
+            factorize();
+            sys::ScopedTimeMeasurer tm( m_timingStats.solveTiming );
+            solvePanel<1>( rhs, 0 );
+            }
+
+        // Solves the system for nrhs right-hand sides at once; column j of B starts at B + j*ldb
+        // and is replaced with the solution (see LUFactorizer::solve()).
+        void solve( real_type *B, unsigned int nrhs, unsigned int ldb )
+            {
+            factorize();
+            sys::ScopedTimeMeasurer tm( m_timingStats.solveTiming );
+            for( unsigned int j0=0; j0<nrhs; j0+=PanelWidth ) {
+                if( nrhs - j0 >= PanelWidth ) {
+                    m_x.resize( static_cast<std::size_t>( m_n ) * PanelWidth );
+                    solvePanel<PanelWidth>( B + j0*ldb, ldb );
+                    }
+                else
+                    for( unsigned int j=j0; j<nrhs; ++j )
+                        solvePanel<1>( B + j*ldb, ldb );
+                }
+            }
+
+        bool isFactorized() const {
+            return m_factorized;
+            }
+
+        unsigned int size() const {
+            return m_n;
+            }
+
+        unsigned int lowerBandwidth() const {
+            return m_kl;
+            }
+
+        unsigned int upperBandwidth() const {
+            return m_ku;
+            }
+
+        // Returns element of A, or, if the matrix is factorized, element of L*U
+        real_type elementAt( unsigned int r, unsigned int c ) const
+            {
+            ASSERT( r < m_n );
+            ASSERT( c < m_n );
+            if( !inBand( r, c ) )
+                return 0;
+            if( !m_factorized )
+                return at( r, c );
+            real_type result = r <= c?   at( r, c ):   0;
+            auto kmin = std::max( r > m_kl? r-m_kl: 0,   c > m_ku? c-m_ku: 0 );
+            auto kmax = std::min( r, c+1 );
+            for( auto k=kmin; k<kmax; ++k )
+                result += at( r, k ) * at( k, c );
+            return result;
+            }
+
+        // Implements LU update to satisfy secant condition LU*s=y, keeping the band;
+        // see LUFactorizer::secantUpdateHart().
+        void secantUpdateHart( const real_type *s, const real_type *y )
+            {
+            factorize();
+            sys::ScopedTimeMeasurer tm( m_timingStats.updateTiming );
+            auto n = m_n;
+            m_r.resize( n );
+            for( unsigned int i=0; i<n; ++i ) {
+                auto kmin = i > m_kl?   i-m_kl:   0;
+                auto kmax = std::min( n-1, i+m_ku );
+                real_type beta = y[i];
+                real_type aa = 0;
+                for( auto k=kmin; k<i; ++k ) {
+                    const auto& rk = m_r[k];
+                    beta -= at(i,k)*rk;
+                    aa += rk*rk;
+                    }
+                for( auto k=i; k<=kmax; ++k ) {
+                    const auto& sk = s[k];
+                    beta -= at(i,k)*sk;
+                    aa += sk*sk;
+                    }
+                auto& ri = m_r[i];
+                ri = 0;
+                if( beta == 0 ) {
+                    // Just compute r[i]
+                    for( auto k=i; k<=kmax; ++k )
+                        ri += at(i,k) * s[k];
+                    }
+                else {
+                    // Update L, U; compute r[i]
+                    ASSERT( aa > 0 );
+                    auto factor = beta/aa;
+                    for( auto k=kmin; k<i; ++k )
+                        at(i,k) += m_r[k] * factor;
+                    for( auto k=i; k<=kmax; ++k ) {
+                        const auto& sk = s[k];
+                        auto& Uik = at(i,k);
+                        Uik += sk*factor;
+                        ri += Uik * sk;
+                        }
+                    m_rdiag[i] = real_type(1) / at(i,i);
+                    }
+                }
+            }
+
+        typedef LUFactorizerTimingStats TimingStats;
+
+        TimingStats timingStats() const { return m_timingStats; }
+        void clearTimingStats() {
+            m_timingStats = TimingStats();
+            }
+
+    private:
+        static const unsigned int PanelWidth = 8;
+
+        unsigned int ldab() const {
+            return m_kl + m_ku + 1;
+            }
+
+        bool inBand( unsigned int r, unsigned int c ) const {
+            return r > c?   r-c <= m_kl:   c-r <= m_ku;
+            }
+
+        real_type& at( unsigned int r, unsigned int c )
+            {
+            ASSERT( inBand( r, c ) );
+            return m_ab[static_cast<std::size_t>( c )*ldab() + m_ku + r - c];
+            }
+
+        real_type at( unsigned int r, unsigned int c ) const
+            {
+            ASSERT( inBand( r, c ) );
+            return m_ab[static_cast<std::size_t>( c )*ldab() + m_ku + r - c];
+            }
+
+        // Zero-fills the band and puts the elements into it; returns false if an element is outside the band
+        template< class It >
+        bool scatter( It matrixBegin, It matrixEnd )
+            {
+            auto n = m_n;
+            std::fill( m_ab.begin(), m_ab.end(), real_type() );
+            m_factorized = false;
+            for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
+                auto r = it->first.first;
+                auto c = it->first.second;
+                if( r >= n   ||   c >= n   ||   !inBand( r, c ) )
+                    return false;
+                at( r, c ) = it->second;
+                }
+            return n > 0;
+            }
+
+        // Right-looking elimination, as in dgbtf2 (without pivoting): at step k, column k of L
+        // is computed, and the columns (k, k+ku] are updated by contiguous column operations.
+        void factorize()
+            {
+            if( m_factorized )
+                return;
+            sys::ScopedTimeMeasurer tm( m_timingStats.factorizeTiming );
+            auto n = m_n;
+            auto kl = m_kl,   ku = m_ku;
+            auto rs = ldab() - 1;
+            for( unsigned int k=0; k<n; ++k ) {
+                auto km = std::min( kl, n-1-k );
+                auto kn = std::min( ku, n-1-k );
+                auto colk = m_ab.data() + static_cast<std::size_t>( k )*(rs+1) + ku;    // colk[i] == A(k+i, k)
+                auto rpivot = m_rdiag[k] = real_type(1) / colk[0];
+                for( unsigned int i=1; i<=km; ++i )
+                    colk[i] *= rpivot;
+                for( unsigned int j=1; j<=kn; ++j ) {
+                    auto colj = colk + j*rs;    // colj[i] == A(k+i, k+j)
+                    auto u = colj[0];
+                    for( unsigned int i=1; i<=km; ++i )
+                        colj[i] -= colk[i] * u;
+                    }
+                }
+            m_factorized = true;
+            }
+
+        // Solves for W columns of B, stored in m_x row by row; L and U are traversed by columns, as in dgbtrs
+        template< unsigned int W >
+        void solvePanel( real_type *B, unsigned int ldb )
+            {
+            auto n = m_n;
+            auto kl = m_kl,   ku = m_ku;
+            auto ld = ldab();
+            auto ab = m_ab.data();
+            real_type *x;
+            if( W == 1 )
+                x = B;
+            else {
+                x = m_x.data();
+                for( unsigned int j=0; j<W; ++j )
+                    for( unsigned int i=0; i<n; ++i )
+                        x[i*W+j] = B[j*ldb+i];
+                }
+
+            // Forward iteration
+            for( unsigned int k=0; k+1<n; ++k ) {
+                auto km = std::min( kl, n-1-k );
+                auto colk = ab + static_cast<std::size_t>( k )*ld + ku;    // colk[i] == L(k+i, k)
+                auto xk = x + k*W;
+                for( unsigned int i=1; i<=km; ++i ) {
+                    auto l = colk[i];
+                    auto xi = xk + i*W;
+                    for( unsigned int j=0; j<W; ++j )
+                        xi[j] -= l * xk[j];
+                    }
+                }
+
+            // Backward iteration
+            for( unsigned int k=n-1; k!=~0u; --k ) {
+                auto km = std::min( ku, k );
+                auto colk = ab + static_cast<std::size_t>( k )*ld + ku;    // colk[-i] == U(k-i, k)
+                auto xk = x + k*W;
+                auto rd = m_rdiag[k];
+                for( unsigned int j=0; j<W; ++j )
+                    xk[j] *= rd;
+                for( unsigned int i=1; i<=km; ++i ) {
+                    auto u = colk[-static_cast<int>( i )];
+                    auto xi = xk - i*W;
+                    for( unsigned int j=0; j<W; ++j )
+                        xi[j] -= u * xk[j];
+                    }
+                }
+
+            if( W != 1 )
+                for( unsigned int j=0; j<W; ++j )
+                    for( unsigned int i=0; i<n; ++i )
+                        B[j*ldb+i] = x[i*W+j];
+            }
+
+        unsigned int m_n;
+        unsigned int m_kl;                  // Number of subdiagonals
+        unsigned int m_ku;                  // Number of superdiagonals
+        std::vector< real_type > m_ab;      // A, then L (below the diagonal, unit diagonal implied) and U, in band layout
+        std::vector< real_type > m_rdiag;   // Reciprocals of diagonal elements of U
+        std::vector< real_type > m_x;       // Right-hand sides for use in solve() with multiple right-hand sides
+        std::vector< real_type > m_r;       // r for use in secantUpdateHart()
+        cxx::bool0 m_factorized;
+        TimingStats m_timingStats;
+    };
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LU_BANDEDLUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
@@ -0,0 +1,335 @@
+// BlockLUFactorizer.h
+
+#ifndef _LU_BLOCKLUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LU_BLOCKLUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./LUFactorizerTimingStats.h"
+#include "../infra/cxx_zeroinit.h"
+#include "../infra/cxx_exception.h"
+#include "../infra/cxx_assert.h"
+#include <vector>
+#include <algorithm>
+
+namespace ctm {
+namespace math {
+
+// Block variant of the skyline LU factorization implemented by LUFactorizer.
+// The matrix is considered as consisting of dense square blocks of size BlockSize
+// (e.g., 3 or 6 for the degrees of freedom of a body in a multibody system), and the skyline
+// profile is that of the block matrix. The factorization A = L*U is computed block-wise,
+// where L has identity diagonal blocks, and diagonal blocks of U are in turn factorized
+// by the dense LU factorization (no pivoting is done, as in LUFactorizer). All operations
+// are done on small dense blocks, with loops of fixed length BlockSize.
+// Note: the size of the matrix must be a multiple of BlockSize.
+template< class RealType, unsigned int BlockSize >
+class BlockLUFactorizer
+    {
+    public:
+        typedef RealType real_type;
+        static const unsigned int B = BlockSize;
+        static const unsigned int BlockArea = BlockSize*BlockSize;
+
+        BlockLUFactorizer() : m_factorized(false) {}
+
+        bool empty() const {
+            return m_p.empty();
+            }
+
+        template< class Container >
+        explicit BlockLUFactorizer( const Container& matrix ) {
+            setMatrix( matrix );
+            }
+
+        template< class It >
+        BlockLUFactorizer( It matrixBegin, It matrixEnd ) {
+            setMatrix( matrixBegin, matrixEnd );
+            }
+
+        template< class It >
+        void setMatrix( It matrixBegin, It matrixEnd )
+            {
+            sys::ScopedTimeMeasurer tm( m_timingStats.setMatrixTiming );
+            // Determine matrix size
+            unsigned int n = 0;
+            {
+                unsigned int nr = 0,   nc = 0;
+                for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
+                    nr = std::max( nr, it->first.first + 1 );
+                    nc = std::max( nc, it->first.second + 1 );
+                    }
+                if( nr != nc )
+                    throw cxx::exception("Invalid matrix stencil: matrix is not square");
+                n = nr;
+            }
+            if( n % B != 0 )
+                throw cxx::exception("BlockLUFactorizer: matrix size must be a multiple of the block size");
+            unsigned int nb = n / B;
+
+            // Compute block profiles; diagonal blocks are always stored
+            m_p.resize( nb );
+            m_q.resize( nb );
+            m_s.resize( nb );
+            for( unsigned int i=0; i<nb; ++i )
+                m_p[i] = m_q[i] = m_s[i] = i;
+            for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
+                auto r = it->first.first / B;
+                auto c = it->first.second / B;
+                m_p[r] = std::min( m_p[r], c );
+                m_q[c] = std::min( m_q[c], r );
+                m_s[r] = std::max( m_s[r], c );
+                }
+            // Block row I of U spans all block columns K such that m_q[K] <= I
+            for( unsigned int k=0; k<nb; ++k )
+                m_s[m_q[k]] = std::max( m_s[m_q[k]], k );
+            for( unsigned int i=1; i<nb; ++i )
+                m_s[i] = std::max( m_s[i], m_s[i-1] );
+
+            // Compute address sequences for block triangular matrices m_l, m_u
+            auto initTriangularMatrix = [nb](
+                    std::vector<real_type>& m,
+                    std::vector<unsigned int>& a,
+                    const std::vector<unsigned int>& p,
+                    bool hasDiagonal ) {
+                a.resize( nb + 1 );
+                a[0] = 0;
+                unsigned int d = hasDiagonal? 1: 0;
+                for( unsigned int i=0; i<nb; ++i )
+                    a[i+1] = a[i] + ( ( i-p[i] ) + d )*BlockArea;
+                m.resize( a[nb] );
+                std::fill( m.begin(), m.end(), real_type() );
+                };
+            initTriangularMatrix( m_l, m_al, m_p, false );
+            initTriangularMatrix( m_u, m_au, m_q, true );
+
+            // Fill blocks of m_l, m_u with the contents of A
+            for( auto it=matrixBegin; it!=matrixEnd; ++it )
+                setLU( it->first.first, it->first.second, it->second );
+
+            m_factorized = false;
+            }
+
+        template< class Container >
+        void setMatrix( const Container& matrix ) {
+            setMatrix( matrix.begin(), matrix.end() );
+            }
+
+        template< class It >
+        void setMatrixFast( It matrixBegin, It matrixEnd )
+            {
+            sys::ScopedTimeMeasurer tm( m_timingStats.setMatrixFastTiming );
+            std::fill( m_l.begin(), m_l.end(), 0 );
+            std::fill( m_u.begin(), m_u.end(), 0 );
+            for( auto it=matrixBegin; it!=matrixEnd; ++it )
+                if( !setLU( it->first.first, it->first.second, it->second ) ) {
+                    // Fall back to setMatrix because the sparsity layout has changed
+                    setMatrix( matrixBegin, matrixEnd );
+                    return;
+                    }
+            m_factorized = false;
+            }
+
+        template< class Container >
+        void setMatrixFast( const Container& matrix ) {
+            setMatrixFast( matrix.begin(), matrix.end() );
+            }
+
+        void solve( real_type *rhs )
+            {
+            factorize();
+            sys::ScopedTimeMeasurer tm( m_timingStats.solveTiming );
+            unsigned int nb = m_p.size();
+
+            // Forward iteration
+            for( unsigned int i=1; i<nb; ++i ) {
+                auto x = rhs + i*B;
+                for( unsigned int k=m_p[i]; k<i; ++k )
+                    mulVectSub( x, L( i, k ), rhs + k*B );
+                }
+
+            // Backward iteration
+            for( unsigned int i=nb-1; i!=~0u; --i ) {
+                auto x = rhs + i*B;
+                for( unsigned int k=i+1; k<=m_s[i]; ++k )
+                    if( i >= m_q[k] )
+                        mulVectSub( x, U( i, k ), rhs + k*B );
+                solveDiagonal( U( i, i ), x );
+                }
+            }
+
+        bool isFactorized() const {
+            return m_factorized;
+            }
+
+        unsigned int size() const {
+            return m_p.size() * B;
+            }
+
+        typedef LUFactorizerTimingStats TimingStats;
+
+        TimingStats timingStats() const { return m_timingStats; }
+        void clearTimingStats() {
+            m_timingStats = TimingStats();
+            }
+
+    private:
+        // Returns block L(r,c) in block indices
+        real_type *L( unsigned int r, unsigned int c )
+            {
+            ASSERT( r > c );
+            ASSERT( c >= m_p[r] );
+            return m_l.data() + m_al[r] + (c-m_p[r])*BlockArea;
+            }
+
+        // Returns block U(r,c) in block indices
+        real_type *U( unsigned int r, unsigned int c )
+            {
+            ASSERT( r <= c );
+            ASSERT( r >= m_q[c] );
+            return m_u.data() + m_au[c] + (r-m_q[c])*BlockArea;
+            }
+
+        // Sets element of A at row r, column c (element indices)
+        bool setLU( unsigned int r, unsigned int c, real_type x )
+            {
+            auto br = r / B,   bc = c / B;
+            auto offset = (r%B)*B + c%B;
+            if( br > bc ) {
+                if( bc < m_p[br] )
+                    return false;
+                L( br, bc )[offset] = x;
+                }
+            else {
+                if( br < m_q[bc] )
+                    return false;
+                U( br, bc )[offset] = x;
+                }
+            return true;
+            }
+
+        unsigned int maxpq( unsigned int r, unsigned int c ) {
+            return std::max( m_p[r], m_q[c] );
+            }
+
+        // c -= a*b
+        static void mulSub( real_type *c, const real_type *a, const real_type *b )
+            {
+            for( unsigned int i=0; i<B; ++i, c+=B, a+=B )
+                for( unsigned int k=0; k<B; ++k ) {
+                    auto aik = a[k];
+                    auto bk = b + k*B;
+                    for( unsigned int j=0; j<B; ++j )
+                        c[j] -= aik * bk[j];
+                    }
+            }
+
+        // x -= a*y
+        static void mulVectSub( real_type *x, const real_type *a, const real_type *y )
+            {
+            for( unsigned int i=0; i<B; ++i, a+=B ) {
+                real_type sum = 0;
+                for( unsigned int j=0; j<B; ++j )
+                    sum += a[j] * y[j];
+                x[i] -= sum;
+                }
+            }
+
+        // Dense LU factorization of diagonal block d, in place
+        static void factorizeDiagonal( real_type *d )
+            {
+            for( unsigned int k=0; k<B; ++k ) {
+                auto dk = d + k*B;
+                for( unsigned int i=k+1; i<B; ++i ) {
+                    auto di = d + i*B;
+                    auto& l = di[k];
+                    l /= dk[k];
+                    for( unsigned int j=k+1; j<B; ++j )
+                        di[j] -= l * dk[j];
+                    }
+                }
+            }
+
+        // x = x * inverse(d), where d is a factorized diagonal block
+        static void rightSolveDiagonal( real_type *x, const real_type *d )
+            {
+            for( unsigned int i=0; i<B; ++i, x+=B ) {
+                // Upper triangular factor
+                for( unsigned int j=0; j<B; ++j ) {
+                    auto& xj = x[j];
+                    for( unsigned int k=0; k<j; ++k )
+                        xj -= x[k] * d[k*B+j];
+                    xj /= d[j*B+j];
+                    }
+                // Unit lower triangular factor
+                for( unsigned int j=B-1; j!=~0u; --j ) {
+                    auto& xj = x[j];
+                    for( unsigned int k=j+1; k<B; ++k )
+                        xj -= x[k] * d[k*B+j];
+                    }
+                }
+            }
+
+        // x = inverse(d) * x, where d is a factorized diagonal block
+        static void solveDiagonal( const real_type *d, real_type *x )
+            {
+            for( unsigned int i=1; i<B; ++i )
+                for( unsigned int k=0; k<i; ++k )
+                    x[i] -= d[i*B+k] * x[k];
+            for( unsigned int i=B-1; i!=~0u; --i ) {
+                for( unsigned int k=i+1; k<B; ++k )
+                    x[i] -= d[i*B+k] * x[k];
+                x[i] /= d[i*B+i];
+                }
+            }
+
+        void factorize()
+            {
+            if( m_factorized )
+                return;
+            sys::ScopedTimeMeasurer tm( m_timingStats.factorizeTiming );
+            m_factorized = true;
+            unsigned int nb = m_p.size();
+            for( unsigned int i=0; i<nb; ++i ) {
+                // Compute L block row
+                for( unsigned int c=m_p[i]; c<i; ++c ) {
+                    auto l = L( i, c );
+                    for( unsigned int k=maxpq( i, c ); k<c; ++k )
+                        mulSub( l, L( i, k ), U( k, c ) );
+                    rightSolveDiagonal( l, U( c, c ) );
+                    }
+
+                // Compute U block column
+                for( unsigned int r=m_q[i]; r<i; ++r ) {
+                    auto u = U( r, i );
+                    for( unsigned int k=maxpq( r, i ); k<r; ++k )
+                        mulSub( u, L( r, k ), U( k, i ) );
+                    }
+
+                // Compute and factorize diagonal block
+                auto d = U( i, i );
+                for( unsigned int k=maxpq( i, i ); k<i; ++k )
+                    mulSub( d, L( i, k ), U( k, i ) );
+                factorizeDiagonal( d );
+                }
+            }
+
+        std::vector< unsigned int > m_p;    // A(I,J) == 0 if J < m_p[I] (block indices)
+        std::vector< unsigned int > m_q;    // A(I,J) == 0 if I < m_q[J]
+        std::vector< unsigned int > m_s;    // U(I,J) == 0 if J > s[I]
+        std::vector< unsigned int > m_al;   // Address sequence for L
+        std::vector< unsigned int > m_au;   // Address sequence for U
+        std::vector< real_type > m_l;       // Blocks of L
+        std::vector< real_type > m_u;       // Blocks of U
+        cxx::bool0 m_factorized;
+        TimingStats m_timingStats;
+    };
+
+template< class RealType, unsigned int BlockSize >
+const unsigned int BlockLUFactorizer< RealType, BlockSize >::B;
+
+template< class RealType, unsigned int BlockSize >
+const unsigned int BlockLUFactorizer< RealType, BlockSize >::BlockArea;
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LU_BLOCKLUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
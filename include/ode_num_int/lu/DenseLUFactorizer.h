@@ -0,0 +1,351 @@
+// DenseLUFactorizer.h
+
+#ifndef _LU_DENSELUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LU_DENSELUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./LUFactorizerTimingStats.h"
+#include "../infra/cxx_zeroinit.h"
+#include "../infra/cxx_exception.h"
+#include "../infra/cxx_assert.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace ctm {
+namespace math {
+
+// Dense LU factorization with partial pivoting, P*A = L*U, for small matrices or matrices
+// with dense coupling, where the index overhead of LUFactorizer does not pay off.
+// The matrix is stored by rows; the factorization is right-looking and blocked by panels
+// of BlockSize columns, so that the update of the trailing matrix, which takes most of the time,
+// runs over contiguous rows of a block of U that stays in cache.
+template< class RealType >
+class DenseLUFactorizer
+    {
+    public:
+        typedef RealType real_type;
+
+        static const unsigned int BlockSize = 32;
+
+        DenseLUFactorizer() : m_n( 0 ), m_factorized( false ) {}
+
+        bool empty() const {
+            return m_n == 0;
+            }
+
+        template< class Container >
+        explicit DenseLUFactorizer( const Container& matrix ) : m_n( 0 ) {
+            setMatrix( matrix );
+            }
+
+        template< class It >
+        DenseLUFactorizer( It matrixBegin, It matrixEnd ) : m_n( 0 ) {
+            setMatrix( matrixBegin, matrixEnd );
+            }
+
+        template< class It >
+        void setMatrix( It matrixBegin, It matrixEnd )
+            {
+            sys::ScopedTimeMeasurer tm( m_timingStats.setMatrixTiming );
+            unsigned int nr = 0,   nc = 0;
+            for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
+                nr = std::max( nr, it->first.first + 1 );
+                nc = std::max( nc, it->first.second + 1 );
+                }
+            if( nr != nc )
+                throw cxx::exception("Invalid matrix stencil: matrix is not square");
+            m_n = nr;
+            m_a.resize( m_n*m_n );
+            m_perm.resize( m_n );
+            m_pinv.resize( m_n );
+            scatter( matrixBegin, matrixEnd );
+            }
+
+        template< class Container >
+        void setMatrix( const Container& matrix ) {
+            setMatrix( matrix.begin(), matrix.end() );
+            }
+
+        // Sets the matrix, assuming that its size is the same as the current one;
+        // falls back to setMatrix() if an element is outside the current matrix.
+        template< class It >
+        void setMatrixFast( It matrixBegin, It matrixEnd )
+            {
+            if( !trySetMatrixFast( matrixBegin, matrixEnd ) )
+                setMatrix( matrixBegin, matrixEnd );
+            }
+
+        // Does the same as setMatrixFast(), but returns false instead of falling back to setMatrix()
+        // if an element is outside the current matrix; the matrix must then be set by setMatrix().
+        template< class It >
+        bool trySetMatrixFast( It matrixBegin, It matrixEnd )
+            {
+            sys::ScopedTimeMeasurer tm( m_timingStats.setMatrixFastTiming );
+            return scatter( matrixBegin, matrixEnd );
+            }
+
+        template< class Container >
+        void setMatrixFast( const Container& matrix ) {
+            setMatrixFast( matrix.begin(), matrix.end() );
+            }
+
+        void solve( real_type *rhs )
+            {
+            factorize();
+            sys::ScopedTimeMeasurer tm( m_timingStats.solveTiming );
+            solvePanel<1>( rhs, 0 );
+            }
+
+        // Solves the system for nrhs right-hand sides at once; column j of B starts at B + j*ldb
+        // and is replaced with the solution (see LUFactorizer::solve()).
+        void solve( real_type *B, unsigned int nrhs, unsigned int ldb )
+            {
+            factorize();
+            sys::ScopedTimeMeasurer tm( m_timingStats.solveTiming );
+            for( unsigned int j0=0; j0<nrhs; j0+=PanelWidth ) {
+                if( nrhs - j0 >= PanelWidth )
+                    solvePanel<PanelWidth>( B + j0*ldb, ldb );
+                else
+                    for( unsigned int j=j0; j<nrhs; ++j )
+                        solvePanel<1>( B + j*ldb, ldb );
+                }
+            }
+
+        bool isFactorized() const {
+            return m_factorized;
+            }
+
+        unsigned int size() const {
+            return m_n;
+            }
+
+        // Returns the row of A that is row k of P*A
+        unsigned int pivotRow( unsigned int k ) const
+            {
+            ASSERT( k < m_n );
+            return m_factorized?   m_perm[k]:   k;
+            }
+
+        // Returns element of A, or, if the matrix is factorized, element of P^T*L*U
+        real_type elementAt( unsigned int r, unsigned int c ) const
+            {
+            ASSERT( r < m_n );
+            ASSERT( c < m_n );
+            if( !m_factorized )
+                return m_a[r*m_n + c];
+            auto i = m_pinv[r];
+            auto row = m_a.data() + i*m_n;
+            real_type result = i <= c?   row[c]:   0;
+            for( unsigned int k=0, kmax=std::min(i, c+1); k<kmax; ++k )
+                result += row[k] * m_a[k*m_n + c];
+            return result;
+            }
+
+        // Implements LU update to satisfy secant condition P^T*L*U*s=y, keeping the
+        // pattern of L and U; see LUFactorizer::secantUpdateHart().
+        void secantUpdateHart( const real_type *s, const real_type *y )
+            {
+            factorize();
+            sys::ScopedTimeMeasurer tm( m_timingStats.updateTiming );
+            auto n = m_n;
+            m_r.resize( n );
+            for( unsigned int i=0; i<n; ++i ) {
+                // Row i of P*A corresponds to row m_perm[i] of A
+                auto row = m_a.data() + i*n;
+                real_type beta = y[m_perm[i]];
+                real_type aa = 0;
+                for( unsigned int k=0; k<i; ++k ) {
+                    const auto& rk = m_r[k];
+                    beta -= row[k]*rk;
+                    aa += rk*rk;
+                    }
+                for( unsigned int k=i; k<n; ++k ) {
+                    const auto& sk = s[k];
+                    beta -= row[k]*sk;
+                    aa += sk*sk;
+                    }
+                auto& ri = m_r[i];
+                ri = 0;
+                if( beta == 0 ) {
+                    // Just compute r[i]
+                    for( unsigned int k=i; k<n; ++k )
+                        ri += row[k] * s[k];
+                    }
+                else {
+                    // Update L, U; compute r[i]
+                    ASSERT( aa > 0 );
+                    auto factor = beta/aa;
+                    for( unsigned int k=0; k<i; ++k )
+                        row[k] += m_r[k] * factor;
+                    for( unsigned int k=i; k<n; ++k ) {
+                        const auto& sk = s[k];
+                        auto& Uik = row[k];
+                        Uik += sk*factor;
+                        ri += Uik * sk;
+                        }
+                    }
+                }
+            }
+
+        typedef LUFactorizerTimingStats TimingStats;
+
+        TimingStats timingStats() const { return m_timingStats; }
+        void clearTimingStats() {
+            m_timingStats = TimingStats();
+            }
+
+    private:
+        static const unsigned int PanelWidth = 8;
+
+        // Zero-fills the matrix and puts the elements into it; returns false if an element is outside the matrix
+        template< class It >
+        bool scatter( It matrixBegin, It matrixEnd )
+            {
+            auto n = m_n;
+            std::fill( m_a.begin(), m_a.end(), real_type() );
+            m_factorized = false;
+            for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
+                auto r = it->first.first;
+                auto c = it->first.second;
+                if( r >= n   ||   c >= n )
+                    return false;
+                m_a[r*n + c] = it->second;
+                }
+            return n > 0;
+            }
+
+        void factorize()
+            {
+            if( m_factorized )
+                return;
+            sys::ScopedTimeMeasurer tm( m_timingStats.factorizeTiming );
+            auto n = m_n;
+            auto a = m_a.data();
+            for( unsigned int i=0; i<n; ++i )
+                m_perm[i] = i;
+
+            for( unsigned int k0=0; k0<n; k0+=BlockSize ) {
+                auto k1 = std::min( k0+BlockSize, n );
+
+                // Factorize the panel of columns [k0, k1)
+                for( unsigned int k=k0; k<k1; ++k ) {
+                    auto ipiv = k;
+                    auto amax = std::fabs( a[k*n+k] );
+                    for( unsigned int i=k+1; i<n; ++i ) {
+                        auto x = std::fabs( a[i*n+k] );
+                        if( amax < x ) {
+                            amax = x;
+                            ipiv = i;
+                            }
+                        }
+                    if( amax == 0 )
+                        throw cxx::exception( "DenseLUFactorizer: matrix is singular" );
+                    if( ipiv != k ) {
+                        std::swap_ranges( a+k*n, a+(k+1)*n, a+ipiv*n );
+                        std::swap( m_perm[k], m_perm[ipiv] );
+                        }
+                    auto rowk = a + k*n;
+                    auto pivot = rowk[k];
+                    for( unsigned int i=k+1; i<n; ++i ) {
+                        auto rowi = a + i*n;
+                        auto l = rowi[k] /= pivot;
+                        for( unsigned int j=k+1; j<k1; ++j )
+                            rowi[j] -= l * rowk[j];
+                        }
+                    }
+
+                if( k1 == n )
+                    break;
+
+                // Compute block row [k0, k1) of U to the right of the panel
+                for( unsigned int k=k0; k<k1; ++k ) {
+                    auto rowk = a + k*n;
+                    for( unsigned int i=k+1; i<k1; ++i ) {
+                        auto rowi = a + i*n;
+                        auto l = rowi[k];
+                        for( unsigned int j=k1; j<n; ++j )
+                            rowi[j] -= l * rowk[j];
+                        }
+                    }
+
+                // Update the trailing matrix, taking four rows of U at a time
+                for( unsigned int i=k1; i<n; ++i ) {
+                    auto rowi = a + i*n;
+                    auto k = k0;
+                    for( ; k+4<=k1; k+=4 ) {
+                        auto l0 = rowi[k],   l1 = rowi[k+1],   l2 = rowi[k+2],   l3 = rowi[k+3];
+                        auto row0 = a + k*n,   row1 = row0 + n,   row2 = row1 + n,   row3 = row2 + n;
+                        for( unsigned int j=k1; j<n; ++j )
+                            rowi[j] -= l0*row0[j] + l1*row1[j] + l2*row2[j] + l3*row3[j];
+                        }
+                    for( ; k<k1; ++k ) {
+                        auto l = rowi[k];
+                        auto rowk = a + k*n;
+                        for( unsigned int j=k1; j<n; ++j )
+                            rowi[j] -= l * rowk[j];
+                        }
+                    }
+                }
+
+            for( unsigned int i=0; i<n; ++i )
+                m_pinv[m_perm[i]] = i;
+            m_factorized = true;
+            }
+
+        // Solves for W columns of B, stored in m_x row by row
+        template< unsigned int W >
+        void solvePanel( real_type *B, unsigned int ldb )
+            {
+            auto n = m_n;
+            m_x.resize( n*W );
+            auto x = m_x.data();
+            for( unsigned int j=0; j<W; ++j )
+                for( unsigned int i=0; i<n; ++i )
+                    x[i*W+j] = B[j*ldb+m_perm[i]];
+
+            // Forward iteration
+            for( unsigned int i=1; i<n; ++i ) {
+                auto row = m_a.data() + i*n;
+                auto xi = x + i*W;
+                for( unsigned int k=0; k<i; ++k ) {
+                    auto l = row[k];
+                    auto xk = x + k*W;
+                    for( unsigned int j=0; j<W; ++j )
+                        xi[j] -= l * xk[j];
+                    }
+                }
+
+            // Backward iteration
+            for( unsigned int i=n-1; i!=~0u; --i ) {
+                auto row = m_a.data() + i*n;
+                auto xi = x + i*W;
+                for( unsigned int k=i+1; k<n; ++k ) {
+                    auto u = row[k];
+                    auto xk = x + k*W;
+                    for( unsigned int j=0; j<W; ++j )
+                        xi[j] -= u * xk[j];
+                    }
+                auto d = row[i];
+                for( unsigned int j=0; j<W; ++j )
+                    xi[j] /= d;
+                }
+
+            for( unsigned int j=0; j<W; ++j )
+                for( unsigned int i=0; i<n; ++i )
+                    B[j*ldb+i] = x[i*W+j];
+            }
+
+        unsigned int m_n;
+        std::vector< real_type > m_a;           // A, then L (below the diagonal, unit diagonal implied) and U, by rows
+        std::vector< unsigned int > m_perm;     // Row i of P*A is row m_perm[i] of A
+        std::vector< unsigned int > m_pinv;     // Inverse of m_perm
+        std::vector< real_type > m_x;           // Right-hand sides for use in solve()
+        std::vector< real_type > m_r;           // r for use in secantUpdateHart()
+        cxx::bool0 m_factorized;
+        TimingStats m_timingStats;
+    };
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LU_DENSELUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
@@ -0,0 +1,333 @@
+// GenericLUFactorizer.h
+
+#ifndef _LU_GENERICLUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LU_GENERICLUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./LUFactorizer.h"
+#include "./SparseLUFactorizer.h"
+#include "./DenseLUFactorizer.h"
+#include "./BandedLUFactorizer.h"
+#include "./MixedPrecisionLUFactorizer.h"
+#include <string>
+
+namespace ctm {
+namespace math {
+
+// Kinds of LU factorization supported by GenericLUFactorizer:
+// - SkylineLU: LUFactorizer (no pivoting; the envelope of the matrix is filled);
+// - SparseLU: SparseLUFactorizer (threshold partial pivoting; only the actual fill is stored);
+// - DenseLU: DenseLUFactorizer (partial pivoting; the whole matrix is stored);
+// - BandedLU: BandedLUFactorizer (no pivoting; the band of the matrix is filled);
+// - MixedPrecisionLU: MixedPrecisionLUFactorizer (as SkylineLU, but in single precision, with iterative refinement);
+// - AutoLU: SkylineLU, DenseLU, or BandedLU, chosen by selectLUFactorizerKind() each time the matrix is set.
+enum LUFactorizerKind { SkylineLU, SparseLU, DenseLU, BandedLU, MixedPrecisionLU, AutoLU };
+
+inline LUFactorizerKind luFactorizerKindFromString( const std::string& kind )
+    {
+    if( kind == "skyline" )
+        return SkylineLU;
+    else if( kind == "sparse" )
+        return SparseLU;
+    else if( kind == "dense" )
+        return DenseLU;
+    else if( kind == "banded" )
+        return BandedLU;
+    else if( kind == "mixed" )
+        return MixedPrecisionLU;
+    else if( kind == "auto" )
+        return AutoLU;
+    else
+        throw cxx::exception( std::string("Unknown LU factorizer kind '") + kind + "', expected 'skyline', 'sparse', 'dense', 'banded', 'mixed', or 'auto'" );
+    }
+
+inline std::string luFactorizerKindToString( LUFactorizerKind kind )
+    {
+    switch( kind ) {
+        case SparseLU:  return "sparse";
+        case DenseLU:   return "dense";
+        case BandedLU:  return "banded";
+        case MixedPrecisionLU:  return "mixed";
+        case AutoLU:    return "auto";
+        default:        return "skyline";
+        }
+    }
+
+inline std::string helpOnLUFactorizerKind() {
+    return "LU factorizer: 'skyline' (no pivoting, the envelope of the matrix is filled),\n"
+           "'sparse' (sparse LU with threshold partial pivoting, only the actual fill is stored),\n"
+           "'dense' (dense LU with partial pivoting), 'banded' (no pivoting, the band of the matrix is filled),\n"
+           "'mixed' (as 'skyline', but the factors are in single precision, and the solution is refined\n"
+           "iteratively against the original matrix), or\n"
+           "'auto' ('dense' if the envelope of the matrix is nearly full, 'banded' if it nearly fills a narrow band,\n"
+           "otherwise 'skyline')";
+    }
+
+// Chooses between SkylineLU, DenseLU, and BandedLU for the matrix given by the iterator range,
+// depending on the size of its envelope (the part of the matrix filled by LUFactorizer).
+// The dense factorization does all the work on the whole matrix, but faster, and it only
+// pays off when the envelope is nearly full. The banded factorization does the work on the band,
+// without the bookkeeping of the profile; it is chosen when the envelope nearly fills a narrow band.
+template< class It >
+inline LUFactorizerKind selectLUFactorizerKind( It matrixBegin, It matrixEnd )
+    {
+    const double MinDenseEnvelopeDensity = 0.85;
+    const double MinBandEnvelopeDensity = 0.9;
+    const unsigned int MaxBandwidth = 8;
+    unsigned int n = 0;
+    for( auto it=matrixBegin; it!=matrixEnd; ++it )
+        n = std::max( n, std::max( it->first.first, it->first.second ) + 1 );
+    if( n == 0 )
+        return SkylineLU;
+    std::vector< unsigned int > p( n ),   q( n );
+    for( unsigned int i=0; i<n; ++i )
+        p[i] = q[i] = i;
+    for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
+        auto r = it->first.first;
+        auto c = it->first.second;
+        p[r] = std::min( p[r], c );
+        q[c] = std::min( q[c], r );
+        }
+    double envelope = n;
+    unsigned int kl = 0,   ku = 0;
+    for( unsigned int i=0; i<n; ++i ) {
+        envelope += ( i - p[i] ) + ( i - q[i] );
+        kl = std::max( kl, i - p[i] );
+        ku = std::max( ku, i - q[i] );
+        }
+    if( envelope >= MinDenseEnvelopeDensity * n * n )
+        return DenseLU;
+    if( kl > MaxBandwidth   ||   ku > MaxBandwidth )
+        return SkylineLU;
+    auto band = static_cast<double>( n ) * ( kl + ku + 1 ) - 0.5*kl*( kl + 1 ) - 0.5*ku*( ku + 1 );
+    return envelope >= MinBandEnvelopeDensity * band?   BandedLU:   SkylineLU;
+    }
+
+// LU factorizer with the interface of LUFactorizer, delegating the work
+// to the factorizer of the kind chosen at run time.
+template< class RealType >
+class GenericLUFactorizer
+    {
+    public:
+        typedef RealType real_type;
+
+        explicit GenericLUFactorizer( LUFactorizerKind kind = SkylineLU ) :
+            m_kind( kind ),
+            m_activeKind( kind == AutoLU?   SkylineLU:   kind )
+            {}
+
+        // Returns the kind of factorization set by the constructor or setKind()
+        LUFactorizerKind kind() const {
+            return m_kind;
+            }
+
+        // Returns the kind of factorization actually used (differs from kind() if it is AutoLU)
+        LUFactorizerKind activeKind() const {
+            return m_activeKind;
+            }
+
+        // Sets the kind of factorization; if it is changed, the factorizer becomes empty
+        void setKind( LUFactorizerKind kind )
+            {
+            if( m_kind != kind ) {
+                m_skyline = LUFactorizer<real_type>();
+                m_sparse = SparseLUFactorizer<real_type>();
+                m_dense = DenseLUFactorizer<real_type>();
+                m_banded = BandedLUFactorizer<real_type>();
+                m_mixed = MixedPrecisionLUFactorizer<real_type>();
+                m_kind = kind;
+                m_activeKind = kind == AutoLU?   SkylineLU:   kind;
+                }
+            }
+
+        bool empty() const
+            {
+            switch( m_activeKind ) {
+                case SparseLU:  return m_sparse.empty();
+                case DenseLU:   return m_dense.empty();
+                case BandedLU:  return m_banded.empty();
+                case MixedPrecisionLU:  return m_mixed.empty();
+                default:        return m_skyline.empty();
+                }
+            }
+
+        // Sets the matrix; if the kind is AutoLU, the factorization to use is chosen for the matrix
+        template< class It >
+        void setMatrix( It matrixBegin, It matrixEnd )
+            {
+            if( m_kind == AutoLU ) {
+                auto kind = selectLUFactorizerKind( matrixBegin, matrixEnd );
+                if( kind != m_activeKind ) {
+                    switch( m_activeKind ) {
+                        case DenseLU:   m_dense = DenseLUFactorizer<real_type>();       break;
+                        case BandedLU:  m_banded = BandedLUFactorizer<real_type>();     break;
+                        default:        m_skyline = LUFactorizer<real_type>();
+                        }
+                    m_activeKind = kind;
+                    }
+                }
+            switch( m_activeKind ) {
+                case SparseLU:  m_sparse.setMatrix( matrixBegin, matrixEnd );     break;
+                case DenseLU:   m_dense.setMatrix( matrixBegin, matrixEnd );      break;
+                case BandedLU:  m_banded.setMatrix( matrixBegin, matrixEnd );     break;
+                case MixedPrecisionLU:  m_mixed.setMatrix( matrixBegin, matrixEnd );      break;
+                default:        m_skyline.setMatrix( matrixBegin, matrixEnd );
+                }
+            }
+
+        template< class Container >
+        void setMatrix( const Container& matrix ) {
+            setMatrix( matrix.begin(), matrix.end() );
+            }
+
+        // Sets the matrix, assuming that its sparsity pattern is the same as the current one.
+        // If the kind is AutoLU, the choice of the factorization is kept as long as the matrix fits into
+        // the storage of the active factorizer; otherwise, the factorization is chosen again by setMatrix(),
+        // rather than letting the active factorizer widen its storage to the new pattern.
+        template< class It >
+        void setMatrixFast( It matrixBegin, It matrixEnd )
+            {
+            if( m_kind == AutoLU ) {
+                if( empty()   ||   !trySetMatrixFast( matrixBegin, matrixEnd ) )
+                    setMatrix( matrixBegin, matrixEnd );
+                return;
+                }
+            switch( m_activeKind ) {
+                case SparseLU:  m_sparse.setMatrixFast( matrixBegin, matrixEnd );     break;
+                case DenseLU:   m_dense.setMatrixFast( matrixBegin, matrixEnd );      break;
+                case BandedLU:  m_banded.setMatrixFast( matrixBegin, matrixEnd );     break;
+                case MixedPrecisionLU:  m_mixed.setMatrixFast( matrixBegin, matrixEnd );      break;
+                default:        m_skyline.setMatrixFast( matrixBegin, matrixEnd );
+                }
+            }
+
+        template< class Container >
+        void setMatrixFast( const Container& matrix ) {
+            setMatrixFast( matrix.begin(), matrix.end() );
+            }
+
+        void solve( real_type *rhs )
+            {
+            switch( m_activeKind ) {
+                case SparseLU:  m_sparse.solve( rhs );     break;
+                case DenseLU:   m_dense.solve( rhs );      break;
+                case BandedLU:  m_banded.solve( rhs );     break;
+                case MixedPrecisionLU:  m_mixed.solve( rhs );      break;
+                default:        m_skyline.solve( rhs );
+                }
+            }
+
+        // Solves the system for nrhs right-hand sides; column j of B starts at B + j*ldb
+        void solve( real_type *B, unsigned int nrhs, unsigned int ldb )
+            {
+            switch( m_activeKind ) {
+                case SparseLU:
+                    for( unsigned int j=0; j<nrhs; ++j )
+                        m_sparse.solve( B + j*ldb );
+                    break;
+                case DenseLU:
+                    m_dense.solve( B, nrhs, ldb );
+                    break;
+                case BandedLU:
+                    m_banded.solve( B, nrhs, ldb );
+                    break;
+                case MixedPrecisionLU:
+                    m_mixed.solve( B, nrhs, ldb );
+                    break;
+                default:
+                    m_skyline.solve( B, nrhs, ldb );
+                }
+            }
+
+        bool isFactorized() const
+            {
+            switch( m_activeKind ) {
+                case SparseLU:  return m_sparse.isFactorized();
+                case DenseLU:   return m_dense.isFactorized();
+                case BandedLU:  return m_banded.isFactorized();
+                case MixedPrecisionLU:  return m_mixed.isFactorized();
+                default:        return m_skyline.isFactorized();
+                }
+            }
+
+        unsigned int size() const
+            {
+            switch( m_activeKind ) {
+                case SparseLU:  return m_sparse.size();
+                case DenseLU:   return m_dense.size();
+                case BandedLU:  return m_banded.size();
+                case MixedPrecisionLU:  return m_mixed.size();
+                default:        return m_skyline.size();
+                }
+            }
+
+        void secantUpdateHart( const real_type *s, const real_type *y )
+            {
+            switch( m_activeKind ) {
+                case SparseLU:  m_sparse.secantUpdateHart( s, y );     break;
+                case DenseLU:   m_dense.secantUpdateHart( s, y );      break;
+                case BandedLU:  m_banded.secantUpdateHart( s, y );     break;
+                case MixedPrecisionLU:  m_mixed.secantUpdateHart( s, y );      break;
+                default:        m_skyline.secantUpdateHart( s, y );
+                }
+            }
+
+        const LUFactorizer<real_type>& skylineFactorizer() const {
+            return m_skyline;
+            }
+
+        const SparseLUFactorizer<real_type>& sparseFactorizer() const {
+            return m_sparse;
+            }
+
+        const DenseLUFactorizer<real_type>& denseFactorizer() const {
+            return m_dense;
+            }
+
+        const BandedLUFactorizer<real_type>& bandedFactorizer() const {
+            return m_banded;
+            }
+
+        const MixedPrecisionLUFactorizer<real_type>& mixedPrecisionFactorizer() const {
+            return m_mixed;
+            }
+
+        typedef LUFactorizerTimingStats TimingStats;
+
+        TimingStats timingStats() const {
+            return m_skyline.timingStats() + m_sparse.timingStats() + m_dense.timingStats() + m_banded.timingStats() + m_mixed.timingStats();
+            }
+
+        void clearTimingStats()
+            {
+            m_skyline.clearTimingStats();
+            m_sparse.clearTimingStats();
+            m_dense.clearTimingStats();
+            m_banded.clearTimingStats();
+            m_mixed.clearTimingStats();
+            }
+
+    private:
+        // Sets the matrix in the factorizer chosen for AutoLU, if it fits into its storage
+        template< class It >
+        bool trySetMatrixFast( It matrixBegin, It matrixEnd )
+            {
+            switch( m_activeKind ) {
+                case DenseLU:   return m_dense.trySetMatrixFast( matrixBegin, matrixEnd );
+                case BandedLU:  return m_banded.trySetMatrixFast( matrixBegin, matrixEnd );
+                default:        return m_skyline.trySetMatrixFast( matrixBegin, matrixEnd );
+                }
+            }
+
+        LUFactorizerKind m_kind;
+        LUFactorizerKind m_activeKind;
+        LUFactorizer<real_type> m_skyline;
+        SparseLUFactorizer<real_type> m_sparse;
+        DenseLUFactorizer<real_type> m_dense;
+        BandedLUFactorizer<real_type> m_banded;
+        MixedPrecisionLUFactorizer<real_type> m_mixed;
+    };
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LU_GENERICLUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
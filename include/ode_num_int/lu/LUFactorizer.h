@@ -4,14 +4,14 @@
 #define _LU_LUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
 
 #include "./LUFactorizerTimingStats.h"
+#include "./LUFactorizerSymbolic.h"
 #include "../infra/cxx_zeroinit.h"
 #include "../infra/cxx_exception.h"
 #include "../infra/cxx_assert.h"
+#include "../la/VectorKernels.h"
 #include <vector>
 #include <algorithm>
 
-// #define CTM_MATH_LU_USE_MX_FAST_CACHE
-
 namespace ctm {
 namespace math {
 
@@ -23,7 +23,7 @@ class LUFactorizer
         LUFactorizer() : m_factorized(false) {}
 
         bool empty() const {
-            return m_p.empty();
+            return m_symbolic.empty();
             }
 
         template< class Container >
@@ -36,86 +36,19 @@ class LUFactorizer
             setMatrix( matrixBegin, matrixEnd );
             }
 
+        // Sets the matrix; the symbolic analysis is only done if the sparsity pattern differs from the current one
         template< class It >
         void setMatrix( It matrixBegin, It matrixEnd )
             {
             sys::ScopedTimeMeasurer tm( m_timingStats.setMatrixTiming );
-            // Determine matrix size
-            unsigned int n = [&, this]() -> unsigned int {
-                unsigned int nr = 0,   nc = 0;
-                for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
-                    nr = std::max( nr, it->first.first + 1 );
-                    nc = std::max( nc, it->first.second + 1 );
-                    }
-                if( nr != nc )
-                    throw cxx::exception("Invalid matrix stencil: matrix is not square");
-                return nr;
-                }();
-
-            // Allocate and initialize storage for m_p, m_q, m_s
-            auto fill = []( std::vector<unsigned int>& v, unsigned int size, unsigned int value ) {
-                v.resize( size );
-                std::fill( v.begin(), v.end(), value );
-                };
-            auto setMin = []( unsigned int& acc, unsigned int value ) {
-                if( acc > value )
-                    acc = value;
-                };
-            auto setMax = []( unsigned int& acc, unsigned int value ) {
-                if( acc < value )
-                    acc = value;
-                };
-            fill( m_p, n, n );
-            fill( m_q, n, n );
-            fill( m_s, n, 0 );
-            for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
-                auto r = it->first.first;
-                auto c = it->first.second;
-                setMin( m_p[r], c );
-                setMin( m_q[c], r );
-                setMax( m_s[r], c );
-                }
-
-            // Verify m_p and m_q
-            for( unsigned int i=0; i<n; ++i ) {
-                if( m_p[i] >= n   ||   m_q[i] >= n )
-                    throw cxx::exception("Invalid matrix stencil: the stencil is incomplete");
-                if( m_p[i] > i   ||   m_q[i] > i )
-                    throw cxx::exception("Invalid matrix stencil: the stencil does not cover the diagonal");
-                }
-
-            // Compute address sequences for triangular matrices m_l, m_u
-            auto initTriangularMatrix = [n](
-                    std::vector<real_type>& m,
-                    std::vector<unsigned int>& a,
-                    const std::vector<unsigned int>& p,
-                    bool hasDiagonal ) {
-                a.resize( n + 1 );
-                a[0] = 0;
-                unsigned int d = hasDiagonal? 1: 0;
-                for( unsigned int i=0; i<n; ++i )
-                    a[i+1] = a[i] + ( i-p[i] ) + d;
-                m.resize( a[n] );
-                std::fill( m.begin(), m.end(), real_type() );
-                };
-            initTriangularMatrix( m_l, m_al, m_p, false );
-            initTriangularMatrix( m_u, m_au, m_q, true );
-
-            // Fill matrices m_al, m_au with the contents of A
-            for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
-                auto r = it->first.first;
-                auto c = it->first.second;
-                auto value = it->second;
-                if( r <= c )
-                    U( r, c ) = value;
-                else
-                    L( r, c ) = value;
+            std::size_t count;
+            auto hash = LUFactorizerSymbolic::computePatternHash( matrixBegin, matrixEnd, count );
+            if( m_symbolic.empty()   ||   hash != m_symbolic.patternHash   ||   count != m_symbolic.count ) {
+                m_symbolic.init( matrixBegin, matrixEnd );
+                m_l.resize( m_symbolic.lSize() );
+                m_u.resize( m_symbolic.uSize() );
                 }
-
-            m_factorized = false;
-#ifdef CTM_MATH_LU_USE_MX_FAST_CACHE
-            m_mxFastCache.clear();
-#endif // CTM_MATH_LU_USE_MX_FAST_CACHE
+            scatterValues( matrixBegin, matrixEnd );
             }
 
         template< class Container >
@@ -123,30 +56,50 @@ class LUFactorizer
             setMatrix( matrix.begin(), matrix.end() );
             }
 
+        // Sets the matrix, assuming that its sparsity pattern is the same as the current one;
+        // the elements are scattered to L and U, and the pattern hash is computed on the fly.
+        // If the pattern turns out to be different, but fits into the current profile (e.g., some elements
+        // are dropped), only the scatter map is recomputed; otherwise, falls back to setMatrix().
         template< class It >
         void setMatrixFast( It matrixBegin, It matrixEnd )
+            {
+            if( !trySetMatrixFast( matrixBegin, matrixEnd ) )
+                setMatrix( matrixBegin, matrixEnd );
+            }
+
+        // Does the same as setMatrixFast(), but returns false instead of falling back to setMatrix();
+        // the matrix must then be set by setMatrix().
+        template< class It >
+        bool trySetMatrixFast( It matrixBegin, It matrixEnd )
             {
             sys::ScopedTimeMeasurer tm( m_timingStats.setMatrixFastTiming );
-            std::fill( m_l.begin(), m_l.end(), 0 );
-            std::fill( m_u.begin(), m_u.end(), 0 );
-#ifdef CTM_MATH_LU_USE_MX_FAST_CACHE
-            auto fc = mxFastCache( matrixBegin, matrixEnd );
-            for( auto it=matrixBegin; it!=matrixEnd; ++it, ++fc )
-                **fc = it->second;
-#else // CTM_MATH_LU_USE_MX_FAST_CACHE
-            auto elementsSet = 0;
-            for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
-                ++elementsSet;
-                auto r = it->first.first;
-                auto c = it->first.second;
-                if (!setLU(r, c, it->second)) {
-                    // Fall back to setMatrix because the sparsity layout has changed
-                    setMatrix(matrixBegin, matrixEnd);
-                    return;
-                    }
+            std::fill( m_l.begin(), m_l.end(), real_type() );
+            std::fill( m_u.begin(), m_u.end(), real_type() );
+            auto lsize = m_l.size();
+            auto scatter = m_symbolic.scatter.data();
+            auto count = m_symbolic.count;
+            auto hash = LUFactorizerSymbolic::initialHash();
+            std::size_t k = 0;
+            auto it = matrixBegin;
+            for( ; it!=matrixEnd; ++it, ++k ) {
+                if( k == count )
+                    break;
+                hash = LUFactorizerSymbolic::combineHash( hash, it->first.first, it->first.second );
+                auto pos = scatter[k];
+                if( pos < lsize )
+                    m_l[pos] = it->second;
+                else
+                    m_u[pos-lsize] = it->second;
+                }
+            if( m_symbolic.empty()   ||   it != matrixEnd   ||   k != count   ||   hash != m_symbolic.patternHash ) {
+                // The sparsity layout has changed
+                if( m_symbolic.empty()   ||   !m_symbolic.rescatter( matrixBegin, matrixEnd ) )
+                    return false;
+                scatterValues( matrixBegin, matrixEnd );
+                return true;
                 }
-#endif // CTM_MATH_LU_USE_MX_FAST_CACHE
             m_factorized = false;
+            return true;
             }
 
         template< class Container >
@@ -154,27 +107,53 @@ class LUFactorizer
             setMatrixFast( matrix.begin(), matrix.end() );
             }
 
+        // Returns the symbolic analysis of the current sparsity pattern
+        const LUFactorizerSymbolic& symbolic() const {
+            return m_symbolic;
+            }
+
+        // Solves the system; if multithreading is enabled in VectorKernels, the substitutions are
+        // done level by level (see LUFactorizerSymbolic), with results identical to the serial ones.
         void solve( real_type *rhs )
             {
             factorize();
             sys::ScopedTimeMeasurer tm( m_timingStats.solveTiming );
-            unsigned int n = m_p.size();
+            unsigned int n = m_symbolic.p.size();
+            if( VectorKernels::threadCount() > 1 ) {
+                runLevels( m_symbolic.forwardLevels,
+                           [this]( unsigned int i ) { return i - m_symbolic.p[i]; },
+                           [this, rhs]( unsigned int i ) { forwardStep( rhs, i ); } );
+                runLevels( m_symbolic.backwardLevels,
+                           [this]( unsigned int i ) { return m_symbolic.uRowPointers[i+1] - m_symbolic.uRowPointers[i]; },
+                           [this, rhs]( unsigned int i ) { backwardStep( rhs, i ); } );
+                return;
+                }
 
             // Forward iteration
-            for( unsigned int i=1; i<n; ++i ) {
-                auto& x = rhs[i];
-                auto adr_L_i_0 = L_column_0_address( i );
-                for( unsigned int k=m_p[i]; k<i; ++k )
-                    x -= adr_L_i_0[k] * rhs[k];
-                }
+            for( unsigned int i=1; i<n; ++i )
+                forwardStep( rhs, i );
 
             // Backward iteration
-            for( unsigned int i=n-1; i!=~0; --i ) {
-                auto& x = rhs[i];
-                for( unsigned int k=i+1; k<=m_s[i]; ++k )
-                    if( i >= m_q[k] )
-                        x -= U(i,k) * rhs[k];
-                x /= U(i,i);
+            for( unsigned int i=n-1; i!=~0; --i )
+                backwardStep( rhs, i );
+            }
+
+        // Solves the system for nrhs right-hand sides at once; column j of B starts at B + j*ldb
+        // and is replaced with the solution. Columns are processed in panels of PanelWidth,
+        // so that L and U are traversed once per panel; each column undergoes the same operations
+        // as it would in solve( real_type *rhs ).
+        void solve( real_type *B, unsigned int nrhs, unsigned int ldb )
+            {
+            factorize();
+            sys::ScopedTimeMeasurer tm( m_timingStats.solveTiming );
+            unsigned int n = m_symbolic.p.size();
+            m_panel.resize( n * PanelWidth );
+            for( unsigned int j0=0; j0<nrhs; j0+=PanelWidth ) {
+                if( nrhs - j0 >= PanelWidth )
+                    solvePanel<PanelWidth>( B + j0*ldb, ldb );
+                else
+                    for( unsigned int j=j0; j<nrhs; ++j )
+                        solvePanel<1>( B + j*ldb, ldb );
                 }
             }
 
@@ -183,17 +162,17 @@ class LUFactorizer
             }
 
         unsigned int size() const {
-            return m_p.size();
+            return m_symbolic.p.size();
             }
 
         real_type elementAt( unsigned int r, unsigned int c ) const
             {
-            ASSERT( r < m_p.size() );
-            ASSERT( c < m_p.size() );
+            ASSERT( r < m_symbolic.p.size() );
+            ASSERT( c < m_symbolic.p.size() );
             if( m_factorized ) {
-                if( r > c && c >= m_p[r]   ||   r <= c && r >= m_q[c] ) {
+                if( r > c && c >= m_symbolic.p[r]   ||   r <= c && r >= m_symbolic.q[c] ) {
                     real_type result = 0;
-                    auto kmin = std::max(m_p[r], m_q[c]);
+                    auto kmin = std::max(m_symbolic.p[r], m_symbolic.q[c]);
                     auto kmax = std::min(r, c);
                     for (auto k=kmin; k<=kmax; ++k )
                         result += safeL(r,k)*U(k,c);
@@ -202,12 +181,12 @@ class LUFactorizer
                 }
             else {
                 if( r > c ) {
-                    if( c >= m_p[r] )
-                        return m_l[m_al[r] + (c-m_p[r])];
+                    if( c >= m_symbolic.p[r] )
+                        return m_l[m_symbolic.al[r] + (c-m_symbolic.p[r])];
                     }
                 else {
-                    if( r >= m_q[c] )
-                        return m_u[m_au[c] + (r-m_q[c])];
+                    if( r >= m_symbolic.q[c] )
+                        return m_u[m_symbolic.au[c] + (r-m_symbolic.q[c])];
                     }
                 }
             return 0;
@@ -215,20 +194,20 @@ class LUFactorizer
 
         unsigned int firstCol( unsigned int r ) const
             {
-            ASSERT( r < m_p.size() );
-            return m_p[r];
+            ASSERT( r < m_symbolic.p.size() );
+            return m_symbolic.p[r];
             }
 
         unsigned int firstRow( unsigned int c ) const
             {
-            ASSERT( c < m_q.size() );
-            return m_q[c];
+            ASSERT( c < m_symbolic.q.size() );
+            return m_symbolic.q[c];
             }
 
         unsigned int lastCol( unsigned int r ) const
             {
-            ASSERT( r < m_s.size() );
-            return m_s[r];
+            ASSERT( r < m_symbolic.s.size() );
+            return m_symbolic.s[r];
             }
 
         // Implements LU update to satisfy secant condition LU*s=y (e.g. for quasi-Newton method).
@@ -243,19 +222,19 @@ class LUFactorizer
             {
             factorize();
             sys::ScopedTimeMeasurer tm( m_timingStats.updateTiming );
-            unsigned int n = m_p.size();
+            unsigned int n = m_symbolic.p.size();
             m_r.resize( n );
             for( unsigned int i=0; i<n; ++i ) {
                 real_type beta = y[i];
                 real_type aa = 0;
-                for( unsigned int k=m_p[i]; k<i; ++k ) {
+                for( unsigned int k=m_symbolic.p[i]; k<i; ++k ) {
                     const auto& rk = m_r[k];
                     beta -= L(i,k)*rk;
                     aa += rk*rk;
                     }
-                auto umaxcol = m_s[i];
+                auto umaxcol = m_symbolic.s[i];
                 for( unsigned int k=i; k<=umaxcol; ++k )
-                    if( i >= m_q[k] ) {
+                    if( i >= m_symbolic.q[k] ) {
                         const auto& sk = s[k];
                         beta -= U(i,k)*sk;
                         aa += sk*sk;
@@ -265,17 +244,17 @@ class LUFactorizer
                 if( beta == 0 ) {
                     // Just compute r[i]
                     for( unsigned int k=i; k<=umaxcol; ++k )
-                        if( i >= m_q[k] )
+                        if( i >= m_symbolic.q[k] )
                             ri += U(i,k) * s[k];
                     }
                 else {
                     // Update L, U; compute r[i]
                     ASSERT( aa > 0 );
                     auto factor = beta/aa;
-                    for( unsigned int k=m_p[i]; k<i; ++k )
+                    for( unsigned int k=m_symbolic.p[i]; k<i; ++k )
                         L(i,k) += m_r[k] * factor;
                     for( unsigned int k=i; k<=umaxcol; ++k )
-                        if( i >= m_q[k] ) {
+                        if( i >= m_symbolic.q[k] ) {
                             const auto& sk = s[k];
                             auto& Uik = U(i,k);
                             Uik += sk*factor;
@@ -289,17 +268,17 @@ class LUFactorizer
             {
             factorize();
             sys::ScopedTimeMeasurer tm( m_timingStats.updateTiming );
-            unsigned int n = m_p.size();
+            unsigned int n = m_symbolic.p.size();
             m_r.resize( n );
             for( unsigned int i=0; i<n; ++i ) {
                 real_type beta = y[i];
                 real_type cl = 0;
-                for( unsigned int k=m_p[i]; k<i; ++k )
+                for( unsigned int k=m_symbolic.p[i]; k<i; ++k )
                     cl += L(i,k)*m_r[k];
-                auto umaxcol = m_s[i];
+                auto umaxcol = m_symbolic.s[i];
                 real_type cu = 0;
                 for( unsigned int k=i; k<=umaxcol; ++k )
-                    if( i >= m_q[k] )
+                    if( i >= m_symbolic.q[k] )
                         cu += U(i,k)*s[k];
                 real_type c = cl + cu;
                 if( beta == 0 )
@@ -318,12 +297,12 @@ class LUFactorizer
                         factor = Threshold;
                         */
                     factor += 1;
-                    for( unsigned int k=m_p[i]; k<i; ++k )
+                    for( unsigned int k=m_symbolic.p[i]; k<i; ++k )
                         L(i,k) *= factor;
                     auto& ri = m_r[i];
                     ri = 0;
                     for( unsigned int k=i; k<=umaxcol; ++k )
-                        if( i >= m_q[k] ) {
+                        if( i >= m_symbolic.q[k] ) {
                             auto& Uik = U(i,k);
                             Uik *= factor;
                             ri += Uik * s[k];
@@ -340,27 +319,35 @@ class LUFactorizer
             }
 
     private:
-        real_type& L( unsigned int r, unsigned int c )
+        // Zero-fills L and U and puts the elements into them, using the scatter map of the current analysis
+        template< class It >
+        void scatterValues( It matrixBegin, It matrixEnd )
             {
-            ASSERT( r > c );
-            ASSERT( c >= m_p[r] );
-            return m_l[m_al[r] + (c-m_p[r])];
+            std::fill( m_l.begin(), m_l.end(), real_type() );
+            std::fill( m_u.begin(), m_u.end(), real_type() );
+            auto lsize = m_l.size();
+            auto scatter = m_symbolic.scatter.data();
+            for( auto it=matrixBegin; it!=matrixEnd; ++it, ++scatter ) {
+                auto pos = *scatter;
+                if( pos < lsize )
+                    m_l[pos] = it->second;
+                else
+                    m_u[pos-lsize] = it->second;
+                }
+            m_factorized = false;
             }
 
-        bool setL( unsigned int r, unsigned int c, double x )
+        real_type& L( unsigned int r, unsigned int c )
             {
-            if (r > c && c >= m_p[r]) {
-                m_l[m_al[r] + (c-m_p[r])] = x;
-                return true;
-                }
-            else
-                return false;
+            ASSERT( r > c );
+            ASSERT( c >= m_symbolic.p[r] );
+            return m_l[m_symbolic.al[r] + (c-m_symbolic.p[r])];
             }
 
         // Don't dereference the pointer returned, element at column 0 will most likely be outside the sparsity pattern!
         real_type *L_column_0_address( unsigned int r )
             {
-                return m_l.data() + m_al[r] - m_p[r];
+                return m_l.data() + m_symbolic.al[r] - m_symbolic.p[r];
             }
 
         real_type safeL( unsigned int r, unsigned int c ) const {
@@ -370,38 +357,24 @@ class LUFactorizer
         real_type& U( unsigned int r, unsigned int c )
             {
             ASSERT( r <= c );
-            ASSERT( r >= m_q[c] );
-            return m_u[m_au[c] + (r-m_q[c])];
-            }
-
-        bool setU( unsigned int r, unsigned int c, double x )
-            {
-            if (r <= c && r >= m_q[c]) {
-                m_u[m_au[c] + (r-m_q[c])] = x;
-                return true;
-                }
-            else
-                return false;
+            ASSERT( r >= m_symbolic.q[c] );
+            return m_u[m_symbolic.au[c] + (r-m_symbolic.q[c])];
             }
 
         // Don't dereference the pointer returned, element at row 0 will most likely be outside the sparsity pattern!
         real_type *U_row_0_address( unsigned int c ) {
-            return m_u.data() + m_au[c] - m_q[c];
+            return m_u.data() + m_symbolic.au[c] - m_symbolic.q[c];
             }
 
         real_type U( unsigned int r, unsigned int c ) const
             {
             ASSERT( r <= c );
-            ASSERT( r >= m_q[c] );
-            return m_u[m_au[c] + (r-m_q[c])];
-            }
-
-        bool setLU( unsigned int r, unsigned int c, double x ) {
-            return c < r? setL(r, c, x): setU(r, c, x);
+            ASSERT( r >= m_symbolic.q[c] );
+            return m_u[m_symbolic.au[c] + (r-m_symbolic.q[c])];
             }
 
         unsigned int maxpq( unsigned int r, unsigned int c ) {
-            return std::max( m_p[r], m_q[c] );
+            return std::max( m_symbolic.p[r], m_symbolic.q[c] );
             }
 
         void factorize()
@@ -410,63 +383,147 @@ class LUFactorizer
                 return;
             sys::ScopedTimeMeasurer tm( m_timingStats.factorizeTiming );
             m_factorized = true;
-            unsigned int n = m_p.size();
-            for( unsigned int i=0; i<n; ++i ) {
-                // Compute L row
+            unsigned int n = m_symbolic.p.size();
+            if( VectorKernels::threadCount() > 1 )
+                runLevels( m_symbolic.factorizeLevels,
+                           [this]( unsigned int i ) {
+                               std::size_t w = i - std::min( m_symbolic.p[i], m_symbolic.q[i] ) + 1;
+                               return w*w;
+                               },
+                           [this]( unsigned int i ) { factorizeStep( i ); } );
+            else
+                for( unsigned int i=0; i<n; ++i )
+                    factorizeStep( i );
+            }
+
+        // Computes row i of L and column i of U
+        void factorizeStep( unsigned int i )
+            {
+            // Compute L row
+            auto adr_L_i_0 = L_column_0_address( i );
+            for( unsigned int c=m_symbolic.p[i]; c<i; ++c ) {
+                auto& l = adr_L_i_0[c];
+                auto k = maxpq( i, c );
+                auto prow = adr_L_i_0 + k;
+                auto pcol = &U( k, c );
+                for( ; k<c; ++k, ++prow, ++pcol )
+                    l -= *prow * *pcol; //  l -= L(i,k) * U(k,c);
+                l /= *pcol; // l /= U(c,c);
+                }
+
+            // Compute U column
+            auto adr_U_0_i = U_row_0_address( i );
+            for( unsigned int r=m_symbolic.q[i]; r<i; ++r ) {
+                auto& u = adr_U_0_i[r];
+                auto k = maxpq( r, i );
+                auto prow = L_column_0_address( r ) + k;
+                auto pcol = adr_U_0_i + k;
+                for( ; k<r; ++k, ++prow, ++pcol )
+                    u -= *prow * *pcol; //  u -= L(r,k) * U(k,i);
+                }
+
+            // Compute diagonal element
+            auto& d = adr_U_0_i[i]; // == U(i, i);
+            for( unsigned int k=maxpq(i,i); k<i; ++k )
+                d -= adr_L_i_0[k] * adr_U_0_i[k]; // d -= safeL(i,k) * U(k,i);
+            }
+
+        void forwardStep( real_type *rhs, unsigned int i )
+            {
+            auto& x = rhs[i];
+            auto adr_L_i_0 = L_column_0_address( i );
+            for( unsigned int k=m_symbolic.p[i]; k<i; ++k )
+                x -= adr_L_i_0[k] * rhs[k];
+            }
+
+        void backwardStep( real_type *rhs, unsigned int i )
+            {
+            auto& x = rhs[i];
+            auto& c = m_symbolic.uRowColumns;
+            for( auto kk=m_symbolic.uRowPointers[i], kend=m_symbolic.uRowPointers[i+1]; kk<kend; ++kk ) {
+                auto k = c[kk];
+                x -= U(i,k) * rhs[k];
+                }
+            x /= U(i,i);
+            }
+
+        static const unsigned int PanelWidth = 8;
+
+        // Solves for W columns of B, stored in m_panel row by row to make the innermost loops
+        // run over contiguous right-hand sides
+        template< unsigned int W >
+        void solvePanel( real_type *B, unsigned int ldb )
+            {
+            unsigned int n = m_symbolic.p.size();
+            auto x = m_panel.data();
+            for( unsigned int j=0; j<W; ++j )
+                for( unsigned int i=0; i<n; ++i )
+                    x[i*W+j] = B[j*ldb+i];
+
+            // Forward iteration
+            for( unsigned int i=1; i<n; ++i ) {
+                auto xi = x + i*W;
                 auto adr_L_i_0 = L_column_0_address( i );
-                for( unsigned int c=m_p[i]; c<i; ++c ) {
-                    auto& l = adr_L_i_0[c];
-                    auto k = maxpq( i, c );
-                    auto prow = adr_L_i_0 + k;
-                    auto pcol = &U( k, c );
-                    for( ; k<c; ++k, ++prow, ++pcol )
-                        l -= *prow * *pcol; //  l -= L(i,k) * U(k,c);
-                    l /= *pcol; // l /= U(c,c);
+                for( unsigned int k=m_symbolic.p[i]; k<i; ++k ) {
+                    auto l = adr_L_i_0[k];
+                    auto xk = x + k*W;
+                    for( unsigned int j=0; j<W; ++j )
+                        xi[j] -= l * xk[j];
                     }
+                }
 
-                // Compute U column
-                auto adr_U_0_i = U_row_0_address( i );
-                for( unsigned int r=m_q[i]; r<i; ++r ) {
-                    auto& u = adr_U_0_i[r];
-                    auto k = maxpq( r, i );
-                    auto prow = L_column_0_address( r ) + k;
-                    auto pcol = adr_U_0_i + k;
-                    for( ; k<r; ++k, ++prow, ++pcol )
-                        u -= *prow * *pcol; //  u -= L(r,k) * U(k,i);
+            // Backward iteration
+            for( unsigned int i=n-1; i!=~0u; --i ) {
+                auto xi = x + i*W;
+                auto& c = m_symbolic.uRowColumns;
+                for( auto kk=m_symbolic.uRowPointers[i], kend=m_symbolic.uRowPointers[i+1]; kk<kend; ++kk ) {
+                    auto k = c[kk];
+                    auto u = U(i,k);
+                    auto xk = x + k*W;
+                    for( unsigned int j=0; j<W; ++j )
+                        xi[j] -= u * xk[j];
                     }
+                auto d = U(i,i);
+                for( unsigned int j=0; j<W; ++j )
+                    xi[j] /= d;
+                }
+
+            for( unsigned int j=0; j<W; ++j )
+                for( unsigned int i=0; i<n; ++i )
+                    B[j*ldb+i] = x[i*W+j];
+            }
+
+        // Minimum estimated number of operations in a level that makes it worth running in parallel
+        static const std::size_t ParallelLevelWork = 1 << 15;
 
-                // Compute diagonal element
-                auto& d = adr_U_0_i[i]; // == U(i, i);
-                for( unsigned int k=maxpq(i,i); k<i; ++k )
-                    d -= adr_L_i_0[k] * adr_U_0_i[k]; // d -= safeL(i,k) * U(k,i);
+        // Runs step(i) for all rows of the schedule, level by level; the rows of a level
+        // are run in parallel if the level is large enough, as estimated by work(i).
+        template< class Work, class Step >
+        static void runLevels( const LUFactorizerSymbolic::LevelSchedule& levels, Work work, Step step )
+            {
+            auto rows = levels.rows.data();
+            for( unsigned int l=0, nl=levels.levelCount(); l<nl; ++l ) {
+                auto begin = levels.pointers[l];
+                auto end = levels.pointers[l+1];
+                std::size_t levelWork = 0;
+                for( auto j=begin; j<end && levelWork<ParallelLevelWork; ++j )
+                    levelWork += work( rows[j] ) + 1;
+                if( end - begin > 1   &&   levelWork >= ParallelLevelWork )
+                    VectorKernels::parallelFor( end - begin, [&]( std::size_t j ) { step( rows[begin+j] ); } );
+                else
+                    for( auto j=begin; j<end; ++j )
+                        step( rows[j] );
                 }
             }
 
-        std::vector< unsigned int > m_p;    // A(i,j) == 0 if j < m_p[i]
-        std::vector< unsigned int > m_q;    // A(i,j) == 0 if i < m_q[j]
-        std::vector< unsigned int > m_s;    // U(i,j) == 0 if j > s[i]
-        std::vector< unsigned int > m_al;   // Address sequence for L
-        std::vector< unsigned int > m_au;   // Address sequence for U
+        LUFactorizerSymbolic m_symbolic;
         std::vector< real_type > m_l;       // L
         std::vector< real_type > m_u;       // U
         std::vector< real_type > m_r;       // r for use in secantUpdateHart()
+        std::vector< real_type > m_panel;   // Right-hand sides for use in solve() with multiple right-hand sides
         cxx::bool0 m_factorized;
         TimingStats m_timingStats;
 
-#ifdef CTM_MATH_LU_USE_MX_FAST_CACHE
-        std::vector< real_type* > m_mxFastCache;    // Index = ordinal number of element in sparse matrix, value = destination address in L or U
-        template< class It >
-        real_type* const* mxFastCache( It matrixBegin, It matrixEnd )
-            {
-            if( m_mxFastCache.empty() )
-                for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
-                    auto r = it->first.first;
-                    auto c = it->first.second;
-                    m_mxFastCache.push_back( c < r ?   &L(r, c) :   &U(r, c) );
-                    }
-            return m_mxFastCache.data();
-            }
-#endif // CTM_MATH_LU_USE_MX_FAST_CACHE
     };
 
 } // end namespace math
@@ -0,0 +1,285 @@
+// LUFactorizerSymbolic.h
+
+#ifndef _LU_LUFACTORIZERSYMBOLIC_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LU_LUFACTORIZERSYMBOLIC_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "../infra/cxx_exception.h"
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+namespace ctm {
+namespace math {
+
+// Result of the symbolic analysis of the sparsity pattern of a matrix, done by LUFactorizer:
+// the skyline profile, the address sequences of L and U, and the scatter map giving the position
+// of each element of the matrix (in the order of iteration) in the storage of L and U.
+// The analysis is identified by the hash of the pattern, so a matrix with the same pattern is
+// put into L and U by a pure scatter, and a change of the pattern is detected by comparing hashes;
+// a pattern that still fits into the profile only needs a new scatter map (see rescatter()).
+struct LUFactorizerSymbolic
+    {
+    typedef std::uint64_t Hash;
+
+    // Rows grouped by levels of a dependency graph: rows[pointers[l]..pointers[l+1]) form level l,
+    // and each of them only depends on rows of lower levels. Rows of a level are sorted.
+    struct LevelSchedule
+        {
+        std::vector< unsigned int > pointers;
+        std::vector< unsigned int > rows;
+
+        unsigned int levelCount() const {
+            return pointers.empty()?   0:   static_cast<unsigned int>( pointers.size() - 1 );
+            }
+
+        // Computes the schedule given the dependencies of each row i on the contiguous range
+        // of rows [begin(i), end(i)); rows are visited in the order of ascending (or descending,
+        // if the dependencies follow the row) indices.
+        template< class Begin, class End >
+        void init( unsigned int n, bool ascending, Begin begin, End end )
+            {
+            init( n, ascending, [&]( const std::vector< unsigned int >& level, unsigned int i ) {
+                unsigned int l = 0;
+                for( unsigned int k=begin( i ), kend=end( i ); k<kend; ++k )
+                    l = std::max( l, level[k] + 1 );
+                return l;
+                } );
+            }
+
+        // Computes the schedule given the dependencies of each row i on the rows
+        // deps[depPointers[i]..depPointers[i+1]); rows are visited as above.
+        void init( unsigned int n, bool ascending,
+                   const std::vector< unsigned int >& depPointers, const std::vector< unsigned int >& deps )
+            {
+            init( n, ascending, [&]( const std::vector< unsigned int >& level, unsigned int i ) {
+                unsigned int l = 0;
+                for( auto k=depPointers[i], kend=depPointers[i+1]; k<kend; ++k )
+                    l = std::max( l, level[deps[k]] + 1 );
+                return l;
+                } );
+            }
+
+    private:
+        // rowLevel(level, i) returns the level of row i, given the levels of the rows it depends on
+        template< class RowLevel >
+        void init( unsigned int n, bool ascending, RowLevel rowLevel )
+            {
+            std::vector< unsigned int > level( n, 0 );
+            unsigned int levelCount = 0;
+            for( unsigned int j=0; j<n; ++j ) {
+                auto i = ascending? j: n-1-j;
+                auto l = rowLevel( level, i );
+                level[i] = l;
+                levelCount = std::max( levelCount, l + 1 );
+                }
+            pointers.assign( levelCount + 1, 0 );
+            for( unsigned int i=0; i<n; ++i )
+                ++pointers[level[i]+1];
+            for( unsigned int l=0; l<levelCount; ++l )
+                pointers[l+1] += pointers[l];
+            rows.resize( n );
+            std::vector< unsigned int > next( pointers.begin(), pointers.end()-1 );
+            for( unsigned int i=0; i<n; ++i )
+                rows[next[level[i]]++] = i;
+            }
+        };
+
+    std::vector< unsigned int > p;          // A(i,j) == 0 if j < p[i]
+    std::vector< unsigned int > q;          // A(i,j) == 0 if i < q[j]
+    std::vector< unsigned int > s;          // U(i,j) == 0 if j > s[i]
+    std::vector< unsigned int > al;         // Address sequence for L
+    std::vector< unsigned int > au;         // Address sequence for U
+    std::vector< unsigned int > uRowPointers;   // Columns of off-diagonal elements of row i of U, ascending,
+    std::vector< unsigned int > uRowColumns;    // are uRowColumns[uRowPointers[i]..uRowPointers[i+1])
+    std::vector< unsigned int > scatter;    // Positions of elements in L, or in U, offset by the size of L
+    Hash patternHash;
+    std::size_t count;                      // Number of elements in the pattern
+
+    // Level schedules of the factorization, and of the forward and backward substitutions
+    LevelSchedule factorizeLevels;
+    LevelSchedule forwardLevels;
+    LevelSchedule backwardLevels;
+
+    LUFactorizerSymbolic() : patternHash( initialHash() ), count( 0 ) {}
+
+    unsigned int size() const {
+        return p.size();
+        }
+
+    bool empty() const {
+        return p.empty();
+        }
+
+    unsigned int lSize() const {
+        return al.empty()?   0:   al.back();
+        }
+
+    unsigned int uSize() const {
+        return au.empty()?   0:   au.back();
+        }
+
+    static Hash initialHash() {
+        return 0xcbf29ce484222325ull;
+        }
+
+    static Hash combineHash( Hash hash, unsigned int r, unsigned int c )
+        {
+        Hash x = ( static_cast<Hash>( r ) << 32 ) ^ c;
+        x = ( x ^ ( x >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+        x = ( x ^ ( x >> 27 ) ) * 0x94d049bb133111ebull;
+        x ^= x >> 31;
+        return ( hash ^ x ) * 0x100000001b3ull;
+        }
+
+    // Computes the hash of the pattern of the matrix given by the iterator range; also returns the number of elements
+    template< class It >
+    static Hash computePatternHash( It matrixBegin, It matrixEnd, std::size_t& count )
+        {
+        auto hash = initialHash();
+        count = 0;
+        for( auto it=matrixBegin; it!=matrixEnd; ++it, ++count )
+            hash = combineHash( hash, it->first.first, it->first.second );
+        return hash;
+        }
+
+    template< class It >
+    void init( It matrixBegin, It matrixEnd )
+        {
+        // Determine matrix size
+        unsigned int n = [&]() -> unsigned int {
+            unsigned int nr = 0,   nc = 0;
+            for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
+                nr = std::max( nr, it->first.first + 1 );
+                nc = std::max( nc, it->first.second + 1 );
+                }
+            if( nr != nc )
+                throw cxx::exception("Invalid matrix stencil: matrix is not square");
+            return nr;
+            }();
+
+        // Allocate and initialize storage for p, q, s
+        auto fill = []( std::vector<unsigned int>& v, unsigned int size, unsigned int value ) {
+            v.resize( size );
+            std::fill( v.begin(), v.end(), value );
+            };
+        auto setMin = []( unsigned int& acc, unsigned int value ) {
+            if( acc > value )
+                acc = value;
+            };
+        auto setMax = []( unsigned int& acc, unsigned int value ) {
+            if( acc < value )
+                acc = value;
+            };
+        fill( p, n, n );
+        fill( q, n, n );
+        fill( s, n, 0 );
+        for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
+            auto r = it->first.first;
+            auto c = it->first.second;
+            setMin( p[r], c );
+            setMin( q[c], r );
+            setMax( s[r], c );
+            }
+
+        // Verify p and q
+        for( unsigned int i=0; i<n; ++i ) {
+            if( p[i] >= n   ||   q[i] >= n )
+                throw cxx::exception("Invalid matrix stencil: the stencil is incomplete");
+            if( p[i] > i   ||   q[i] > i )
+                throw cxx::exception("Invalid matrix stencil: the stencil does not cover the diagonal");
+            }
+
+        // Row i of U spans all columns k such that q[k] <= i, which may go beyond
+        // the last element of row i of A
+        for( unsigned int k=0; k<n; ++k )
+            setMax( s[q[k]], k );
+        for( unsigned int i=1; i<n; ++i )
+            setMax( s[i], s[i-1] );
+
+        // Compute address sequences for triangular matrices L, U
+        auto initAddresses = [n]( std::vector<unsigned int>& a, const std::vector<unsigned int>& p, bool hasDiagonal ) {
+            a.resize( n + 1 );
+            a[0] = 0;
+            unsigned int d = hasDiagonal? 1: 0;
+            for( unsigned int i=0; i<n; ++i )
+                a[i+1] = a[i] + ( i-p[i] ) + d;
+            };
+        initAddresses( al, p, false );
+        initAddresses( au, q, true );
+
+        // Index the off-diagonal elements of U by rows: column k spans rows [q[k], k)
+        uRowPointers.assign( n + 1, 0 );
+        for( unsigned int k=0; k<n; ++k )
+            for( unsigned int i=q[k]; i<k; ++i )
+                ++uRowPointers[i+1];
+        for( unsigned int i=0; i<n; ++i )
+            uRowPointers[i+1] += uRowPointers[i];
+        uRowColumns.resize( uRowPointers[n] );
+        {
+            std::vector< unsigned int > next( uRowPointers.begin(), uRowPointers.end()-1 );
+            for( unsigned int k=0; k<n; ++k )
+                for( unsigned int i=q[k]; i<k; ++i )
+                    uRowColumns[next[i]++] = k;
+        }
+
+        // Compute level schedules. Step i of the factorization computes row i of L and column i of U,
+        // using columns of U and rows of L computed at steps [min(p[i], q[i]), i); step i of the forward
+        // substitution depends on steps [p[i], i); step i of the backward substitution depends on the steps
+        // given by the columns of row i of U.
+        factorizeLevels.init( n, true,
+                              [this]( unsigned int i ) { return std::min( p[i], q[i] ); },
+                              []( unsigned int i ) { return i; } );
+        forwardLevels.init( n, true,
+                            [this]( unsigned int i ) { return p[i]; },
+                            []( unsigned int i ) { return i; } );
+        backwardLevels.init( n, false, uRowPointers, uRowColumns );
+
+        // Compute the scatter map and the pattern hash
+        auto lsize = lSize();
+        scatter.clear();
+        patternHash = initialHash();
+        for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
+            auto r = it->first.first;
+            auto c = it->first.second;
+            scatter.push_back( r > c?   al[r] + (c-p[r]):   lsize + au[c] + (r-q[c]) );
+            patternHash = combineHash( patternHash, r, c );
+            }
+        count = scatter.size();
+        }
+
+    // Recomputes the scatter map and the pattern hash for a matrix whose pattern differs from the analyzed one,
+    // but lies within the current profile (e.g., when some elements are dropped); the profile, the address
+    // sequences, and the level schedules are kept. Returns false if an element is outside the profile, or
+    // the matrix size is different; the analysis is then left empty, and must be redone by init().
+    template< class It >
+    bool rescatter( It matrixBegin, It matrixEnd )
+        {
+        auto n = size();
+        auto lsize = lSize();
+        unsigned int last = 0;
+        scatter.clear();
+        patternHash = initialHash();
+        for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
+            auto r = it->first.first;
+            auto c = it->first.second;
+            if( r >= n   ||   c >= n   ||   ( r > c?   c < p[r]:   r < q[c] ) ) {
+                p.clear();
+                return false;
+                }
+            last = std::max( last, std::max( r, c ) );
+            scatter.push_back( r > c?   al[r] + (c-p[r]):   lsize + au[c] + (r-q[c]) );
+            patternHash = combineHash( patternHash, r, c );
+            }
+        if( last+1 != n ) {
+            p.clear();
+            return false;
+            }
+        count = scatter.size();
+        return true;
+        }
+    };
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LU_LUFACTORIZERSYMBOLIC_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
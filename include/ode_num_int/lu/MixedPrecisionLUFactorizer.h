@@ -0,0 +1,285 @@
+// MixedPrecisionLUFactorizer.h
+
+#ifndef _LU_MIXEDPRECISIONLUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LU_MIXEDPRECISIONLUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./LUFactorizer.h"
+#include <cmath>
+#include <limits>
+
+namespace ctm {
+namespace math {
+
+// Skyline LU factorization (see LUFactorizer) done in single precision, with the solution
+// improved by iterative refinement: the residual of the system is computed in RealType,
+// using a copy of the original matrix, and the correction is found with the single precision factors.
+// L and U take half the memory of the ones of LUFactorizer<double>; the triangular solves are done
+// in single precision as well. Refinement stops once the residual is at the level of the rounding
+// errors of RealType, which takes more steps as the condition number of the matrix grows, and fails
+// when the condition number approaches the inverse of the single precision epsilon (about 1e7);
+// refinementConverged() tells whether the last solution has reached the full accuracy.
+// After secantUpdateHart(), the factors no longer correspond to the original matrix,
+// so there is no refinement until the matrix is set again.
+template< class RealType >
+class MixedPrecisionLUFactorizer
+    {
+    public:
+        typedef RealType real_type;
+        typedef float factor_type;
+
+        static const unsigned int DefaultRefinementSteps = 10;
+
+        MixedPrecisionLUFactorizer() :
+            m_normA( 0 ),
+            m_refinementSteps( DefaultRefinementSteps ),
+            m_refine( false ),
+            m_lastRefinementSteps( 0 ),
+            m_refinementConverged( false )
+            {}
+
+        bool empty() const {
+            return m_lu.empty();
+            }
+
+        template< class Container >
+        explicit MixedPrecisionLUFactorizer( const Container& matrix ) : MixedPrecisionLUFactorizer() {
+            setMatrix( matrix );
+            }
+
+        template< class It >
+        MixedPrecisionLUFactorizer( It matrixBegin, It matrixEnd ) : MixedPrecisionLUFactorizer() {
+            setMatrix( matrixBegin, matrixEnd );
+            }
+
+        // Maximal number of refinement steps in solve()
+        unsigned int refinementSteps() const {
+            return m_refinementSteps;
+            }
+
+        void setRefinementSteps( unsigned int refinementSteps ) {
+            m_refinementSteps = refinementSteps;
+            }
+
+        // Returns the number of refinement steps done in the last call of solve()
+        unsigned int lastRefinementSteps() const {
+            return m_lastRefinementSteps;
+            }
+
+        // Returns true if refinement in the last call of solve() has reduced the residual
+        // to the level of the rounding errors of RealType
+        bool refinementConverged() const {
+            return m_refinementConverged;
+            }
+
+        template< class It >
+        void setMatrix( It matrixBegin, It matrixEnd )
+            {
+            copyMatrix( matrixBegin, matrixEnd );
+            m_lu.setMatrix( m_factorEntries );
+            }
+
+        template< class Container >
+        void setMatrix( const Container& matrix ) {
+            setMatrix( matrix.begin(), matrix.end() );
+            }
+
+        template< class It >
+        void setMatrixFast( It matrixBegin, It matrixEnd )
+            {
+            copyMatrix( matrixBegin, matrixEnd );
+            m_lu.setMatrixFast( m_factorEntries );
+            }
+
+        template< class Container >
+        void setMatrixFast( const Container& matrix ) {
+            setMatrixFast( matrix.begin(), matrix.end() );
+            }
+
+        void solve( real_type *rhs )
+            {
+            auto n = m_lu.size();
+            m_x.resize( n );
+            m_r.resize( n );
+
+            // Initial solution
+            for( unsigned int i=0; i<n; ++i )
+                m_x[i] = static_cast<factor_type>( rhs[i] );
+            m_lu.solve( m_x.data() );
+            m_lastRefinementSteps = 0;
+            m_refinementConverged = false;
+            if( !m_refine ) {
+                std::copy( m_x.begin(), m_x.end(), rhs );
+                return;
+                }
+            sys::ScopedTimeMeasurer tm( m_refinementTiming );
+            m_b.assign( rhs, rhs+n );
+            std::copy( m_x.begin(), m_x.end(), rhs );
+
+            // The residual is small enough if |r| <= sqrt(n)*eps*|A|*|x| (in the max norm)
+            auto tol = std::sqrt( static_cast<real_type>( n ) ) * std::numeric_limits<real_type>::epsilon() * m_normA;
+            real_type rmaxPrev = 0;
+            for( unsigned int step=0; ; ++step ) {
+                // Residual r = b - A*x
+                real_type rmax = 0,   xmax = 0;
+                for( unsigned int i=0; i<n; ++i ) {
+                    auto r = m_b[i];
+                    for( auto k=m_rowPtr[i], kend=m_rowPtr[i+1]; k<kend; ++k )
+                        r -= m_values[k] * rhs[m_cols[k]];
+                    m_r[i] = r;
+                    rmax = std::max( rmax, std::fabs( r ) );
+                    xmax = std::max( xmax, std::fabs( rhs[i] ) );
+                    }
+                if( rmax <= tol * xmax ) {
+                    m_refinementConverged = true;
+                    break;
+                    }
+                // Stop if the residual is not reduced any more, returning the previous solution
+                // (the one before the last correction), or if the steps are exhausted
+                if( step > 0   &&   rmax >= rmaxPrev ) {
+                    std::copy( m_xPrev.begin(), m_xPrev.end(), rhs );
+                    --m_lastRefinementSteps;
+                    break;
+                    }
+                if( step == m_refinementSteps )
+                    break;
+                rmaxPrev = rmax;
+                m_xPrev.assign( rhs, rhs+n );
+
+                // Correction; the residual is scaled before rounding to factor_type, to avoid underflow
+                for( unsigned int i=0; i<n; ++i )
+                    m_x[i] = static_cast<factor_type>( m_r[i] / rmax );
+                m_lu.solve( m_x.data() );
+                for( unsigned int i=0; i<n; ++i )
+                    rhs[i] += m_x[i] * rmax;
+                ++m_lastRefinementSteps;
+                }
+            }
+
+        // Solves the system for nrhs right-hand sides; column j of B starts at B + j*ldb
+        void solve( real_type *B, unsigned int nrhs, unsigned int ldb )
+            {
+            for( unsigned int j=0; j<nrhs; ++j )
+                solve( B + j*ldb );
+            }
+
+        bool isFactorized() const {
+            return m_lu.isFactorized();
+            }
+
+        unsigned int size() const {
+            return m_lu.size();
+            }
+
+        void secantUpdateHart( const real_type *s, const real_type *y )
+            {
+            auto n = m_lu.size();
+            m_x.resize( n );
+            m_y.resize( n );
+            for( unsigned int i=0; i<n; ++i ) {
+                m_x[i] = static_cast<factor_type>( s[i] );
+                m_y[i] = static_cast<factor_type>( y[i] );
+                }
+            m_lu.secantUpdateHart( m_x.data(), m_y.data() );
+            m_refine = false;
+            }
+
+        const LUFactorizer<factor_type>& factorizer() const {
+            return m_lu;
+            }
+
+        typedef LUFactorizerTimingStats TimingStats;
+
+        // Returns the timing of the single precision factorizer; the time of computing residuals
+        // for the iterative refinement is added to the solve time
+        TimingStats timingStats() const
+            {
+            auto result = m_lu.timingStats();
+            result.solveTiming += m_refinementTiming;
+            return result;
+            }
+
+        void clearTimingStats()
+            {
+            m_lu.clearTimingStats();
+            m_refinementTiming = sys::TimingStats();
+            }
+
+    private:
+        // Copies the matrix into the CSR arrays used to compute residuals,
+        // and into the elements passed to the single precision factorizer
+        template< class It >
+        void copyMatrix( It matrixBegin, It matrixEnd )
+            {
+            unsigned int n = 0;
+            m_normA = 0;
+            m_cols.clear();
+            m_values.clear();
+            m_factorEntries.clear();
+            m_rowPtr.assign( 1, 0 );
+            for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
+                auto r = it->first.first;
+                auto c = it->first.second;
+                n = std::max( n, std::max( r, c ) + 1 );
+                if( m_rowPtr.size() < r+2 )
+                    m_rowPtr.resize( r+2, 0 );
+                ++m_rowPtr[r+1];
+                m_cols.push_back( c );
+                m_values.push_back( it->second );
+                m_factorEntries.push_back( FactorEntry( it->first, static_cast<factor_type>( it->second ) ) );
+                }
+            m_rowPtr.resize( n+1, 0 );
+            for( unsigned int i=0; i<n; ++i )
+                m_rowPtr[i+1] += m_rowPtr[i];
+            m_rowNorms.assign( n, 0 );
+            for( std::size_t k=0; k<m_factorEntries.size(); ++k )
+                m_rowNorms[m_factorEntries[k].first.first] += std::fabs( m_values[k] );
+            for( auto rowNorm : m_rowNorms )
+                m_normA = std::max( m_normA, rowNorm );
+
+            // Sort by rows, unless the elements come in the order of rows already
+            bool sorted = true;
+            for( std::size_t k=1; k<m_factorEntries.size() && sorted; ++k )
+                sorted = m_factorEntries[k-1].first.first <= m_factorEntries[k].first.first;
+            if( !sorted ) {
+                m_next.assign( m_rowPtr.begin(), m_rowPtr.end()-1 );
+                m_sortedCols.resize( m_cols.size() );
+                m_sortedValues.resize( m_values.size() );
+                for( std::size_t k=0; k<m_factorEntries.size(); ++k ) {
+                    auto pos = m_next[m_factorEntries[k].first.first]++;
+                    m_sortedCols[pos] = m_cols[k];
+                    m_sortedValues[pos] = m_values[k];
+                    }
+                m_cols.swap( m_sortedCols );
+                m_values.swap( m_sortedValues );
+                }
+            m_refine = m_refinementSteps > 0;
+            }
+
+        typedef std::pair< std::pair< unsigned int, unsigned int >, factor_type > FactorEntry;
+
+        LUFactorizer< factor_type > m_lu;
+        std::vector< FactorEntry > m_factorEntries;
+        std::vector< unsigned int > m_rowPtr;           // Original matrix in CSR format
+        std::vector< unsigned int > m_cols;
+        std::vector< real_type > m_values;
+        real_type m_normA;                              // Max norm of the original matrix
+        std::vector< real_type > m_rowNorms;
+        std::vector< unsigned int > m_next;             // Buffers for sorting elements by rows
+        std::vector< unsigned int > m_sortedCols;
+        std::vector< real_type > m_sortedValues;
+        std::vector< factor_type > m_x;
+        std::vector< factor_type > m_y;
+        std::vector< real_type > m_r;
+        std::vector< real_type > m_b;
+        std::vector< real_type > m_xPrev;               // Solution before the last correction
+        unsigned int m_refinementSteps;
+        cxx::bool0 m_refine;
+        unsigned int m_lastRefinementSteps;
+        bool m_refinementConverged;
+        sys::TimingStats m_refinementTiming;
+    };
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LU_MIXEDPRECISIONLUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
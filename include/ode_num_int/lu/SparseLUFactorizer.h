@@ -0,0 +1,548 @@
+// SparseLUFactorizer.h
+
+#ifndef _LU_SPARSELUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _LU_SPARSELUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./LUFactorizerTimingStats.h"
+#include "../infra/cxx_zeroinit.h"
+#include "../infra/cxx_exception.h"
+#include "../infra/cxx_assert.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace ctm {
+namespace math {
+
+// Left-looking sparse LU factorization with threshold partial pivoting,
+// P*A = L*U, after J.R. Gilbert, T. Peierls, "Sparse partial pivoting in time
+// proportional to arithmetic operations", SIAM J. Sci. Stat. Comput., 9 (1988), 862-874.
+// Unlike LUFactorizer, only the actual fill is stored (the pattern of each column of L and U
+// is predicted symbolically, by a depth-first search in the graph of L), and zero diagonal
+// elements are allowed.
+// In each column, the diagonal element is chosen as the pivot if its magnitude is at least
+// pivotThreshold() times the largest magnitude of candidate elements; otherwise the largest
+// candidate is chosen.
+// When the matrix is updated by setMatrixFast() with the same sparsity pattern, the pivot sequence
+// and the patterns of L and U are reused, and only the numeric factorization is done, unless
+// some pivot fails the threshold test, in which case the full factorization is done.
+template< class RealType >
+class SparseLUFactorizer
+    {
+    public:
+        typedef RealType real_type;
+
+        SparseLUFactorizer() :
+            m_n( 0 ),
+            m_pivotThreshold( real_type(0.1) ),
+            m_factorized( false ),
+            m_haveSymbolic( false )
+            {}
+
+        bool empty() const {
+            return m_ap.empty();
+            }
+
+        template< class Container >
+        explicit SparseLUFactorizer( const Container& matrix ) :
+            m_pivotThreshold( real_type(0.1) )
+            {
+            setMatrix( matrix );
+            }
+
+        template< class It >
+        SparseLUFactorizer( It matrixBegin, It matrixEnd ) :
+            m_pivotThreshold( real_type(0.1) )
+            {
+            setMatrix( matrixBegin, matrixEnd );
+            }
+
+        real_type pivotThreshold() const {
+            return m_pivotThreshold;
+            }
+
+        void setPivotThreshold( real_type pivotThreshold )
+            {
+            if( !( pivotThreshold > 0   &&   pivotThreshold <= 1 ) )
+                throw cxx::exception( "SparseLUFactorizer: pivot threshold must be in the range (0, 1]" );
+            m_pivotThreshold = pivotThreshold;
+            }
+
+        template< class It >
+        void setMatrix( It matrixBegin, It matrixEnd )
+            {
+            sys::ScopedTimeMeasurer tm( m_timingStats.setMatrixTiming );
+            // Determine matrix size
+            unsigned int n = 0;
+            {
+                unsigned int nr = 0,   nc = 0;
+                for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
+                    nr = std::max( nr, it->first.first + 1 );
+                    nc = std::max( nc, it->first.second + 1 );
+                    }
+                if( nr != nc )
+                    throw cxx::exception("Invalid matrix stencil: matrix is not square");
+                n = nr;
+            }
+            m_n = n;
+
+            // Build the column-wise storage of A; remember the position of each element
+            // in the order of iteration, for setMatrixFast()
+            m_ap.assign( n+1, 0 );
+            m_entries.clear();
+            for( auto it=matrixBegin; it!=matrixEnd; ++it ) {
+                ++m_ap[it->first.second + 1];
+                m_entries.push_back( it->first );
+                }
+            for( unsigned int j=0; j<n; ++j )
+                m_ap[j+1] += m_ap[j];
+            m_ai.resize( m_entries.size() );
+            m_ax.resize( m_entries.size() );
+            m_entryPositions.resize( m_entries.size() );
+            {
+                std::vector< std::size_t > next( m_ap.begin(), m_ap.end()-1 );
+                std::size_t k = 0;
+                for( auto it=matrixBegin; it!=matrixEnd; ++it, ++k ) {
+                    auto p = next[it->first.second]++;
+                    m_ai[p] = it->first.first;
+                    m_ax[p] = it->second;
+                    m_entryPositions[k] = p;
+                    }
+            }
+
+            // Allocate workspace
+            m_x.assign( n, real_type() );
+            m_xi.resize( n );
+            m_stack.resize( n );
+            m_pstack.resize( n );
+            m_mark.resize( n );
+            m_pinv.resize( n );
+            m_perm.resize( n );
+            m_factorized = false;
+            m_haveSymbolic = false;
+            }
+
+        template< class Container >
+        void setMatrix( const Container& matrix ) {
+            setMatrix( matrix.begin(), matrix.end() );
+            }
+
+        template< class It >
+        void setMatrixFast( It matrixBegin, It matrixEnd )
+            {
+            sys::ScopedTimeMeasurer tm( m_timingStats.setMatrixFastTiming );
+            std::size_t k = 0;
+            auto nk = m_entries.size();
+            for( auto it=matrixBegin; it!=matrixEnd; ++it, ++k ) {
+                if( k == nk   ||   it->first != m_entries[k] ) {
+                    // Fall back to setMatrix because the sparsity layout has changed
+                    setMatrix( matrixBegin, matrixEnd );
+                    return;
+                    }
+                m_ax[m_entryPositions[k]] = it->second;
+                }
+            if( k != nk ) {
+                setMatrix( matrixBegin, matrixEnd );
+                return;
+                }
+            m_factorized = false;
+            }
+
+        template< class Container >
+        void setMatrixFast( const Container& matrix ) {
+            setMatrixFast( matrix.begin(), matrix.end() );
+            }
+
+        void solve( real_type *rhs )
+            {
+            factorize();
+            sys::ScopedTimeMeasurer tm( m_timingStats.solveTiming );
+            auto n = m_n;
+            auto x = m_x.data();
+
+            // x = P*rhs
+            for( unsigned int k=0; k<n; ++k )
+                x[k] = rhs[m_perm[k]];
+
+            // Forward iteration; the first element of each column of L is the unit diagonal one
+            for( unsigned int j=0; j<n; ++j ) {
+                auto xj = x[j];
+                if( xj != 0 )
+                    for( auto p=m_lp[j]+1, pend=m_lp[j+1]; p<pend; ++p )
+                        x[m_li[p]] -= m_lx[p] * xj;
+                }
+
+            // Backward iteration; the last element of each column of U is the diagonal one
+            for( unsigned int j=n-1; j!=~0u; --j ) {
+                auto pend = m_up[j+1] - 1;
+                auto& xj = x[j];
+                xj /= m_ux[pend];
+                if( xj != 0 )
+                    for( auto p=m_up[j]; p<pend; ++p )
+                        x[m_ui[p]] -= m_ux[p] * xj;
+                }
+
+            for( unsigned int k=0; k<n; ++k ) {
+                rhs[k] = x[k];
+                x[k] = 0;
+                }
+            }
+
+        bool isFactorized() const {
+            return m_factorized;
+            }
+
+        unsigned int size() const {
+            return m_n;
+            }
+
+        // Returns the number of elements of L and U, including the diagonal ones
+        std::size_t factorsSize() const {
+            return m_li.size() + m_ui.size();
+            }
+
+        // Returns the original index of the row that is k-th in P*A
+        unsigned int pivotRow( unsigned int k ) const
+            {
+            ASSERT( k < m_n );
+            return m_perm[k];
+            }
+
+        // Calls f( r, c, x ) for each element of the matrix A
+        template< class F >
+        void forEachElement( F f ) const
+            {
+            for( unsigned int j=0; j<m_n; ++j )
+                for( auto p=m_ap[j], pend=m_ap[j+1]; p<pend; ++p )
+                    f( m_ai[p], j, m_ax[p] );
+            }
+
+        // Calls f( r, c, x ) for each element of L, excluding the unit diagonal; row indices are those in P*A
+        template< class F >
+        void forEachLElement( F f ) const
+            {
+            for( unsigned int j=0; j<m_n; ++j )
+                for( auto p=m_lp[j]+1, pend=m_lp[j+1]; p<pend; ++p )
+                    f( m_li[p], j, m_lx[p] );
+            }
+
+        // Calls f( r, c, x ) for each element of U, including the diagonal
+        template< class F >
+        void forEachUElement( F f ) const
+            {
+            for( unsigned int j=0; j<m_n; ++j )
+                for( auto p=m_up[j], pend=m_up[j+1]; p<pend; ++p )
+                    f( m_ui[p], j, m_ux[p] );
+            }
+
+        // Implements the LU update satisfying the secant condition A*s=y, preserving
+        // the sparsity pattern of L and U; see LUFactorizer::secantUpdateHart().
+        void secantUpdateHart( const real_type *s, const real_type *y )
+            {
+            factorize();
+            sys::ScopedTimeMeasurer tm( m_timingStats.updateTiming );
+            initRowAccess();
+            auto n = m_n;
+            m_r.resize( n );
+            for( unsigned int i=0; i<n; ++i ) {
+                // Row i of P*A corresponds to row m_perm[i] of A
+                real_type beta = y[m_perm[i]];
+                real_type aa = 0;
+                auto lbegin = m_lrp[i],   lend = m_lrp[i+1];
+                auto ubegin = m_urp[i],   uend = m_urp[i+1];
+                for( auto q=lbegin; q<lend; ++q ) {
+                    const auto& rk = m_r[m_lrc[q]];
+                    beta -= m_lx[m_lrpos[q]]*rk;
+                    aa += rk*rk;
+                    }
+                for( auto q=ubegin; q<uend; ++q ) {
+                    const auto& sk = s[m_urc[q]];
+                    beta -= m_ux[m_urpos[q]]*sk;
+                    aa += sk*sk;
+                    }
+                auto& ri = m_r[i];
+                ri = 0;
+                if( beta == 0 ) {
+                    // Just compute r[i]
+                    for( auto q=ubegin; q<uend; ++q )
+                        ri += m_ux[m_urpos[q]] * s[m_urc[q]];
+                    }
+                else {
+                    // Update L, U; compute r[i]
+                    ASSERT( aa > 0 );
+                    auto factor = beta/aa;
+                    for( auto q=lbegin; q<lend; ++q )
+                        m_lx[m_lrpos[q]] += m_r[m_lrc[q]] * factor;
+                    for( auto q=ubegin; q<uend; ++q ) {
+                        const auto& sk = s[m_urc[q]];
+                        auto& Uik = m_ux[m_urpos[q]];
+                        Uik += sk*factor;
+                        ri += Uik * sk;
+                        }
+                    }
+                }
+            }
+
+        typedef LUFactorizerTimingStats TimingStats;
+
+        TimingStats timingStats() const { return m_timingStats; }
+        void clearTimingStats() {
+            m_timingStats = TimingStats();
+            }
+
+    private:
+        static const unsigned int None = ~0u;
+
+        unsigned int m_n;
+
+        // Matrix A, column-wise
+        std::vector< std::size_t > m_ap;
+        std::vector< unsigned int > m_ai;
+        std::vector< real_type > m_ax;
+
+        // Indices of the elements of A in the order of iteration, and their positions in m_ai, m_ax
+        std::vector< std::pair< unsigned int, unsigned int > > m_entries;
+        std::vector< std::size_t > m_entryPositions;
+
+        // Factors L and U, column-wise; row indices are those in P*A
+        std::vector< std::size_t > m_lp;
+        std::vector< unsigned int > m_li;
+        std::vector< real_type > m_lx;
+        std::vector< std::size_t > m_up;
+        std::vector< unsigned int > m_ui;
+        std::vector< real_type > m_ux;
+        std::vector< unsigned int > m_pinv;     // m_pinv[original row] = row in P*A
+        std::vector< unsigned int > m_perm;     // m_perm[row in P*A] = original row
+
+        // Row-wise access to L and U (column indices and positions in m_lx, m_ux), for secant updates
+        std::vector< std::size_t > m_lrp;
+        std::vector< unsigned int > m_lrc;
+        std::vector< std::size_t > m_lrpos;
+        std::vector< std::size_t > m_urp;
+        std::vector< unsigned int > m_urc;
+        std::vector< std::size_t > m_urpos;
+        std::vector< real_type > m_r;
+
+        // Workspace
+        std::vector< real_type > m_x;
+        std::vector< unsigned int > m_xi;
+        std::vector< unsigned int > m_stack;
+        std::vector< std::size_t > m_pstack;
+        std::vector< unsigned int > m_mark;
+
+        real_type m_pivotThreshold;
+        cxx::bool0 m_factorized;
+        cxx::bool0 m_haveSymbolic;
+        TimingStats m_timingStats;
+
+        void factorize()
+            {
+            if( m_factorized )
+                return;
+            sys::ScopedTimeMeasurer tm( m_timingStats.factorizeTiming );
+            if( !( m_haveSymbolic   &&   refactorize() ) )
+                factorizeWithPivoting();
+            m_factorized = true;
+            m_haveSymbolic = true;
+            }
+
+        // Depth-first search in the graph of L from node j (an original row index); nodes are marked
+        // with stamp; finished nodes are prepended to m_xi[top..n-1]. Returns the new value of top.
+        unsigned int dfs( unsigned int j, unsigned int top, unsigned int stamp )
+            {
+            int head = 0;
+            m_stack[0] = j;
+            while( head >= 0 ) {
+                j = m_stack[head];
+                auto jnew = m_pinv[j];
+                if( m_mark[j] != stamp ) {
+                    m_mark[j] = stamp;
+                    m_pstack[head] = jnew == None?   0:   m_lp[jnew] + 1;
+                    }
+                bool done = true;
+                auto pend = jnew == None?   0:   m_lp[jnew+1];
+                for( auto p=m_pstack[head]; p<pend; ++p ) {
+                    auto i = m_li[p];
+                    if( m_mark[i] == stamp )
+                        continue;
+                    m_pstack[head] = p;
+                    m_stack[++head] = i;
+                    done = false;
+                    break;
+                    }
+                if( done ) {
+                    --head;
+                    m_xi[--top] = j;
+                    }
+                }
+            return top;
+            }
+
+        void factorizeWithPivoting()
+            {
+            auto n = m_n;
+            auto x = m_x.data();
+            m_lp.resize( n+1 );
+            m_up.resize( n+1 );
+            m_li.clear();
+            m_lx.clear();
+            m_ui.clear();
+            m_ux.clear();
+            m_lrp.clear();
+            std::fill( m_pinv.begin(), m_pinv.end(), None );
+            std::fill( m_mark.begin(), m_mark.end(), 0 );
+            for( unsigned int k=0; k<n; ++k ) {
+                m_lp[k] = m_li.size();
+                m_up[k] = m_ui.size();
+
+                // Symbolic: find the pattern of x = L \ A(:,k), in the topological order
+                auto stamp = k + 1;
+                auto top = n;
+                for( auto p=m_ap[k]; p<m_ap[k+1]; ++p )
+                    if( m_mark[m_ai[p]] != stamp )
+                        top = dfs( m_ai[p], top, stamp );
+
+                // Numeric: x = L \ A(:,k)
+                for( auto p=m_ap[k]; p<m_ap[k+1]; ++p )
+                    x[m_ai[p]] = m_ax[p];
+                for( auto px=top; px<n; ++px ) {
+                    auto j = m_xi[px];
+                    auto J = m_pinv[j];
+                    if( J == None )
+                        continue;
+                    auto xj = x[j];
+                    for( auto p=m_lp[J]+1; p<m_lp[J+1]; ++p )
+                        x[m_li[p]] -= m_lx[p] * xj;
+                    }
+
+                // Choose the pivot; store column k of U
+                auto ipiv = None;
+                real_type a = -1;
+                for( auto px=top; px<n; ++px ) {
+                    auto i = m_xi[px];
+                    if( m_pinv[i] == None ) {
+                        auto t = std::fabs( x[i] );
+                        if( t > a ) {
+                            a = t;
+                            ipiv = i;
+                            }
+                        }
+                    else {
+                        m_ui.push_back( m_pinv[i] );
+                        m_ux.push_back( x[i] );
+                        }
+                    }
+                if( ipiv == None   ||   !( a > 0 ) )
+                    throw cxx::exception( "SparseLUFactorizer: matrix is singular" );
+                if( m_pinv[k] == None   &&   std::fabs( x[k] ) >= a*m_pivotThreshold )
+                    ipiv = k;
+                auto pivot = x[ipiv];
+                m_ui.push_back( k );
+                m_ux.push_back( pivot );
+                m_pinv[ipiv] = k;
+                m_perm[k] = ipiv;
+
+                // Store column k of L
+                m_li.push_back( ipiv );
+                m_lx.push_back( real_type(1) );
+                for( auto px=top; px<n; ++px ) {
+                    auto i = m_xi[px];
+                    if( m_pinv[i] == None ) {
+                        m_li.push_back( i );
+                        m_lx.push_back( x[i] / pivot );
+                        }
+                    x[i] = 0;
+                    }
+                }
+            m_lp[n] = m_li.size();
+            m_up[n] = m_ui.size();
+
+            // Make row indices of L refer to P*A
+            for( auto& i : m_li )
+                i = m_pinv[i];
+            }
+
+        // Numeric factorization with the pivot sequence and the patterns of L and U found previously.
+        // Returns false if some pivot fails the threshold test (then the factors are not valid).
+        bool refactorize()
+            {
+            auto n = m_n;
+            auto x = m_x.data();
+            for( unsigned int k=0; k<n; ++k ) {
+                for( auto p=m_ap[k]; p<m_ap[k+1]; ++p )
+                    x[m_pinv[m_ai[p]]] = m_ax[p];
+
+                // Elements of U are stored in the topological order
+                auto pdiag = m_up[k+1] - 1;
+                for( auto p=m_up[k]; p<pdiag; ++p ) {
+                    auto j = m_ui[p];
+                    auto& xj = x[j];
+                    m_ux[p] = xj;
+                    for( auto q=m_lp[j]+1; q<m_lp[j+1]; ++q )
+                        x[m_li[q]] -= m_lx[q] * xj;
+                    xj = 0;
+                    }
+
+                auto pivot = x[k];
+                x[k] = 0;
+                real_type a = std::fabs( pivot );
+                auto lbegin = m_lp[k]+1,   lend = m_lp[k+1];
+                for( auto p=lbegin; p<lend; ++p )
+                    a = std::max( a, std::fabs( x[m_li[p]] ) );
+                bool ok = a > 0   &&   std::fabs( pivot ) >= a*m_pivotThreshold;
+                m_ux[pdiag] = pivot;
+                for( auto p=lbegin; p<lend; ++p ) {
+                    auto& xi = x[m_li[p]];
+                    m_lx[p] = xi / pivot;
+                    xi = 0;
+                    }
+                if( !ok ) {
+                    // Clear the rest of the workspace
+                    for( unsigned int i=0; i<n; ++i )
+                        x[i] = 0;
+                    return false;
+                    }
+                }
+            return true;
+            }
+
+        void initRowAccess()
+            {
+            if( !m_lrp.empty() )
+                return;
+            auto n = m_n;
+            auto init = [n, this](
+                    std::vector< std::size_t >& rp,
+                    std::vector< unsigned int >& rc,
+                    std::vector< std::size_t >& rpos,
+                    const std::vector< std::size_t >& cp,
+                    const std::vector< unsigned int >& ci,
+                    unsigned int skipFirst ) {
+                rp.assign( n+1, 0 );
+                for( unsigned int j=0; j<n; ++j )
+                    for( auto p=cp[j]+skipFirst; p<cp[j+1]; ++p )
+                        ++rp[ci[p]+1];
+                for( unsigned int i=0; i<n; ++i )
+                    rp[i+1] += rp[i];
+                rc.resize( rp[n] );
+                rpos.resize( rp[n] );
+                std::vector< std::size_t > next( rp.begin(), rp.end()-1 );
+                for( unsigned int j=0; j<n; ++j )
+                    for( auto p=cp[j]+skipFirst; p<cp[j+1]; ++p ) {
+                        auto q = next[ci[p]]++;
+                        rc[q] = j;
+                        rpos[q] = p;
+                        }
+                };
+            init( m_lrp, m_lrc, m_lrpos, m_lp, m_li, 1 );
+            init( m_urp, m_urc, m_urpos, m_up, m_ui, 0 );
+            }
+    };
+
+template< class RealType >
+const unsigned int SparseLUFactorizer< RealType >::None;
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _LU_SPARSELUFACTORIZER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
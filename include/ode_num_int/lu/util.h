@@ -3,7 +3,7 @@
 #ifndef _LU_UTIL_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
 #define _LU_UTIL_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
 
-#include "./LUFactorizer.h"
+#include "./GenericLUFactorizer.h"
 #include "../la/SparseMatrixTemplate.h"
 
 namespace ctm {
@@ -23,6 +23,81 @@ inline sparse::SparseMatrix< real_type > luToMatrix( const LUFactorizer<real_typ
     return result;
     }
 
+// Returns the matrix P^T*L*U, where P*A = L*U is the factorization computed by lu
+// (or the matrix A, if it is not factorized yet)
+template< class real_type >
+inline sparse::SparseMatrix< real_type > luToMatrix( const SparseLUFactorizer<real_type>& lu )
+    {
+    auto n = lu.size();
+    sparse::SparseMatrix< real_type > result( n, n );
+    if( !lu.isFactorized() ) {
+        lu.forEachElement( [&result]( unsigned int r, unsigned int c, real_type x ) { result.at( r, c ) = x; } );
+        return result;
+        }
+    sparse::SparseMatrix< real_type > l( n, n ),   u( n, n );
+    for( unsigned int i=0; i<n; ++i )
+        l.at( i, i ) = real_type(1);
+    lu.forEachLElement( [&l]( unsigned int r, unsigned int c, real_type x ) { l.at( r, c ) = x; } );
+    lu.forEachUElement( [&u]( unsigned int r, unsigned int c, real_type x ) { u.at( r, c ) = x; } );
+    for( auto v : l*u )
+        if( v.second != 0 )
+            result.at( lu.pivotRow( v.first.first ), v.first.second ) = v.second;
+    return result;
+    }
+
+// Returns the matrix P^T*L*U, where P*A = L*U is the factorization computed by lu
+// (or the matrix A, if it is not factorized yet)
+template< class real_type >
+inline sparse::SparseMatrix< real_type > luToMatrix( const DenseLUFactorizer<real_type>& lu )
+    {
+    auto n = lu.size();
+    sparse::SparseMatrix< real_type > result( n, n );
+    for( unsigned int r=0; r<n; ++r )
+        for( unsigned int c=0; c<n; ++c ) {
+            auto x = lu.elementAt( r, c );
+            if( x != 0 )
+                result.at( r, c ) = x;
+            }
+    return result;
+    }
+
+template< class real_type >
+inline sparse::SparseMatrix< real_type > luToMatrix( const BandedLUFactorizer<real_type>& lu )
+    {
+    auto n = lu.size();
+    auto kl = lu.lowerBandwidth(),   ku = lu.upperBandwidth();
+    sparse::SparseMatrix< real_type > result( n, n );
+    for( unsigned int r=0; r<n; ++r )
+        for( unsigned int c1=r>kl? r-kl: 0, c2=std::min(n-1, r+ku), c=c1; c<=c2; ++c ) {
+            auto x = lu.elementAt( r, c );
+            if( x != 0 )
+                result.at( r, c ) = x;
+            }
+    return result;
+    }
+
+template< class real_type >
+inline sparse::SparseMatrix< real_type > luToMatrix( const MixedPrecisionLUFactorizer<real_type>& lu )
+    {
+    auto n = lu.size();
+    sparse::SparseMatrix< real_type > result( n, n );
+    for( auto v : luToMatrix( lu.factorizer() ) )
+        result.at( v.first.first, v.first.second ) = v.second;
+    return result;
+    }
+
+template< class real_type >
+inline sparse::SparseMatrix< real_type > luToMatrix( const GenericLUFactorizer<real_type>& lu )
+    {
+    switch( lu.activeKind() ) {
+        case SparseLU:  return luToMatrix( lu.sparseFactorizer() );
+        case DenseLU:   return luToMatrix( lu.denseFactorizer() );
+        case BandedLU:  return luToMatrix( lu.bandedFactorizer() );
+        case MixedPrecisionLU:  return luToMatrix( lu.mixedPrecisionFactorizer() );
+        default:        return luToMatrix( lu.skylineFactorizer() );
+        }
+    }
+
 } // end namespace math
 } // end namespace ctm
 
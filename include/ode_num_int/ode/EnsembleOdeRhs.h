@@ -0,0 +1,124 @@
+// EnsembleOdeRhs.h
+
+#ifndef _ODE_ENSEMBLEODERHS_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _ODE_ENSEMBLEODERHS_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./interfaces/OdeRhs.h"
+#include "../la/EnsembleVectorData.h"
+
+namespace ctm {
+namespace math {
+
+// ODE right hand side for an ensemble of M systems of the same structure (e.g., variants
+// of a model with different parameters), which are integrated in lockstep by any solver
+// instantiated for EnsembleVectorData<ElementType, M>. All the vector operations of the solver
+// process all members at once; the right hand side of each member is computed by
+// the corresponding member model.
+// Since the members share the time and the step size, solvers with step size control
+// choose the step that is acceptable for all members (the error norm is the maximum over members).
+// Note: zero functions of members are not supported.
+template< class ElementType, unsigned int M >
+class EnsembleOdeRhs :
+    public OdeRhs< EnsembleVectorData< ElementType, M > >
+    {
+    public:
+        typedef EnsembleVectorData< ElementType, M > VD;
+        typedef VectorData< ElementType > MemberVD;
+        typedef VectorTemplate< VD > V;
+        typedef VectorTemplate< MemberVD > MV;
+        typedef typename V::value_type real_type;
+        typedef std::shared_ptr< OdeRhs< MemberVD > > MemberPtr;
+
+        EnsembleOdeRhs() : m_members( M ) {}
+
+        explicit EnsembleOdeRhs( const std::vector< MemberPtr >& members ) : m_members( M )
+            {
+            if( members.size() != M )
+                throw cxx::exception( "EnsembleOdeRhs: invalid number of members" );
+            for( unsigned int i=0; i<M; ++i )
+                setMember( i, members[i] );
+            }
+
+        MemberPtr member( unsigned int index ) const {
+            return m_members.at( index );
+            }
+
+        void setMember( unsigned int index, const MemberPtr& member )
+            {
+            ASSERT( member );
+            if( member->zeroFuncCount() > 0 )
+                throw cxx::exception( "EnsembleOdeRhs: members with zero functions are not supported" );
+            for( unsigned int i=0; i<M; ++i ) {
+                auto& m = m_members[i];
+                if( i != index && m && (
+                        m->secondOrderVarCount() != member->secondOrderVarCount() ||
+                        m->firstOrderVarCount() != member->firstOrderVarCount() ) )
+                    throw cxx::exception( "EnsembleOdeRhs: all members must have the same numbers of variables" );
+                }
+            m_members.at( index ) = member;
+            }
+
+        unsigned int secondOrderVarCount() const {
+            return M * firstMember()->secondOrderVarCount();
+            }
+
+        unsigned int firstOrderVarCount() const {
+            return M * firstMember()->firstOrderVarCount();
+            }
+
+        void rhs( V& dst, real_type time, const V& x ) const
+            {
+            this->odeRhsPreObservers( time, x, this );
+            dst.resize( x.size() );
+            for( unsigned int i=0; i<M; ++i ) {
+                x.getMember( m_x, i );
+                m_members[i]->rhs( m_f, time, m_x );
+                dst.setMember( i, m_f );
+                }
+            this->odeRhsPostObservers( time, x, dst, this );
+            }
+
+        std::vector<unsigned int> varIds() const
+            {
+            auto memberVarIds = firstMember()->varIds();
+            std::vector<unsigned int> result;
+            result.reserve( M * memberVarIds.size() );
+            for( auto id : memberVarIds )
+                result.insert( result.end(), M, id );
+            return result;
+            }
+
+        void beforeStep( real_type time, const V& x ) const
+            {
+            for( unsigned int i=0; i<M; ++i ) {
+                x.getMember( m_x, i );
+                m_members[i]->beforeStep( time, m_x );
+                }
+            }
+
+        void beforeStep2( const V& rhs ) const
+            {
+            for( unsigned int i=0; i<M; ++i ) {
+                rhs.getMember( m_f, i );
+                m_members[i]->beforeStep2( m_f );
+                }
+            }
+
+    private:
+        std::vector< MemberPtr > m_members;
+        mutable MV m_x;
+        mutable MV m_f;
+
+        const MemberPtr& firstMember() const
+            {
+            auto& result = m_members.front();
+            if( !result )
+                throw cxx::exception( "EnsembleOdeRhs: members are not set" );
+            return result;
+            }
+    };
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _ODE_ENSEMBLEODERHS_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
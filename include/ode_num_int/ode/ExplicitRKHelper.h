@@ -4,6 +4,7 @@
 #define _ODE_EXPLICITRKHELPER_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
 
 #include "../la/VectorTemplate.h"
+#include "../la/VectorKernels.h"
 
 namespace ctm {
 namespace math {
@@ -41,8 +42,7 @@ class ExplicitRKHelper
                 VV x2;
                 V buf;
                 Output() :
-                    x2( 0 ),
-                    buf( 0 )
+                    x2( 0 )
                     {}
 
                 Output( unsigned int stages,
@@ -67,32 +67,61 @@ class ExplicitRKHelper
             rhs->rhs( o.k[0], t1, x1 );
             rhs->beforeStep2( o.k[0] );
             auto a = c.a.data();
-            const real_type zero = static_cast<real_type>( 0 );
             for( decltype(stages) stage=1; stage<stages; ++stage ) {
-                copy( o.buf, x1 );
-                for( decltype(stages) i=0; i<stage; ++i, ++a )
-                    if( *a != zero )
-                        o.buf += o.k[i].scaled( h * *a );
+                linearCombination( o.buf, x1, h, a, o.k.data(), stage );
+                a += stage;
                 rhs->rhs( o.k[stage], t1 + h * c.c[stage-1], o.buf );
                 }
 
             auto b = c.b.data();
-            for( decltype(x2Count) ix=0; ix<x2Count; ++ix ) {
+            for( decltype(x2Count) ix=0; ix<x2Count; ++ix, b+=stages ) {
                 auto& x2 = o.x2[ix];
-                if( ix == c.last_k_arg_as_x2_index ) {
+                if( ix == c.last_k_arg_as_x2_index )
                     o.buf.swap( x2 );
-                    b += stages;
-                    }
-                else {
-                    copy( x2, x1 );
-                    for( decltype(stages) stage=0; stage<stages; ++stage, ++b ) {
-                        if( *b != zero )
-                            x2 += o.k[stage].scaled( h * *b );
-                        }
+                else
+                    linearCombination( x2, x1, h, b, o.k.data(), stages );
+                }
+            }
+
+        // Computes dst = x + h*(c[0]*k[0] + ... + c[count-1]*k[count-1]), skipping zero coefficients.
+        // Vectors are processed block by block, so that each of them is passed through memory
+        // only once, while the block of dst being accumulated stays in cache.
+        // Large vectors are split into chunks processed in parallel if VectorKernels multithreading
+        // is enabled; since elements are computed independently, the result is the same.
+        static void linearCombination( V& dst, const V& x, real_type h, const real_type *c, const V *k, unsigned int count )
+            {
+            auto n = x.size();
+            ASSERT( dst.size() == n );
+            VectorKernels::forEachChunk( n, [&]( std::size_t begin, std::size_t end ) {
+                linearCombination( dst, x, h, c, k, count, begin, end );
+                } );
+            }
+
+    private:
+        static void linearCombination(
+                V& dst, const V& x, real_type h, const real_type *c, const V *k, unsigned int count,
+                std::size_t begin, std::size_t end )
+            {
+            const std::size_t BlockSize = 512;
+            const real_type zero = static_cast<real_type>( 0 );
+            for( auto j0=begin; j0<end; j0+=BlockSize ) {
+                auto j1 = std::min( end, j0 + BlockSize );
+                auto dstBegin = dst.begin() + j0;
+                auto dstEnd = dst.begin() + j1;
+                std::copy( x.begin() + j0, x.begin() + j1, dstBegin );
+                for( unsigned int i=0; i<count; ++i ) {
+                    if( c[i] == zero )
+                        continue;
+                    auto factor = h * c[i];
+                    auto src = k[i].begin() + j0;
+                    for( auto d=dstBegin; d!=dstEnd; ++d, ++src )
+                        *d += *src * factor;
                     }
                 }
             }
 
+    public:
+
         template< class VDdst, class VDsrc >
         static void copy( VectorTemplate<VDdst>& dst, const VectorTemplate<VDsrc>& src )
             {
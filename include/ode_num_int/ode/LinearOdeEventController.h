@@ -15,6 +15,7 @@ class LinearOdeEventController :
     {
     public:
         typedef VectorTemplate< VD > V;
+        typedef typename OdeRhs<VD>::ZV ZV;
         typedef typename VD::value_type real_type;
         typedef std::function<void(V&, real_type)> Interpolator;
 
@@ -88,7 +89,7 @@ class LinearOdeEventController :
             real_type h = t2 - m_t1;
             t2 = m_t1 + h*tmin;
             x2 *= tmin;
-            x2 += const_cast<V&>(x1).scaled( 1. - tmin );   // have to use const_cast because of lack of design
+            x2 += const_cast<V&>(x1).scaled( 1 - tmin );   // have to use const_cast because of lack of design
 
             // Switch state
             std::fill( m_transitions.begin(), m_transitions.end(), 0 );
@@ -111,7 +112,7 @@ class LinearOdeEventController :
                 if (recompute)
                     zf = m_zfbuf[i];
                 else
-                    zf = zf*( 1. - tmin ) + m_zf2[i]*tmin;
+                    zf = zf*( 1 - tmin ) + m_zf2[i]*tmin;
                 auto& st = m_state[i];
                 if (recompute)
                     st = s(zf, zff);
@@ -130,10 +131,10 @@ class LinearOdeEventController :
         bool m_clean;
         bool m_haveZf;                  // True when there are more than zero zero functions
         bool m_haveRecomputedZf;        // True when there are at least one zero function with the RecomputeAfterSwitch flag
-        V m_zf1;                        // Zero functions at the beginning of the step
-        V m_zf2;                        // Zero functions at the end of the step
+        ZV m_zf1;                       // Zero functions at the beginning of the step
+        ZV m_zf2;                       // Zero functions at the end of the step
         std::vector<unsigned int> m_zfflags;
-        V m_zfbuf;                      // Zero functions somewhere in the middle
+        ZV m_zfbuf;                     // Zero functions somewhere in the middle
         std::vector<unsigned int> m_zfi;// Indices of zero function that changed their sign, terminated with ~0u
         std::vector<int> m_transitions;
         std::vector<int> m_state;
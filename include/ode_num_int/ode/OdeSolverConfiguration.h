@@ -124,6 +124,7 @@ class OdeSolverConfiguration : public ComponentConfiguration
                     result["output_stats"] = m_statisticsOutput;
                     result["output_con"] = m_stepConsoleOutput;
                     result["output_file"] = m_stepFileOutput;
+                    result["output_jacobian"] = m_jacobianOutput;
                     result["init_state"] = m_initState;
                     return result;
                     }
@@ -139,6 +140,7 @@ class OdeSolverConfiguration : public ComponentConfiguration
                     maybeLoadParameter( parameters, "output_stats", m_statisticsOutput );
                     maybeLoadParameter( parameters, "output_con", m_stepConsoleOutput );
                     maybeLoadParameter( parameters, "output_file", m_stepFileOutput );
+                    maybeLoadParameter( parameters, "output_jacobian", m_jacobianOutput );
                     maybeLoadParameter( parameters, "init_state", m_initState );
                     }
 
@@ -158,6 +160,7 @@ class OdeSolverConfiguration : public ComponentConfiguration
                     result["output_stats"] = appendNestedHelp( m_statisticsOutput, "Timing statistics output" );
                     result["output_con"] = appendNestedHelp( m_stepConsoleOutput, "Per-step console output" );
                     result["output_file"] = appendNestedHelp( m_stepFileOutput, "Per-step file output" );
+                    result["output_jacobian"] = appendNestedHelp( m_jacobianOutput, "Output of matrices passed to the LU factorizer" );
                     result["init_state"] = appendNestedHelp( m_initState, "Initial state specification (if null, default state is set)" );
                     return result;
                     }
@@ -198,6 +201,10 @@ class OdeSolverConfiguration : public ComponentConfiguration
                     return m_stepFileOutput;
                     }
 
+                std::shared_ptr< OdeSolverOutputOption<VD> > jacobianOutput() const {
+                    return m_jacobianOutput;
+                    }
+
                 std::shared_ptr< math::OdeInitState<VD> > initState() const {
                     return m_initState;
                     }
@@ -212,6 +219,7 @@ class OdeSolverConfiguration : public ComponentConfiguration
                 std::shared_ptr< OdeSolverOutputOption<VD> > m_statisticsOutput;
                 std::shared_ptr< OdeSolverOutputOption<VD> > m_stepConsoleOutput;
                 std::shared_ptr< OdeSolverOutputOption<VD> > m_stepFileOutput;
+                std::shared_ptr< OdeSolverOutputOption<VD> > m_jacobianOutput;
                 std::shared_ptr< math::OdeInitState<VD> > m_initState;
             };
 
@@ -322,6 +330,7 @@ inline std::vector< OdeSolverOutputOption<VD>* > initOdeOutput(
     collectOutputOption( paramProvider->statisticsOutput() );
     collectOutputOption( paramProvider->stepConsoleOutput() );
     collectOutputOption( paramProvider->stepFileOutput() );
+    collectOutputOption( paramProvider->jacobianOutput() );
     return outputOptions;
     }
 
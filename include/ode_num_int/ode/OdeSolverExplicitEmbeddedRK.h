@@ -73,6 +73,7 @@ class OdeSolverExplicitEmbeddedRK :
 
         void doStep()
             {
+            VectorArena::Scope arenaScope( this->vectorArena() );
             while( true ) {
                 this->odeSolverPreObservers( m_h, this );
 
@@ -49,6 +49,7 @@ class OdeSolverExplicitRK :
 
         void doStep()
             {
+            VectorArena::Scope arenaScope( this->vectorArena() );
             this->odeSolverPreObservers( m_h, this );
 
             OpaqueTickCounter timer;    // deBUG
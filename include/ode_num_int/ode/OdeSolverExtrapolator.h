@@ -88,6 +88,7 @@ class OdeSolverExtrapolator :
 
         void doStep()
             {
+            VectorArena::Scope arenaScope( this->vectorArena() );
             while( true ) {
                 this->odeSolverPreObservers( m_h, this );
 
@@ -138,9 +139,8 @@ class OdeSolverExtrapolator :
                         real_type r = static_cast<real_type>(m_n[j-1])/m_n[j-k-1];
                         if( m_symmetric )
                             r *= r;
-                        auto d = 1. / ( r - 1.0 );
-                        T1 *= -d;
-                        T1 += T2.scaled( 1 + d );
+                        auto d = 1 / ( r - 1 );
+                        T1 = T1.scaled( -d ) + T2.scaled( 1 + d );
                         }
                 }
                 this->tstat1.add( timer.Lap() );
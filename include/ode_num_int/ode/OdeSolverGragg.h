@@ -63,6 +63,7 @@ class OdeSolverGragg :
 
         void doStep()
             {
+            VectorArena::Scope arenaScope( this->vectorArena() );
             auto h = this->initialStepSize();
             this->odeSolverPreObservers( h, this );
             OpaqueTickCounter timer;    // deBUG
@@ -89,8 +90,7 @@ class OdeSolverGragg :
                 }
             m_initialV += m_fbuf.scaled( h2 );
             rhs->rhs( m_fbuf, m_initialTime + h2, m_initialV );
-            m_nextU = m_initialU;
-            m_nextU += m_fbuf.scaled( h );
+            m_nextU = m_initialU + m_fbuf.scaled( h );
             rhs->rhs( m_fbuf, m_initialTime + h, m_nextU );
             m_initialV += m_fbuf.scaled( h2 );
 
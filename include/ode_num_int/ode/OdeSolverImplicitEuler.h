@@ -20,6 +20,8 @@ class OdeSolverImplicitEuler :
     {
     public:
         typedef VectorTemplate< VD > V;
+        typedef typename OdeStepMapping<VD>::EVD EVD;
+        typedef typename OdeStepMapping<VD>::EV EV;
         typedef typename V::value_type real_type;
         typedef OptionalParameters::Parameters Parameters;
 
@@ -39,10 +41,12 @@ class OdeSolverImplicitEuler :
                     this->newtonSolver()->setComponent( m_mapping4Newton );
                cxx::forwardObservers( newton->iterationObservers, this->iterationObservers );
                 if( auto itperf = newton->iterationPerformer() ) {
-                    // Forward jacobian refresh observers
+                    // Forward jacobian refresh observers and jacobian observers
                     auto setupDdir = [this, itperf] {
-                        if( auto ddir = itperf->newtonDescentDirection() )
+                        if( auto ddir = itperf->newtonDescentDirection() ) {
                             cxx::forwardObservers( ddir->jacobianRefreshObservers, this->jacobianRefreshObservers );
+                            cxx::forwardObservers( ddir->jacobianObservers, this->jacobianObservers );
+                            }
                         };
                     itperf->onNewtonDescentDirectionChanged( setupDdir );
                     setupDdir();
@@ -77,6 +81,7 @@ class OdeSolverImplicitEuler :
 
         void doStep()
             {
+            VectorArena::Scope arenaScope( this->vectorArena() );
             auto h = this->initialStepSize();
             this->odeSolverPreObservers( h, this );
 
@@ -88,6 +93,10 @@ class OdeSolverImplicitEuler :
 
             auto newton = this->newtonSolver();
             m_mapping4Newton->setTimeStep( h );
+            if( m_reorder ) {
+                m_reorder->initOrdering( m_mapping4Newton->eqnInitialState() );
+                this->reorderingStats = m_reorder->reorderingStats();
+                }
 
             if( m_predictor ) {
                 m_predictor->setOdeRhs( this->odeRhs() );
@@ -119,7 +128,7 @@ class OdeSolverImplicitEuler :
                 ec->atStepStart( initialState, initialTime );
 
             auto status = newton->run();
-            if( status != NewtonSolverInterface<VD>::Converged )
+            if( status != NewtonSolverInterface<EVD>::Converged )
                 throw cxx::exception(std::string("Algebraic solver failed: ") + newton->statusText( status ) );
             if( m_reorder ) {
                 m_reorder->unorderInput( m_eqnbuf, newton->currentSolution() );
@@ -158,11 +167,11 @@ class OdeSolverImplicitEuler :
             this->tstat2.add( timer.Lap() );
             }
 
-        std::shared_ptr< VectorReorderingMapping<VD> > reorder() const {
+        std::shared_ptr< VectorReorderingMapping<EVD> > reorder() const {
             return m_reorder;
             }
 
-        void setReorder( const std::shared_ptr< VectorReorderingMapping<VD> >& reorder ) {
+        void setReorder( const std::shared_ptr< VectorReorderingMapping<EVD> >& reorder ) {
             m_reorder = reorder;
             if( m_reorder )
                 m_reorder->setMapping( m_mapping4Newton );
@@ -214,11 +223,11 @@ class OdeSolverImplicitEuler :
     private:
         std::shared_ptr< OdeSolver<VD> > m_predictor;
         unsigned int m_predictorSteps;
-        std::shared_ptr< VectorReorderingMapping<VD> > m_reorder;
+        std::shared_ptr< VectorReorderingMapping<EVD> > m_reorder;
 
         std::shared_ptr< OdeStepMappingEuler<VD> > m_mapping4Newton;
         V m_buf;
-        V m_eqnbuf;
+        EV m_eqnbuf;
         bool m_hardResetRequested;
     };
 
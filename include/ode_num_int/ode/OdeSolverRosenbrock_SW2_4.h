@@ -31,7 +31,8 @@ class OdeSolverRosenbrock_SW2_4 :
             m_d( 1 ),
             m_disable_error_check( false ),
             m_initialTime( 0 ),
-            m_h( 0 )
+            m_h( 0 ),
+            m_hardInitRequired( true )
             {}
 
         void setInitialStepSize( real_type initialStepSize )
@@ -66,6 +67,7 @@ class OdeSolverRosenbrock_SW2_4 :
 
         void doStep()
             {
+            VectorArena::Scope arenaScope( this->vectorArena() );
             bool needInitStep = true;
 
             while( true ) {
@@ -96,19 +98,16 @@ class OdeSolverRosenbrock_SW2_4 :
                 this->tstat1.add( timer.Lap() );
 
                 // k2
-                this->copy( m_buf, m_initialState );
-                m_buf += m_k1.scaled( m_h*2/3 );
+                m_buf = m_initialState + m_k1.scaled( m_h*2/3 );
                 rhs->rhs( m_k2, m_initialTime + m_h*2/3, m_buf );
                 this->mult( m_buf, m_k1 );
-                m_k2 += m_buf.scaled( -4./3*m_h*m_d );
+                m_k2 += m_buf.scaled( -real_type(4)/3*m_h*m_d );
                 linSolve( m_k2 );
 
                 this->tstat2.add( timer.Lap() );
 
                 // Next state
-                this->copy( m_nextState, m_initialState );
-                m_nextState += m_k1.scaled( 0.25*m_h );
-                m_nextState += m_k2.scaled( 0.75*m_h );
+                m_nextState = m_initialState + m_k1.scaled( real_type(0.25)*m_h ) + m_k2.scaled( real_type(0.75)*m_h );
 
                 this->tstat3.add( timer.Lap() );
 
@@ -122,11 +121,9 @@ class OdeSolverRosenbrock_SW2_4 :
                     this->tstat4.add( timer.Lap() );
 
                     // k4
-                    this->copy( m_buf, m_nextState );
-                    m_buf += m_k3.scaled( m_h*2/3 );
+                    m_buf = m_nextState + m_k3.scaled( m_h*2/3 );
                     rhs->rhs( m_k4, m_initialTime + m_h*5/3, m_buf );
-                    this->copy( m_buf2, m_k1.scaled(2./3) );
-                    m_buf2 += m_k2.scaled( 6 );
+                    m_buf2 = m_k1.scaled( real_type(2)/3 ) + m_k2.scaled( 6 );
                     this->mult( m_buf, m_buf2 );
                     m_k4 += m_buf.scaled( m_h*m_d );
                     linSolve( m_k4 );
@@ -134,12 +131,7 @@ class OdeSolverRosenbrock_SW2_4 :
                     this->tstat5.add( timer.Lap() );
 
                     // Error estimate
-                    this->copy( m_buf, m_k3 );
-                    m_buf -= m_k2;
-                    m_buf *= 5;
-                    m_buf += m_k1;
-                    m_buf -= m_k4;
-                    m_buf *= 0.125*m_h;
+                    m_buf = ( ( m_k3 - m_k2 )*5 + m_k1 - m_k4 )*( real_type(0.125)*m_h );
                     errorNorm = this->errorNormCalculator()->errorNorm( m_buf );
                 }
 
@@ -221,10 +213,11 @@ class OdeSolverRosenbrock_SW2_4 :
         V m_nextState;
         V m_buf;
         V m_buf2;
+        bool m_hardInitRequired;        // Whether memory allocation and Jacobian computation are required at next step
 
         void initStep()
             {
-            bool hard = m_k1.empty();
+            bool hard = m_hardInitRequired;
 
             if( hard ) {
                 auto rhs = this->odeRhs();
@@ -246,6 +239,7 @@ class OdeSolverRosenbrock_SW2_4 :
 
                 // Compute ODE RHS at the beginning of the step
                 this->odeRhs()->rhs( m_initialOdeRhs, m_initialTime, m_initialState );
+                m_hardInitRequired = false;
                 }
 
             OdeSolverRosenbrock_W_base<VD>::initStep(
@@ -253,7 +247,7 @@ class OdeSolverRosenbrock_SW2_4 :
             }
 
         void cleanupStep() {
-            m_k1.resize( 0 );
+            m_hardInitRequired = true;
             }
 
         void linSolve( V& x ) {
@@ -24,7 +24,8 @@ class OdeSolverRosenbrock_W1 :
             OdeSolverEventController<VD>( *this, "linear" ),
             m_d( 1 ),
             m_initialTime( 0 ),
-            m_h( 0 )
+            m_h( 0 ),
+            m_hardInitRequired( true )
             {}
 
         void setInitialStepSize( real_type initialStepSize )
@@ -56,6 +57,7 @@ class OdeSolverRosenbrock_W1 :
 
         void doStep()
             {
+            VectorArena::Scope arenaScope( this->vectorArena() );
             this->odeSolverPreObservers( m_h, this );
 
             OpaqueTickCounter timer;    // deBUG
@@ -78,8 +80,7 @@ class OdeSolverRosenbrock_W1 :
             linSolve( m_k1 );
 
             // Next state
-            this->copy( m_nextState, m_initialState );
-            m_nextState += m_k1.scaled( m_h );
+            m_nextState = m_initialState + m_k1.scaled( m_h );
 
             this->tstat1.add( timer.Lap() );
 
@@ -135,10 +136,11 @@ class OdeSolverRosenbrock_W1 :
         V m_initialOdeRhs;              // ODE RHS corresp. to the initial state
         V m_k1;
         V m_nextState;
+        bool m_hardInitRequired;        // Whether memory allocation and Jacobian computation are required at next step
 
         void initStep()
             {
-            bool hard = m_k1.empty();
+            bool hard = m_hardInitRequired;
 
             if( hard ) {
                 auto rhs = this->odeRhs();
@@ -151,6 +153,7 @@ class OdeSolverRosenbrock_W1 :
                 m_initialOdeRhs.resize( n );
                 m_k1.resize( n );
                 m_nextState.resize( n );
+                m_hardInitRequired = false;
                 }
 
             // Compute ODE RHS at the beginning of the step
@@ -161,7 +164,7 @@ class OdeSolverRosenbrock_W1 :
             }
 
         void cleanupStep() {
-            m_k1.resize( 0 );
+            m_hardInitRequired = true;
             }
 
         void linSolve( V& x ) {
@@ -9,7 +9,11 @@
 #include "./interfaces/OdeSolverErrorNormCalculator.h"
 #include "./interfaces/OdeSolverStepSizeController.h"
 #include "./interfaces/OdeSolverEventController.h"
-#include "../lu/LUFactorizer.h"
+#include "./interfaces/OdeSolverLUSettings.h"
+#include "../lu/GenericLUFactorizer.h"
+#include "../la/SparseMatrixBuilder.h"
+#include "../la/SparsePatternUnion.h"
+#include "../la/SparseMatrixReordering.h"
 
 namespace ctm {
 namespace math {
@@ -17,14 +21,18 @@ namespace math {
 template< class VD >
 class OdeSolverRosenbrock_W_base :
     public OdeSolver<VD>,
-    public OdeSolverJacobianTrimmer<VD>
+    public OdeSolverJacobianTrimmer<VD>,
+    public OdeSolverLUSettings<VD>
     {
     public:
         typedef VectorTemplate< VD > V;
+        typedef VectorTemplate< typename ResizableVectorData<VD>::type > RV;
         typedef typename V::value_type real_type;
 
         OdeSolverRosenbrock_W_base() :
             OdeSolverJacobianTrimmer<VD>( *this, "" ),
+            OdeSolverLUSettings<VD>( static_cast< OdeSolver<VD>& >( *this ) ),
+            m_W_LU_cacheSize( 0 ),
             m_W_LU( nullptr ),
             m_hd4W( 0 )
             {}
@@ -49,9 +57,20 @@ class OdeSolverRosenbrock_W_base :
             sys::ScopedTimeMeasurer tm( this->tstat9 );
             m_W_LU->clearTimingStats();
             ASSERT( x.size() == m_n );
-            m_J2.block( 0, 0, m_n2+m_n1, m_n2 ).mulVectRight( x.begin(), m_buf4mul.begin() );
+            // Note: columns of m_J2 beyond m_n2 are empty, so the product by m_J2 equals
+            // the product by its block m_J2.block( 0, 0, m_n2+m_n1, m_n2 )
+            m_J2.mulVectRight( x.begin(), m_buf4mul.begin() );
             x.block( m_n2, m_n2+m_n1 ) += m_buf4mul.scaled( hd );
-            m_W_LU->solve( &x[m_n2] );
+            if( m_W_ordering.empty() )
+                m_W_LU->solve( &x[m_n2] );
+            else {
+                auto n = m_W_ordering.size();
+                for( decltype(n) i=0; i<n; ++i )
+                    m_W_buf[i] = x[m_n2 + m_W_ordering[i]];
+                m_W_LU->solve( m_W_buf.data() );
+                for( decltype(n) i=0; i<n; ++i )
+                    x[m_n2 + m_W_ordering[i]] = m_W_buf[i];
+                }
             x.block( 0, m_n2 ) += x.block( m_n2, m_n2 ).scaled( hd );
             this->luTimingStats += m_W_LU->timingStats();
             }
@@ -63,7 +82,7 @@ class OdeSolverRosenbrock_W_base :
             ASSERT( x.size() == m_n );
             copy( dst.block(0, m_n2), x.block(m_n2, m_n2) );
             m_J1.mulVectRight( x.begin()+m_n2, dst.begin()+m_n2 );
-            m_J2.block( 0, 0, m_n2+m_n1, m_n2 ).mulVectRight( x.begin(), m_buf4mul.begin() );
+            m_J2.mulVectRight( x.begin(), m_buf4mul.begin() );
             dst.block( m_n2, m_n2+m_n1 ) += m_buf4mul;
             }
 
@@ -86,33 +105,53 @@ class OdeSolverRosenbrock_W_base :
                 }
 
             // Compute the W matrix and its decomposition, if necessary
-            updateW( hd );
+            if( updateW( hd )   &&   !this->jacobianObservers.empty() )
+                this->jacobianObservers(
+                            sparse::SparseMatrixTemplate< sparse::SparseMatrixFastData< real_type > >(
+                                sparse::SparseMatrixFastData< real_type >( factorizedW() ), m_W.size() ),
+                            RV( initialState ), RV( initialOdeRhs ) );
             }
 
     private:
-        typedef sparse::SparseMatrix< real_type > SparseMatrix;
-        typedef sparse::SparseMatrixTemplate< sparse::SparseMatrixFastData< real_type > > FastSparseMatrix;
+        typedef sparse::CsrSparseMatrix< real_type > CsrSparseMatrix;
+        typedef typename CsrSparseMatrix::Index Index;
 
         unsigned int m_n;               // Total number of variables
         unsigned int m_n2;              // Total number of 2nd order variables
         unsigned int m_n1;              // Total number of 1st order variables
-        FastSparseMatrix m_J1;
-        FastSparseMatrix m_J2;
-        FastSparseMatrix m_W;           // The W matrix
-
-        typedef std::map< double, LUFactorizer<real_type> > W_LU_map;
-        W_LU_map m_W_LU_cache;
-        LUFactorizer<real_type> *m_W_LU;// Decomposed trimmed W matrix
+        CsrSparseMatrix m_J1;
+        CsrSparseMatrix m_J2;
+        CsrSparseMatrix m_W;            // The W matrix
+        sparse::SparsePatternUnion< real_type > m_W_pattern;    // Maps elements of m_J1 and m_J2 to m_W
+
+        // Ordering of rows and columns of W before the LU factorization (empty if W is not reordered),
+        // reordered W, and positions of its elements in m_W
+        std::vector< unsigned int > m_W_ordering;
+        CsrSparseMatrix m_W_reordered;
+        std::vector< std::size_t > m_W_reorderedPositions;
+        std::vector< real_type > m_W_buf;
+
+        // Decompositions of W for the recently used values of h*d, the most recent first.
+        // Entries beyond m_W_LU_cacheSize are stale; their storage, as well as the storage
+        // of the least recently used entry, is reused for new decompositions.
+        struct W_LU_CacheEntry
+            {
+            real_type hd;
+            GenericLUFactorizer<real_type> lu;
+            };
+        std::vector< W_LU_CacheEntry > m_W_LU_cache;
+        unsigned int m_W_LU_cacheSize;
+        GenericLUFactorizer<real_type> *m_W_LU;  // Decomposed trimmed W matrix
         real_type m_hd4W;               // Value of h*d corresponding to m_W_LU
-        V m_buf4mul;
+        RV m_buf4mul;
+        sparse::SparseMatrixBuilder< real_type > m_builder;
 
         void buildJacobian( real_type initialTime, const V& initialState, const V& initialOdeRhs )
             {
             auto rhs = this->odeRhs();
 
-            real_type dx = 1e-6;
-            auto makeJ = [&, this]( FastSparseMatrix& J, unsigned int istart, unsigned int isize ) {
-                SparseMatrix Jm( m_n2+m_n1, m_n2+m_n1 );
+            real_type dx = real_type(1e-6);
+            auto makeJ = [&, this]( CsrSparseMatrix& J, unsigned int istart, unsigned int isize ) {
                 V x = initialState;
                 V f( m_n );
                 for( unsigned int i=istart; i<isize; ++i ) {
@@ -123,10 +162,10 @@ class OdeSolverRosenbrock_W_base :
                         auto df = f[j] - initialOdeRhs[j];
                         if( df == 0 )
                             continue;
-                        Jm.at( j-m_n2, i-istart ) = df / dx;
+                        m_builder.add( j-m_n2, i-istart, df / dx );
                         }
                     }
-                J = Jm;
+                m_builder.build( J, Index( m_n2+m_n1, m_n2+m_n1 ) );
                 };
 
             this->jacobianRefreshObservers( true );
@@ -134,40 +173,67 @@ class OdeSolverRosenbrock_W_base :
             makeJ( m_J2, 0, m_n2 );
             this->jacobianRefreshObservers( false );
 
-            // Trim m_W
-            SparseMatrix m( m_n2+m_n1, m_n2+m_n1 );
-            m.addIdentity();
-            m += m_J1;
-            m += m_J2;
-            m_W = m;
+            // Pattern of m_W is the union of the patterns of the identity matrix, m_J1, and m_J2
+            m_W_pattern.init( m_W, m_J1, m_J2 );
+
+            // Reorder W in order to reduce its envelope, if requested
+            m_W_ordering.clear();
+            auto reorderingMethod = this->reorderingMethod();
+            if( reorderingMethod != sparse::NoReordering ) {
+                m_W_ordering = sparse::computeReordering( m_W, reorderingMethod, &this->reorderingStats );
+                if( !m_W_ordering.empty() ) {
+                    sparse::permutePattern( m_W_reordered, m_W_reorderedPositions, m_W, m_W_ordering );
+                    m_W_buf.resize( m_W_ordering.size() );
+                    }
+                }
 
             // Clear cache for W
-            m_W_LU_cache.clear();
+            m_W_LU_cacheSize = 0;
             m_W_LU = nullptr;
             m_hd4W = 0;
             }
 
-        void updateW( real_type hd )
+        // Returns the matrix passed to the LU factorizer, i.e., W, possibly reordered
+        const CsrSparseMatrix& factorizedW() const {
+            return m_W_ordering.empty()?   m_W:   m_W_reordered;
+            }
+
+        // Returns true if W has been computed and factorized anew
+        bool updateW( real_type hd )
             {
             ASSERT( hd != 0 ); // Required for cache to work
+            bool result = false;
             if( m_hd4W != hd ) {
                 m_hd4W = hd;
-                auto it = m_W_LU_cache.find( hd );
-                if( it != m_W_LU_cache.end() )
-                    m_W_LU = &it->second;
-                else {
-                    const size_t MaxCacheSize = 100;
-                    if( m_W_LU_cache.size() >= MaxCacheSize )
-                        m_W_LU_cache.clear();
-                    m_W.makeZero();
-                    m_W.addIdentity();
-                    m_W -= m_J1.scaled( hd );
-                    m_W -= m_J2.scaled( hd*hd );
-                    auto itbool = m_W_LU_cache.insert( typename W_LU_map::value_type( hd, LUFactorizer<real_type>(m_W) ) );
-                    ASSERT( itbool.second );
-                    m_W_LU = &itbool.first->second;
+                auto begin = m_W_LU_cache.begin();
+                auto end = begin + m_W_LU_cacheSize;
+                auto it = std::find_if( begin, end, [hd]( const W_LU_CacheEntry& e ) { return e.hd == hd; } );
+                if( it == end ) {
+                    const size_t MaxCacheSize = this->luCacheSize();
+                    if( m_W_LU_cacheSize < m_W_LU_cache.size() )
+                        ++m_W_LU_cacheSize;
+                    else if( m_W_LU_cache.size() < MaxCacheSize ) {
+                        m_W_LU_cache.push_back( W_LU_CacheEntry() );
+                        ++m_W_LU_cacheSize;
+                        }
+                    begin = m_W_LU_cache.begin();
+                    it = begin + ( m_W_LU_cacheSize - 1 );
+                    m_W_pattern.combine( m_W, real_type(1), m_J1, -hd, m_J2, -(hd*hd) );
+                    if( !m_W_ordering.empty() )
+                        sparse::permuteValues( m_W_reordered, m_W_reorderedPositions, m_W );
+                    auto& W = factorizedW();
+                    it->hd = hd;
+                    it->lu.setKind( this->luFactorizerKind() );
+                    if( it->lu.size() == W.size().first )
+                        it->lu.setMatrixFast( W );
+                    else
+                        it->lu.setMatrix( W );
+                    result = true;
                     }
+                std::rotate( begin, it, it+1 );
+                m_W_LU = &begin->lu;
                 }
+            return result;
             }
     };
 
@@ -15,11 +15,12 @@ class OdeStepMappingEuler :
     {
     public:
         typedef VectorTemplate< VD > V;
+        typedef typename OdeStepMapping<VD>::EV EV;
         typedef typename VD::value_type real_type;
 
         OdeStepMappingEuler() :
             m_alpha( 1 ),
-            m_h( 0.1 ),
+            m_h( real_type(0.1) ),
             m_t0( 0 ),
             m_f0scaledValid( false )
             {}
@@ -39,7 +40,7 @@ class OdeStepMappingEuler :
             return rhs->firstOrderVarCount() + rhs->secondOrderVarCount();
             }
 
-        void map( V& dst, const V& x ) const
+        void map( EV& dst, const EV& x ) const
             {
             ASSERT( x.size() == inputSize() );
             this->vectorMappingPreObservers( x, this );
@@ -52,18 +53,15 @@ class OdeStepMappingEuler :
             auto n1 = rhs->firstOrderVarCount();
 
             // Compute U
-            V stateBuf( 2*nd + n1 );
-            expandState( stateBuf, x );
+            m_stateBuf.resize( 2*nd + n1 );
+            expandState( m_stateBuf, x );
 
             // Compute ODE rhs
-            V rhsBuf( rhs->varCount() );
-            rhs->rhs( rhsBuf, m_t0+m_h, stateBuf );
+            m_rhsBuf.resize( rhs->varCount() );
+            rhs->rhs( m_rhsBuf, m_t0+m_h, m_stateBuf );
 
             // Compute equation rhs X - X0 - h*(1-alpha)*F0 - h*alpha*F
-            dst = x;
-            dst -= m_x0.block( nd, nd+n1 );
-            dst += m_f0scaled.block( nd, nd+n1 );
-            dst += rhsBuf.block( nd, nd+n1 ).scaled( -m_h*m_alpha );
+            dst = x - m_x0.block( nd, nd+n1 ) + m_f0scaled.block( nd, nd+n1 ) + m_rhsBuf.block( nd, nd+n1 ).scaled( -m_h*m_alpha );
 
             this->vectorMappingPostObservers( x, dst, this );
             }
@@ -103,7 +101,7 @@ class OdeStepMappingEuler :
             m_f0scaledValid = false;
             }
 
-        V eqnInitialState() const
+        EV eqnInitialState() const
             {
             auto rhs = this->odeRhs();
             auto nd = rhs->secondOrderVarCount();
@@ -111,18 +109,18 @@ class OdeStepMappingEuler :
             return m_x0.block( nd, nd+n1 );
             }
 
-        void computeOdeState( V& odeState, const V& eqnState ) const
+        void computeOdeState( V& odeState, const EV& eqnState ) const
             {
             auto rhs = this->odeRhs();
             odeState.resize( rhs->varCount() );
             expandState( odeState, eqnState );
             }
 
-        V computeOdeState( const V& eqnState ) const {
+        V computeOdeState( const EV& eqnState ) const {
             return OdeStepMapping< VD >::computeOdeState( eqnState );
             }
 
-        virtual void computeEqnState( V& eqnState, const V& odeState ) const
+        virtual void computeEqnState( EV& eqnState, const V& odeState ) const
             {
             auto rhs = this->odeRhs();
             auto nd = rhs->secondOrderVarCount();
@@ -130,7 +128,7 @@ class OdeStepMappingEuler :
             eqnState = odeState.block( nd, nd+n1 );
             }
 
-        V computeEqnState( const V& odeState ) const {
+        EV computeEqnState( const V& odeState ) const {
             return OdeStepMapping< VD >::computeEqnState( odeState );
             }
 
@@ -172,8 +170,10 @@ class OdeStepMappingEuler :
         V m_x0;
         mutable V m_f0scaled;
         mutable bool m_f0scaledValid;
+        mutable V m_stateBuf;
+        mutable V m_rhsBuf;
 
-        void expandState( V& dst, const V& x ) const
+        void expandState( V& dst, const EV& x ) const
             {
             auto nd = this->odeRhs()->secondOrderVarCount();
             auto n1 = this->odeRhs()->firstOrderVarCount();
@@ -182,9 +182,7 @@ class OdeStepMappingEuler :
 
             // Compute U
             auto U = dst.block( 0, nd );
-            U = m_x0.block( 0, nd );
-            U += m_x0.block( nd, nd ).scaled( m_h*(1-m_alpha) );
-            U += x.block( 0, nd ).scaled( m_h*m_alpha );
+            U = m_x0.block( 0, nd ) + m_x0.block( nd, nd ).scaled( m_h*(1-m_alpha) ) + x.block( 0, nd ).scaled( m_h*m_alpha );
 
             // Copy V and Z to the end of dst
             dst.block( nd, nd+n1 ) = x;
@@ -21,11 +21,11 @@ class OdeStepSizeSimpleController :
         typedef OptionalParameters::Parameters Parameters;
 
         OdeStepSizeSimpleController() :
-            m_tolerance( 1e-6 ),
-            m_insuranceCoefficient( 0.8 ),
-            m_incMinFactor( 1.3 ),
+            m_tolerance( real_type(1e-6) ),
+            m_insuranceCoefficient( real_type(0.8) ),
+            m_incMinFactor( real_type(1.3) ),
             m_incMaxFactor( 2 ),
-            m_decMaxFactor( 0.1 ),
+            m_decMaxFactor( real_type(0.1) ),
             m_maxThreshold( 0 )
             {}
 
@@ -36,7 +36,7 @@ class OdeStepSizeSimpleController :
             {
             if( errorNorm == 0 )
                 return Result( currentStepSize, true, false );
-            real_type p = std::pow( m_tolerance/errorNorm, 1./(methodOrder+1) );
+            real_type p = std::pow( m_tolerance/errorNorm, 1/(methodOrder+1) );
             real_type pd = p * m_insuranceCoefficient;
             if( p >= 1 ) {
                 if( m_maxThreshold > 0   &&   pd*currentStepSize > m_maxThreshold ) {
@@ -9,10 +9,12 @@
 namespace ctm {
 namespace math {
 
+// Note: the Newton solver operates on vectors of resizable type, because the size of
+// the algebraic system is generally different from the number of ODE state variables.
 template< class VD >
 class OdeNewtonSolver :
     public OdeSolverComponent<VD>,
-    public NewtonSolverHolder<VD>
+    public NewtonSolverHolder< typename ResizableVectorData<VD>::type >
     {
     public:
         typedef OptionalParameters::Parameters Parameters;
@@ -21,7 +23,7 @@ class OdeNewtonSolver :
             OdeSolverComponent<VD>( solver )
             {
             if( !typeId.empty() )
-                this->setNewtonSolver( Factory< NewtonSolverInterface<VD> >::newInstance( typeId ) );
+                this->setNewtonSolver( Factory< NewtonSolverInterface< typename ResizableVectorData<VD>::type > >::newInstance( typeId ) );
             }
 
         OdeNewtonSolver( const OdeNewtonSolver<VD>& ) = delete;
@@ -40,6 +40,7 @@ class OdeRhs :
         };
 
         typedef VectorTemplate< VD > V;
+        typedef VectorTemplate< typename ResizableVectorData<VD>::type > ZV;    // Vector of zero functions
         typedef typename V::value_type real_type;
         OdeRhsPreObservers<VD> odeRhsPreObservers;
         OdeRhsPostObservers<VD> odeRhsPostObservers;
@@ -63,7 +64,7 @@ class OdeRhs :
         }
 
         virtual void rhs( V& dst, real_type time, const V& x ) const = 0;
-        virtual void zeroFunctions( V& /*dst*/, real_type /*time*/, const V& /*x*/ ) const {}
+        virtual void zeroFunctions( ZV& /*dst*/, real_type /*time*/, const V& /*x*/ ) const {}
         virtual void switchPhaseState( const int* /*transitions*/, real_type /*time*/, V& /*x*/ ) {}
         virtual std::string describeZeroFunction( unsigned int /*index*/ ) const {
             return std::string();
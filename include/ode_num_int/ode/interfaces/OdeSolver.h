@@ -6,8 +6,11 @@
 #include "./OdeRhs.h"
 #include "../../timing/TimingStats.h"
 #include "../../alg/interfaces/NewtonSolverIterationObservers.h"
+#include "../../alg/interfaces/NewtonDescentDirection.h"
 #include "../../lu/LUFactorizerTimingStats.h"
+#include "../../la/SparseMatrixReordering.h"
 #include "../../infra/def_getset.h"
+#include "../../la/VectorArena.h"
 
 #include <list>
 
@@ -76,8 +79,10 @@ class OdeSolver :
         OdeSolverPreObservers<VD> odeSolverPreObservers;
         OdeSolverPostObservers<VD> odeSolverPostObservers;
         JacobianRefreshObservers jacobianRefreshObservers;
-        NewtonSolverIterationObservers<VD> iterationObservers;
+        NewtonSolverIterationObservers< typename ResizableVectorData<VD>::type > iterationObservers;
+        JacobianObservers< typename ResizableVectorData<VD>::type > jacobianObservers;     // Matrices passed to the LU factorizer
         LUFactorizerTimingStats luTimingStats;
+        sparse::ReorderingStats reorderingStats;
 
         // deBUG, TODO: Remove
         sys::TimingStats tstat0;
@@ -92,8 +97,9 @@ class OdeSolver :
         sys::TimingStats tstat9;
 
         OdeSolver() :
-            m_initialStepSize( 0.01 ),
-            m_stepSizeMinThreshold( 1e-16 )
+            m_initialStepSize( real_type(0.01) ),
+            m_stepSizeMinThreshold( real_type(1e-16) ),
+            m_vectorArena( std::make_shared<VectorArena>() )
             {}
 
         real_type initialStepSize() const {
@@ -118,6 +124,12 @@ class OdeSolver :
         virtual void setInitialState( real_type initialTime, const V& initialState, bool soft = false ) = 0;
         virtual void doStep() = 0;
 
+        // Arena for temporary vectors; implementations of doStep() make it current
+        // for the duration of the step, so that no heap allocations occur after the first steps.
+        const std::shared_ptr<VectorArena>& vectorArena() const {
+            return m_vectorArena;
+            }
+
         inline Parameters parameters() const;
         inline void setParameters( const Parameters & parameters );
         inline Parameters helpOnParameters() const;
@@ -126,6 +138,7 @@ class OdeSolver :
     private:
         real_type m_initialStepSize;
         real_type m_stepSizeMinThreshold;
+        std::shared_ptr<VectorArena> m_vectorArena;
         friend class OdeSolverComponent<VD>;
         std::list< OdeSolverComponent<VD>* > m_components;
     };
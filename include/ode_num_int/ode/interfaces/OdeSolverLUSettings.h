@@ -0,0 +1,80 @@
+// OdeSolverLUSettings.h
+
+#ifndef _ODE_INTERFACES_ODESOLVERLUSETTINGS_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _ODE_INTERFACES_ODESOLVERLUSETTINGS_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "./OdeSolver.h"
+#include "../../lu/GenericLUFactorizer.h"
+
+namespace ctm {
+namespace math {
+
+// Component of ODE solvers that factorize sparse matrices themselves;
+// holds the kind of the LU factorizer, the method of reordering the matrices
+// before the LU factorization, and the number of decompositions kept for reuse.
+template< class VD >
+class OdeSolverLUSettings :
+    public OdeSolverComponent<VD>
+    {
+    public:
+        typedef OptionalParameters::Parameters Parameters;
+
+        explicit OdeSolverLUSettings( OdeSolver<VD>& solver ) :
+            OdeSolverComponent<VD>( solver ),
+            m_luKind( "skyline" ),
+            m_reorderingMethod( "none" ),
+            m_luCacheSize( 100 )
+            {}
+
+        OdeSolverLUSettings( const OdeSolverLUSettings<VD>& ) = delete;
+        OdeSolverLUSettings<VD>& operator=( const OdeSolverLUSettings<VD>& ) = delete;
+
+        LUFactorizerKind luFactorizerKind() const {
+            return luFactorizerKindFromString( m_luKind );
+            }
+
+        sparse::ReorderingMethod reorderingMethod() const {
+            return sparse::reorderingMethodFromString( m_reorderingMethod );
+            }
+
+        unsigned int luCacheSize() const {
+            return m_luCacheSize;
+            }
+
+        void saveParameters( Parameters& parameters ) const {
+            parameters["lu"] = m_luKind;
+            parameters["reorder"] = m_reorderingMethod;
+            parameters["lu_cache"] = m_luCacheSize;
+            }
+
+        void loadParameters( const Parameters& parameters )
+            {
+            if( OptionalParameters::maybeLoadParameter( parameters, "lu", m_luKind ) )
+                luFactorizerKind();
+            if( OptionalParameters::maybeLoadParameter( parameters, "reorder", m_reorderingMethod ) )
+                reorderingMethod();
+            if( OptionalParameters::maybeLoadParameter( parameters, "lu_cache", m_luCacheSize )   &&   m_luCacheSize == 0 )
+                throw cxx::exception( "Invalid LU cache size: must be positive" );
+            }
+
+        void addHelpOnParameters( Parameters& help )
+            {
+            help["lu"] = helpOnLUFactorizerKind();
+            help["reorder"] =
+                    "Method of reordering the matrix before LU factorization: 'rcm' (reverse Cuthill-McKee),\n"
+                    "'sloan', 'best' (the one of the above giving the smaller envelope), or 'none'";
+            help["lu_cache"] =
+                    "Maximal number of LU decompositions, for different step sizes, kept for reuse;\n"
+                    "when exceeded, the least recently used decomposition is recomputed in place";
+            }
+
+    private:
+        std::string m_luKind;
+        std::string m_reorderingMethod;
+        unsigned int m_luCacheSize;
+    };
+
+} // end namespace math
+} // end namespace ctm
+
+#endif // _ODE_INTERFACES_ODESOLVERLUSETTINGS_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
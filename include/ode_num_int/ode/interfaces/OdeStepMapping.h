@@ -9,14 +9,19 @@
 namespace ctm {
 namespace math {
 
+// Maps the unknowns of the algebraic system solved at each step to the equation residuals.
+// The algebraic system is formulated on vectors of resizable type EVD, because its size
+// generally differs from the number of ODE state variables.
 template< class VD >
 class OdeStepMapping :
-    public VectorMapping<VD>,
+    public VectorMapping< typename ResizableVectorData<VD>::type >,
     public OdeRhsHolder<VD>,
     public Factory< OdeStepMapping<VD> >
     {
     public:
         typedef VectorTemplate< VD > V;
+        typedef typename ResizableVectorData<VD>::type EVD;
+        typedef VectorTemplate< EVD > EV;
         typedef typename V::value_type real_type;
 
         virtual real_type initialTime() const = 0;
@@ -24,21 +29,21 @@ class OdeStepMapping :
         virtual void setInitialState( real_type initialTime, const V& initialState ) = 0;
         virtual real_type timeStep() const = 0;
         virtual void setTimeStep( real_type timeStep ) = 0;
-        virtual V eqnInitialState() const = 0;
-        virtual void computeOdeState( V& odeState, const V& eqnState ) const = 0;
-        virtual void computeEqnState( V& eqnState, const V& odeState ) const = 0;
+        virtual EV eqnInitialState() const = 0;
+        virtual void computeOdeState( V& odeState, const EV& eqnState ) const = 0;
+        virtual void computeEqnState( EV& eqnState, const V& odeState ) const = 0;
         virtual void beforeStep() const = 0;
 
-        V computeOdeState( const V& eqnState ) const
+        V computeOdeState( const EV& eqnState ) const
             {
             V odeState;
             computeOdeState( odeState, eqnState );
             return odeState;
             }
 
-        V computeEqnState( const V& odeState ) const
+        EV computeEqnState( const V& odeState ) const
             {
-            V eqnState;
+            EV eqnState;
             computeEqnState( eqnState, odeState );
             return eqnState;
             }
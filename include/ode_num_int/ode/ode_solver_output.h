@@ -6,6 +6,7 @@
 #include "./OdeSolverConfiguration.h"
 #include "../timing/TimerCalibrator.h"
 #include "./OdeVarNameGenerator.h"
+#include "../alg/JacobianDumper.h"
 #include <iostream>
 #include <fstream>
 #include <iomanip>
@@ -75,7 +76,7 @@ class OdeSolverStreamOutputOption :
             public:
                 D( const OdeSolverConfiguration<VD> *solverConfig, const OdeSolverComponents<VD> *solverComponents,
                             const std::string& fileName ) :
-                    m_outputTiming( solverConfig->parameterProvider()->odeSolverOutputTiming() ),
+                    m_outputTiming( real_type( solverConfig->parameterProvider()->odeSolverOutputTiming() ) ),
                     m_startTime( solverComponents->solver()->initialTime() ),
                     m_reportTime( m_startTime - 2*m_outputTiming ),
                     m_outputFile( fileName.empty()? nullptr: new std::ofstream( fileName ) ),
@@ -238,6 +239,9 @@ class OdeSolverStatisticsOutput :
                 reportTimingStats( "TIMING: LU set mx", luTimingStats.setMatrixTiming );
                 reportTimingStats( "TIMING: LU set mx fast", luTimingStats.setMatrixFastTiming );
                 reportTimingStats( "TIMING: LU update", luTimingStats.updateTiming );
+                if( solver->reorderingStats.envelopeBefore > 0 )
+                    os << "LU envelope size: " << solver->reorderingStats.envelopeBefore
+                       << " before reordering, " << solver->reorderingStats.envelopeAfter << " after reordering" << endl;
 
                 reportTimingStats( "TIMING: DBG 0", solver->tstat0 );
                 reportTimingStats( "TIMING: DBG 1", solver->tstat1 );
@@ -296,7 +300,7 @@ class OdeSolverStepGeneralConsoleOutput :
             unsigned int nSteps = 0;
 
             cxx::ScopedIdentifiedElement< typename math::OdeSolverPostObservers<VD>::cb_type > m_cbAfterStep;
-            cxx::ScopedIdentifiedElement< typename math::NewtonSolverIterationObservers<VD>::cb_type > m_cbAfterIteration;
+            cxx::ScopedIdentifiedElement< typename math::NewtonSolverIterationObservers< typename math::ResizableVectorData<VD>::type >::cb_type > m_cbAfterIteration;
 
             D( const OdeSolverConfiguration<VD> *solverConfig, const OdeSolverComponents<VD> *solverComponents, const std::string& fileName ) :
                 OdeSolverStreamOutputOption<VD>::D( solverConfig, solverComponents, fileName ),
@@ -331,7 +335,7 @@ class OdeSolverStepGeneralConsoleOutput :
                 }
 
             bool afterIteration( unsigned int iterationNumber,
-                                 const math::NewtonSolverInterface<VD>* solver )
+                                 const math::NewtonSolverInterface< typename math::ResizableVectorData<VD>::type >* solver )
                 {
                 using namespace std;
 
@@ -593,6 +597,76 @@ class OdeSolverStepSolutionColumnwiseOutput :
         std::unique_ptr< D > m_d;
     };
 
+template< class VD >
+class OdeSolverJacobianDumpOutput :
+    public OdeSolverOutputOption<VD>,
+    public FactoryMixin< OdeSolverJacobianDumpOutput<VD>, OdeSolverOutputOption<VD> >
+    {
+    public:
+        typedef typename ResizableVectorData<VD>::type RVD;
+        typedef OptionalParameters::Parameters Parameters;
+
+        OdeSolverJacobianDumpOutput() :
+            m_fileNamePrefix( "jacobian_" ),
+            m_period( 1 ),
+            m_format( "mtx" )
+            {}
+
+        void beforeFirstStep(
+            const OdeSolverConfiguration<VD> *solverConfig,
+            const OdeSolverComponents<VD> *solverComponents )
+            {
+            m_dumper = std::make_shared< JacobianDumper<RVD> >(
+                        m_fileNamePrefix, m_period, JacobianDumper<RVD>::formatFromString( m_format ) );
+            auto dumper = m_dumper;
+            m_cbJacobian = std::unique_ptr< ScopedCb >( new ScopedCb(
+                        solverComponents->solver()->jacobianObservers,
+                        [dumper]( const typename JacobianDumper<RVD>::SparseMatrix& J,
+                                  const VectorTemplate<RVD>& x0, const VectorTemplate<RVD>& f0 ) {
+                            ( *dumper )( J, x0, f0 );
+                            } ) );
+            }
+
+        void afterSolve()
+            {
+            m_cbJacobian.reset();
+            m_dumper.reset();
+            }
+
+        Parameters parameters() const
+            {
+            Parameters result;
+            result["file_name"] = m_fileNamePrefix;
+            result["period"] = m_period;
+            result["format"] = m_format;
+            return result;
+            }
+
+        void setParameters( const Parameters & parameters )
+            {
+            this->maybeLoadParameter( parameters, "file_name", m_fileNamePrefix );
+            this->maybeLoadParameter( parameters, "period", m_period );
+            this->maybeLoadParameter( parameters, "format", m_format );
+            }
+
+        Parameters helpOnParameters() const
+            {
+            Parameters result;
+            result["file_name"] = "Prefix of names of files to write matrices to; the dump number and the extension are appended";
+            result["period"] = "Each period-th matrix passed to the LU factorizer is written";
+            result["format"] = "File format, either 'mtx' (Matrix Market) or 'bin' (binary)";
+            return result;
+            }
+
+    private:
+        typedef cxx::ScopedIdentifiedElement< typename JacobianObservers<RVD>::cb_type > ScopedCb;
+        std::string m_fileNamePrefix;
+        unsigned int m_period;
+        std::string m_format;
+        std::shared_ptr< JacobianDumper<RVD> > m_dumper;
+        std::unique_ptr< ScopedCb > m_cbJacobian;
+    };
+
 } // end namespace math
 } // end namespace ctm
 
@@ -11,6 +11,7 @@ CTM_DECL_IMPLEMENTATION_TEMPLATE_TRAITS( math::OdeSolverStatisticsOutput, "stats
 CTM_DECL_IMPLEMENTATION_TEMPLATE_TRAITS( math::OdeSolverStepGeneralConsoleOutput, "con_general" )
 CTM_DECL_IMPLEMENTATION_TEMPLATE_TRAITS( math::OdeSolverStepSolutionConsoleOutput, "con_solution" )
 CTM_DECL_IMPLEMENTATION_TEMPLATE_TRAITS( math::OdeSolverStepSolutionColumnwiseOutput, "con_solution_columnwise" )
+CTM_DECL_IMPLEMENTATION_TEMPLATE_TRAITS( math::OdeSolverJacobianDumpOutput, "jacobian_dump" )
 
 namespace math {
 
@@ -22,6 +23,7 @@ class OdeSolverOutputClassesRegistrator
         CTM_DECL_IMPLEMENTATION_TEMPLATE_REGISTRATOR( OdeSolverStepGeneralConsoleOutput, VD )
         CTM_DECL_IMPLEMENTATION_TEMPLATE_REGISTRATOR( OdeSolverStepSolutionConsoleOutput, VD )
         CTM_DECL_IMPLEMENTATION_TEMPLATE_REGISTRATOR( OdeSolverStepSolutionColumnwiseOutput, VD )
+        CTM_DECL_IMPLEMENTATION_TEMPLATE_REGISTRATOR( OdeSolverJacobianDumpOutput, VD )
     };
 
 } // end namespace math
@@ -18,15 +18,16 @@ class BouncingBall :
     {
     public:
         typedef VectorTemplate< VD > V;
+        typedef typename OdeRhs<VD>::ZV ZV;
         typedef typename V::value_type real_type;
         typedef OptionalParameters::Parameters Parameters;
 
         enum FrictionType { Atan, Tabular, Linear };
 
         explicit BouncingBall() :
-            m_g( 9.8 ),
-            m_recoveryFactor( 0.9 ),
-            m_stickSpeed( 1e-5 ),
+            m_g( real_type(9.8) ),
+            m_recoveryFactor( real_type(0.9) ),
+            m_stickSpeed( real_type(1e-5) ),
             m_sticking( false )
             {}
 
@@ -59,7 +60,7 @@ class BouncingBall :
             this->odeRhsPostObservers( time, x, dst, this );
             }
 
-        void zeroFunctions( V& dst, real_type /*time*/, const V& x ) const
+        void zeroFunctions( ZV& dst, real_type /*time*/, const V& x ) const
             {
             dst.resize( 1 );
             dst[0] = x[0];
@@ -24,7 +24,8 @@ class CoupledNonlinearOscillators :
             m_count( count ),
             m_c0( c0 ),
             m_c2( c2 ),
-            m_f( f )
+            m_f( f ),
+            m_stride( 1 )
             {}
 
         virtual unsigned int secondOrderVarCount() const {
@@ -39,15 +40,16 @@ class CoupledNonlinearOscillators :
             {
             this->odeRhsPreObservers( time, x, this );
             dst.resize( 2*m_count );
-            for( unsigned int i=0; i<m_count; ++i ) {
+            for( unsigned int j=0; j<m_count; ++j ) {
+                auto i = index( j );
                 dst[i] = x[m_count + i];
                 real_type dprev = x[i];
-                if( i > 0 )
-                    dprev -= x[i-1];
+                if( j > 0 )
+                    dprev -= x[index( j-1 )];
                 real_type f = -force( dprev );
-                if( i+1 < m_count )
-                    f += force( x[i+1] - x[i] );
-                else if( i+1 == m_count )
+                if( j+1 < m_count )
+                    f += force( x[index( j+1 )] - x[i] );
+                else if( j+1 == m_count )
                     f += m_f;
                 dst[m_count+i] = f;
                 }
@@ -61,6 +63,7 @@ class CoupledNonlinearOscillators :
             result["c0"] = m_c0;
             result["c2"] = m_c2;
             result["f"] = m_f;
+            result["stride"] = m_stride;
             return result;
             }
 
@@ -70,6 +73,15 @@ class CoupledNonlinearOscillators :
             this->maybeLoadParameter( parameters, "c0", m_c0 );
             this->maybeLoadParameter( parameters, "c2", m_c2 );
             this->maybeLoadParameter( parameters, "f", m_f );
+            this->maybeLoadParameter( parameters, "stride", m_stride );
+            unsigned int a = m_count, b = m_stride;
+            while( b > 0 ) {
+                auto r = a % b;
+                a = b;
+                b = r;
+                }
+            if( a != 1   &&   m_count > 0 )
+                throw cxx::exception( "CoupledNonlinearOscillators: stride must be coprime with the number of oscillators" );
             }
 
         Parameters helpOnParameters() const
@@ -79,6 +91,8 @@ class CoupledNonlinearOscillators :
             result["c0"] = "Coefficient at x^2/2 in potential energy (linear stiffness)";
             result["c2"] = "Coefficient at x^4/4 in potential energy (cubic stiffness)";
             result["f"] = "Constant force due to which there are oscillations with zero initial state";
+            result["stride"] = "Oscillator j of the chain has index j*stride mod n in the state;\n"
+                               "values other than 1 scramble the Jacobian pattern";
             return result;
             }
 
@@ -94,6 +108,10 @@ class CoupledNonlinearOscillators :
         real_type m_c0;
         real_type m_c2;
         real_type m_f;
+        unsigned int m_stride;
+        unsigned int index( unsigned int j ) const {
+            return static_cast<unsigned int>( static_cast<unsigned long long>( j ) * m_stride % m_count );
+            }
         real_type force( real_type deformation ) const {
             return deformation * ( m_c0 + m_c2*deformation*deformation );
             }
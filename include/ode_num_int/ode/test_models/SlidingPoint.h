@@ -126,7 +126,7 @@ class SlidingPoint :
             real_type f;
             switch( m_frictionType ) {
                 case Atan:
-                    f = 2./M_PI * m_f0 * atan( v/m_v0 );
+                    f = real_type(2/M_PI) * m_f0 * atan( v/m_v0 );
                     break;
                 case Tabular:
                     f = v < m_v0 ?   m_f0 * v/m_v0 :   m_f0;
@@ -0,0 +1,61 @@
+// ThreadPool.h
+
+#ifndef _UTIL_THREADPOOL_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+#define _UTIL_THREADPOOL_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
+
+#include "../defs.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ctm {
+namespace sys {
+
+// Fixed set of threads executing loop iterations in parallel.
+// The thread calling parallelFor() takes part in the execution, therefore
+// a pool with threadCount threads owns threadCount-1 worker threads.
+class ODE_NUMINT_API ThreadPool
+    {
+    public:
+        explicit ThreadPool( unsigned int threadCount );
+        ~ThreadPool();
+
+        unsigned int threadCount() const {
+            return static_cast<unsigned int>( m_workers.size() ) + 1;
+            }
+
+        // Calls f(i) for each i in [0, count), and returns when all calls are completed.
+        // The order of calls and their distribution among threads is unspecified.
+        // f must not throw exceptions. Calls from different threads are serialized;
+        // a call made by f itself (a nested call of the same pool) runs inline in the calling thread.
+        void parallelFor( std::size_t count, const std::function<void(std::size_t)>& f );
+
+    private:
+        std::vector< std::thread > m_workers;
+        std::mutex m_callMutex;
+        std::mutex m_mutex;
+        std::condition_variable m_jobStarted;
+        std::condition_variable m_jobFinished;
+        const std::function<void(std::size_t)> *m_job;
+        std::size_t m_jobSize;
+        std::atomic<std::size_t> m_nextIndex;
+        unsigned long long m_generation;
+        std::size_t m_busyWorkers;
+        bool m_stop;
+
+        void workerLoop();
+        void runJob( const std::function<void(std::size_t)>& f, std::size_t count );
+
+        ThreadPool( const ThreadPool& ) = delete;
+        ThreadPool& operator=( const ThreadPool& ) = delete;
+    };
+
+} // end namespace sys
+} // end namespace ctm
+
+#endif // _UTIL_THREADPOOL_H_AB0B81B0_CF3E_424f_9766_BA04D388199F_
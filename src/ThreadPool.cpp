@@ -0,0 +1,91 @@
+// ThreadPool.cpp
+
+#include "ode_num_int/ThreadPool.h"
+
+namespace ctm {
+namespace sys {
+
+namespace {
+
+// The pool whose job the calling thread is executing, if any
+thread_local const ThreadPool *currentJobPool = nullptr;
+
+} // anonymous namespace
+
+ThreadPool::ThreadPool( unsigned int threadCount ) :
+    m_job( nullptr ),
+    m_jobSize( 0 ),
+    m_nextIndex( 0 ),
+    m_generation( 0 ),
+    m_busyWorkers( 0 ),
+    m_stop( false )
+    {
+    for( unsigned int i=1; i<threadCount; ++i )
+        m_workers.emplace_back( &ThreadPool::workerLoop, this );
+    }
+
+ThreadPool::~ThreadPool()
+    {
+        {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_stop = true;
+        }
+    m_jobStarted.notify_all();
+    for( auto& worker : m_workers )
+        worker.join();
+    }
+
+void ThreadPool::parallelFor( std::size_t count, const std::function<void(std::size_t)>& f )
+    {
+    // Nested calls from within f run inline: the workers are busy with the outer call,
+    // which holds m_callMutex until they finish
+    if( m_workers.empty() || count < 2 || currentJobPool == this ) {
+        for( std::size_t i=0; i<count; ++i )
+            f( i );
+        return;
+        }
+    std::lock_guard<std::mutex> callLock( m_callMutex );
+    std::unique_lock<std::mutex> lock( m_mutex );
+    m_job = &f;
+    m_jobSize = count;
+    m_nextIndex = 0;
+    m_busyWorkers = m_workers.size();
+    ++m_generation;
+    lock.unlock();
+    m_jobStarted.notify_all();
+    runJob( f, count );
+    lock.lock();
+    m_jobFinished.wait( lock, [this]() { return m_busyWorkers == 0; } );
+    m_job = nullptr;
+    }
+
+void ThreadPool::workerLoop()
+    {
+    unsigned long long generation = 0;
+    std::unique_lock<std::mutex> lock( m_mutex );
+    while( true ) {
+        m_jobStarted.wait( lock, [&]() { return m_stop || m_generation != generation; } );
+        if( m_stop )
+            return;
+        generation = m_generation;
+        auto job = m_job;
+        auto count = m_jobSize;
+        lock.unlock();
+        runJob( *job, count );
+        lock.lock();
+        if( --m_busyWorkers == 0 )
+            m_jobFinished.notify_one();
+        }
+    }
+
+void ThreadPool::runJob( const std::function<void(std::size_t)>& f, std::size_t count )
+    {
+    auto previousJobPool = currentJobPool;
+    currentJobPool = this;
+    for( auto i=m_nextIndex++; i<count; i=m_nextIndex++ )
+        f( i );
+    currentJobPool = previousJobPool;
+    }
+
+} // end namespace sys
+} // end namespace ctm
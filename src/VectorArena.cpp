@@ -0,0 +1,114 @@
+// VectorArena.cpp
+
+#include "ode_num_int/VectorArena.h"
+
+#include <new>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif // _WIN32
+
+namespace ctm {
+namespace math {
+
+namespace {
+
+// Points to the arena held by the innermost Scope object
+thread_local const std::shared_ptr<VectorArena> *currentVectorArena = nullptr;
+
+// Blocks of size class c have the size Alignment << c
+unsigned int sizeClass( std::size_t bytes )
+    {
+    unsigned int result = 0;
+    for( std::size_t size=VectorArena::Alignment; size<bytes; size<<=1 )
+        ++result;
+    return result;
+    }
+
+} // anonymous namespace
+
+VectorArena::Scope::Scope( const std::shared_ptr<VectorArena>& arena ) :
+    m_arena( arena ),
+    m_previous( currentVectorArena )
+    {
+    currentVectorArena = &m_arena;
+    }
+
+VectorArena::Scope::~Scope() {
+    currentVectorArena = m_previous;
+    }
+
+VectorArena::VectorArena() : m_heapAllocationCount( 0 )
+    {
+    }
+
+VectorArena::~VectorArena() {
+    clear();
+    }
+
+void *VectorArena::allocate( std::size_t bytes )
+    {
+    auto c = sizeClass( bytes );
+    if( c < m_freeBlocks.size() ) {
+        auto& freeBlocks = m_freeBlocks[c];
+        if( !freeBlocks.empty() ) {
+            auto result = freeBlocks.back();
+            freeBlocks.pop_back();
+            return result;
+            }
+        }
+    ++m_heapAllocationCount;
+    return alignedAllocate( Alignment << c );
+    }
+
+void VectorArena::deallocate( void *p, std::size_t bytes )
+    {
+    if( !p )
+        return;
+    auto c = sizeClass( bytes );
+    if( c >= m_freeBlocks.size() )
+        m_freeBlocks.resize( c + 1 );
+    m_freeBlocks[c].push_back( p );
+    }
+
+void VectorArena::clear()
+    {
+    for( auto& freeBlocks : m_freeBlocks ) {
+        for( auto p : freeBlocks )
+            alignedDeallocate( p );
+        freeBlocks.clear();
+        }
+    }
+
+std::shared_ptr<VectorArena> VectorArena::current() {
+    return currentVectorArena ? *currentVectorArena : std::shared_ptr<VectorArena>();
+    }
+
+void *VectorArena::alignedAllocate( std::size_t bytes )
+    {
+    if( bytes == 0 )
+        bytes = Alignment;
+#ifdef _WIN32
+    auto result = _aligned_malloc( bytes, Alignment );
+    if( !result )
+        throw std::bad_alloc();
+#else // _WIN32
+    void *result = nullptr;
+    if( posix_memalign( &result, Alignment, bytes ) != 0 )
+        throw std::bad_alloc();
+#endif // _WIN32
+    return result;
+    }
+
+void VectorArena::alignedDeallocate( void *p )
+    {
+#ifdef _WIN32
+    _aligned_free( p );
+#else // _WIN32
+    free( p );
+#endif // _WIN32
+    }
+
+} // end namespace math
+} // end namespace ctm
@@ -0,0 +1,522 @@
+// VectorKernels.cpp
+
+#include "ode_num_int/VectorKernels.h"
+#include "ode_num_int/ThreadPool.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CTM_MATH_VECTOR_KERNELS_X86
+#include <immintrin.h>
+#endif // (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+
+namespace ctm {
+namespace math {
+
+namespace {
+
+// Sums are accumulated in 16 interleaved partial sums s[0..15] (s[j] collects elements
+// with indices i, i%16 == j), which are then combined pairwise in a fixed order;
+// the remaining elements are added sequentially. Every implementation follows this
+// order exactly, so the results do not depend on the implementation selected.
+const std::size_t Lanes = 16;
+
+inline double combineLanes( const double *s )
+    {
+    double t[8];
+    for( unsigned int j=0; j<8; ++j )
+        t[j] = s[j] + s[j+8];
+    double u[4];
+    for( unsigned int j=0; j<4; ++j )
+        u[j] = t[j] + t[j+4];
+    return ( u[0] + u[2] ) + ( u[1] + u[3] );
+    }
+
+namespace portable {
+
+double dot( const double *a, const double *b, std::size_t n )
+    {
+    double s[Lanes] = {};
+    std::size_t i = 0;
+    for( ; i+Lanes<=n; i+=Lanes )
+        for( unsigned int j=0; j<Lanes; ++j )
+            s[j] += a[i+j] * b[i+j];
+    double result = combineLanes( s );
+    for( ; i<n; ++i )
+        result += a[i] * b[i];
+    return result;
+    }
+
+double infNorm( const double *a, std::size_t n )
+    {
+    double result = 0;
+    for( std::size_t i=0; i<n; ++i )
+        result = std::max( result, std::fabs( a[i] ) );
+    return result;
+    }
+
+double oneNorm( const double *a, std::size_t n )
+    {
+    double s[Lanes] = {};
+    std::size_t i = 0;
+    for( ; i+Lanes<=n; i+=Lanes )
+        for( unsigned int j=0; j<Lanes; ++j )
+            s[j] += std::fabs( a[i+j] );
+    double result = combineLanes( s );
+    for( ; i<n; ++i )
+        result += std::fabs( a[i] );
+    return result;
+    }
+
+double euclideanNormSquare( const double *a, std::size_t n ) {
+    return dot( a, a, n );
+    }
+
+void add( double *dst, const double *src, std::size_t n )
+    {
+    for( std::size_t i=0; i<n; ++i )
+        dst[i] += src[i];
+    }
+
+void subtract( double *dst, const double *src, std::size_t n )
+    {
+    for( std::size_t i=0; i<n; ++i )
+        dst[i] -= src[i];
+    }
+
+void scale( double *dst, double factor, std::size_t n )
+    {
+    for( std::size_t i=0; i<n; ++i )
+        dst[i] *= factor;
+    }
+
+} // end namespace portable
+
+#ifdef CTM_MATH_VECTOR_KERNELS_X86
+
+#define CTM_TARGET_AVX2 __attribute__((target("avx2")))
+#define CTM_TARGET_AVX512 __attribute__((target("avx512f")))
+
+namespace avx2 {
+
+CTM_TARGET_AVX2 inline __m256d fabs4( __m256d x ) {
+    return _mm256_andnot_pd( _mm256_set1_pd( -0. ), x );
+    }
+
+CTM_TARGET_AVX2 inline double finish( __m256d s0, __m256d s1, __m256d s2, __m256d s3 )
+    {
+    double s[Lanes];
+    _mm256_storeu_pd( s, s0 );
+    _mm256_storeu_pd( s+4, s1 );
+    _mm256_storeu_pd( s+8, s2 );
+    _mm256_storeu_pd( s+12, s3 );
+    return combineLanes( s );
+    }
+
+CTM_TARGET_AVX2 double dot( const double *a, const double *b, std::size_t n )
+    {
+    __m256d s0 = _mm256_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+    std::size_t i = 0;
+    for( ; i+Lanes<=n; i+=Lanes ) {
+        s0 = _mm256_add_pd( s0, _mm256_mul_pd( _mm256_loadu_pd( a+i ), _mm256_loadu_pd( b+i ) ) );
+        s1 = _mm256_add_pd( s1, _mm256_mul_pd( _mm256_loadu_pd( a+i+4 ), _mm256_loadu_pd( b+i+4 ) ) );
+        s2 = _mm256_add_pd( s2, _mm256_mul_pd( _mm256_loadu_pd( a+i+8 ), _mm256_loadu_pd( b+i+8 ) ) );
+        s3 = _mm256_add_pd( s3, _mm256_mul_pd( _mm256_loadu_pd( a+i+12 ), _mm256_loadu_pd( b+i+12 ) ) );
+        }
+    double result = finish( s0, s1, s2, s3 );
+    for( ; i<n; ++i )
+        result += a[i] * b[i];
+    return result;
+    }
+
+CTM_TARGET_AVX2 double infNorm( const double *a, std::size_t n )
+    {
+    // Note: _mm256_max_pd returns the second operand if any of the operands is NaN,
+    // therefore NaNs are skipped, as in the portable implementation.
+    __m256d m = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for( ; i+4<=n; i+=4 )
+        m = _mm256_max_pd( fabs4( _mm256_loadu_pd( a+i ) ), m );
+    double s[4];
+    _mm256_storeu_pd( s, m );
+    double result = std::max( std::max( s[0], s[1] ), std::max( s[2], s[3] ) );
+    for( ; i<n; ++i )
+        result = std::max( result, std::fabs( a[i] ) );
+    return result;
+    }
+
+CTM_TARGET_AVX2 double oneNorm( const double *a, std::size_t n )
+    {
+    __m256d s0 = _mm256_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+    std::size_t i = 0;
+    for( ; i+Lanes<=n; i+=Lanes ) {
+        s0 = _mm256_add_pd( s0, fabs4( _mm256_loadu_pd( a+i ) ) );
+        s1 = _mm256_add_pd( s1, fabs4( _mm256_loadu_pd( a+i+4 ) ) );
+        s2 = _mm256_add_pd( s2, fabs4( _mm256_loadu_pd( a+i+8 ) ) );
+        s3 = _mm256_add_pd( s3, fabs4( _mm256_loadu_pd( a+i+12 ) ) );
+        }
+    double result = finish( s0, s1, s2, s3 );
+    for( ; i<n; ++i )
+        result += std::fabs( a[i] );
+    return result;
+    }
+
+CTM_TARGET_AVX2 double euclideanNormSquare( const double *a, std::size_t n ) {
+    return dot( a, a, n );
+    }
+
+CTM_TARGET_AVX2 void add( double *dst, const double *src, std::size_t n )
+    {
+    std::size_t i = 0;
+    for( ; i+4<=n; i+=4 )
+        _mm256_storeu_pd( dst+i, _mm256_add_pd( _mm256_loadu_pd( dst+i ), _mm256_loadu_pd( src+i ) ) );
+    for( ; i<n; ++i )
+        dst[i] += src[i];
+    }
+
+CTM_TARGET_AVX2 void subtract( double *dst, const double *src, std::size_t n )
+    {
+    std::size_t i = 0;
+    for( ; i+4<=n; i+=4 )
+        _mm256_storeu_pd( dst+i, _mm256_sub_pd( _mm256_loadu_pd( dst+i ), _mm256_loadu_pd( src+i ) ) );
+    for( ; i<n; ++i )
+        dst[i] -= src[i];
+    }
+
+CTM_TARGET_AVX2 void scale( double *dst, double factor, std::size_t n )
+    {
+    __m256d f = _mm256_set1_pd( factor );
+    std::size_t i = 0;
+    for( ; i+4<=n; i+=4 )
+        _mm256_storeu_pd( dst+i, _mm256_mul_pd( _mm256_loadu_pd( dst+i ), f ) );
+    for( ; i<n; ++i )
+        dst[i] *= factor;
+    }
+
+} // end namespace avx2
+
+namespace avx512 {
+
+CTM_TARGET_AVX512 inline __m512d fabs8( __m512d x ) {
+    return _mm512_castsi512_pd( _mm512_and_epi64(
+        _mm512_castpd_si512( x ), _mm512_set1_epi64( 0x7fffffffffffffffll ) ) );
+    }
+
+CTM_TARGET_AVX512 inline double finish( __m512d s0, __m512d s1 )
+    {
+    double s[Lanes];
+    _mm512_storeu_pd( s, s0 );
+    _mm512_storeu_pd( s+8, s1 );
+    return combineLanes( s );
+    }
+
+CTM_TARGET_AVX512 double dot( const double *a, const double *b, std::size_t n )
+    {
+    __m512d s0 = _mm512_setzero_pd(), s1 = s0;
+    std::size_t i = 0;
+    for( ; i+Lanes<=n; i+=Lanes ) {
+        s0 = _mm512_add_pd( s0, _mm512_mul_pd( _mm512_loadu_pd( a+i ), _mm512_loadu_pd( b+i ) ) );
+        s1 = _mm512_add_pd( s1, _mm512_mul_pd( _mm512_loadu_pd( a+i+8 ), _mm512_loadu_pd( b+i+8 ) ) );
+        }
+    double result = finish( s0, s1 );
+    for( ; i<n; ++i )
+        result += a[i] * b[i];
+    return result;
+    }
+
+CTM_TARGET_AVX512 double infNorm( const double *a, std::size_t n )
+    {
+    // See the note in avx2::infNorm() on NaN handling.
+    __m512d m = _mm512_setzero_pd();
+    std::size_t i = 0;
+    // The full-mask form takes m as the pass-through operand; _mm512_max_pd() would take
+    // an undefined vector there, which GCC reports as maybe-uninitialized.
+    for( ; i+8<=n; i+=8 )
+        m = _mm512_mask_max_pd( m, 0xff, fabs8( _mm512_loadu_pd( a+i ) ), m );
+    double s[8];
+    _mm512_storeu_pd( s, m );
+    double result = 0;
+    for( unsigned int j=0; j<8; ++j )
+        result = std::max( result, s[j] );
+    for( ; i<n; ++i )
+        result = std::max( result, std::fabs( a[i] ) );
+    return result;
+    }
+
+CTM_TARGET_AVX512 double oneNorm( const double *a, std::size_t n )
+    {
+    __m512d s0 = _mm512_setzero_pd(), s1 = s0;
+    std::size_t i = 0;
+    for( ; i+Lanes<=n; i+=Lanes ) {
+        s0 = _mm512_add_pd( s0, fabs8( _mm512_loadu_pd( a+i ) ) );
+        s1 = _mm512_add_pd( s1, fabs8( _mm512_loadu_pd( a+i+8 ) ) );
+        }
+    double result = finish( s0, s1 );
+    for( ; i<n; ++i )
+        result += std::fabs( a[i] );
+    return result;
+    }
+
+CTM_TARGET_AVX512 double euclideanNormSquare( const double *a, std::size_t n ) {
+    return dot( a, a, n );
+    }
+
+CTM_TARGET_AVX512 void add( double *dst, const double *src, std::size_t n )
+    {
+    std::size_t i = 0;
+    for( ; i+8<=n; i+=8 )
+        _mm512_storeu_pd( dst+i, _mm512_add_pd( _mm512_loadu_pd( dst+i ), _mm512_loadu_pd( src+i ) ) );
+    for( ; i<n; ++i )
+        dst[i] += src[i];
+    }
+
+CTM_TARGET_AVX512 void subtract( double *dst, const double *src, std::size_t n )
+    {
+    std::size_t i = 0;
+    for( ; i+8<=n; i+=8 )
+        _mm512_storeu_pd( dst+i, _mm512_sub_pd( _mm512_loadu_pd( dst+i ), _mm512_loadu_pd( src+i ) ) );
+    for( ; i<n; ++i )
+        dst[i] -= src[i];
+    }
+
+CTM_TARGET_AVX512 void scale( double *dst, double factor, std::size_t n )
+    {
+    __m512d f = _mm512_set1_pd( factor );
+    std::size_t i = 0;
+    for( ; i+8<=n; i+=8 )
+        _mm512_storeu_pd( dst+i, _mm512_mul_pd( _mm512_loadu_pd( dst+i ), f ) );
+    for( ; i<n; ++i )
+        dst[i] *= factor;
+    }
+
+} // end namespace avx512
+
+#undef CTM_TARGET_AVX2
+#undef CTM_TARGET_AVX512
+
+#endif // CTM_MATH_VECTOR_KERNELS_X86
+
+struct KernelTable
+    {
+    const char *name;
+    bool (*supported)();
+    double (*dot)( const double*, const double*, std::size_t );
+    double (*infNorm)( const double*, std::size_t );
+    double (*oneNorm)( const double*, std::size_t );
+    double (*euclideanNormSquare)( const double*, std::size_t );
+    void (*add)( double*, const double*, std::size_t );
+    void (*subtract)( double*, const double*, std::size_t );
+    void (*scale)( double*, double, std::size_t );
+    };
+
+bool alwaysSupported() {
+    return true;
+    }
+
+#ifdef CTM_MATH_VECTOR_KERNELS_X86
+bool avx2Supported() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" );
+    }
+
+bool avx512Supported() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx512f" );
+    }
+#endif // CTM_MATH_VECTOR_KERNELS_X86
+
+#define CTM_VECTOR_KERNEL_TABLE_ENTRY( name, supported ) \
+    { #name, supported, name::dot, name::infNorm, name::oneNorm, name::euclideanNormSquare, name::add, name::subtract, name::scale }
+
+// Implementations in the order of preference
+const KernelTable kernelTables[] = {
+#ifdef CTM_MATH_VECTOR_KERNELS_X86
+    CTM_VECTOR_KERNEL_TABLE_ENTRY( avx512, avx512Supported ),
+    CTM_VECTOR_KERNEL_TABLE_ENTRY( avx2, avx2Supported ),
+#endif // CTM_MATH_VECTOR_KERNELS_X86
+    CTM_VECTOR_KERNEL_TABLE_ENTRY( portable, alwaysSupported )
+    };
+
+#undef CTM_VECTOR_KERNEL_TABLE_ENTRY
+
+const KernelTable *selectKernels()
+    {
+    for( const auto& table : kernelTables )
+        if( table.supported() )
+            return &table;
+    return nullptr;   // Unreachable: the portable implementation is always supported
+    }
+
+const KernelTable*& kernels()
+    {
+    static const KernelTable *result = selectKernels();
+    return result;
+    }
+
+std::unique_ptr< sys::ThreadPool >& threadPool()
+    {
+    static std::unique_ptr< sys::ThreadPool > result;
+    return result;
+    }
+
+inline std::size_t chunkCount( std::size_t n ) {
+    return ( n + VectorKernels::ChunkSize - 1 ) / VectorKernels::ChunkSize;
+    }
+
+// Reduces the range [0, n) chunk by chunk: partial(begin, end) computes the value for
+// a chunk, and combine(a, b) accumulates the values in the order of chunks.
+template< class Partial, class Combine >
+double reduce( std::size_t n, Partial partial, Combine combine )
+    {
+    const auto ChunkSize = VectorKernels::ChunkSize;
+    if( n <= ChunkSize )
+        return partial( 0, n );
+    double result;
+    if( VectorKernels::isParallel( n ) ) {
+        auto count = chunkCount( n );
+        // Note: the lambda below runs on other threads, so it must capture a reference
+        // to this thread's buffer rather than name the thread-local variable directly
+        thread_local std::vector<double> buffer;
+        auto& partials = buffer;
+        partials.resize( count );
+        auto body = [&]( std::size_t chunk ) {
+            auto begin = chunk * ChunkSize;
+            partials[chunk] = partial( begin, std::min( begin + ChunkSize, n ) );
+            };
+        threadPool()->parallelFor( count, std::ref( body ) );
+        result = partials[0];
+        for( std::size_t chunk=1; chunk<count; ++chunk )
+            result = combine( result, partials[chunk] );
+        }
+    else {
+        result = partial( 0, ChunkSize );
+        for( std::size_t begin=ChunkSize; begin<n; begin+=ChunkSize )
+            result = combine( result, partial( begin, std::min( begin + ChunkSize, n ) ) );
+        }
+    return result;
+    }
+
+inline double sum( double a, double b ) {
+    return a + b;
+    }
+
+inline double maximum( double a, double b ) {
+    return std::max( a, b );
+    }
+
+} // anonymous namespace
+
+const std::size_t VectorKernels::ChunkSize;
+
+double VectorKernels::dot( const double *a, const double *b, std::size_t n )
+    {
+    auto k = kernels();
+    return reduce( n, [&]( std::size_t begin, std::size_t end ) {
+        return k->dot( a + begin, b + begin, end - begin );
+        }, sum );
+    }
+
+double VectorKernels::infNorm( const double *a, std::size_t n )
+    {
+    auto k = kernels();
+    return reduce( n, [&]( std::size_t begin, std::size_t end ) {
+        return k->infNorm( a + begin, end - begin );
+        }, maximum );
+    }
+
+double VectorKernels::oneNorm( const double *a, std::size_t n )
+    {
+    auto k = kernels();
+    return reduce( n, [&]( std::size_t begin, std::size_t end ) {
+        return k->oneNorm( a + begin, end - begin );
+        }, sum );
+    }
+
+double VectorKernels::euclideanNormSquare( const double *a, std::size_t n )
+    {
+    auto k = kernels();
+    return reduce( n, [&]( std::size_t begin, std::size_t end ) {
+        return k->euclideanNormSquare( a + begin, end - begin );
+        }, sum );
+    }
+
+void VectorKernels::add( double *dst, const double *src, std::size_t n )
+    {
+    auto k = kernels();
+    forEachChunk( n, [&]( std::size_t begin, std::size_t end ) {
+        k->add( dst + begin, src + begin, end - begin );
+        } );
+    }
+
+void VectorKernels::subtract( double *dst, const double *src, std::size_t n )
+    {
+    auto k = kernels();
+    forEachChunk( n, [&]( std::size_t begin, std::size_t end ) {
+        k->subtract( dst + begin, src + begin, end - begin );
+        } );
+    }
+
+void VectorKernels::scale( double *dst, double factor, std::size_t n )
+    {
+    auto k = kernels();
+    forEachChunk( n, [&]( std::size_t begin, std::size_t end ) {
+        k->scale( dst + begin, factor, end - begin );
+        } );
+    }
+
+const char *VectorKernels::implementation() {
+    return kernels()->name;
+    }
+
+bool VectorKernels::setImplementation( const char *name )
+    {
+    for( const auto& table : kernelTables )
+        if( strcmp( table.name, name ) == 0 ) {
+            if( !table.supported() )
+                return false;
+            kernels() = &table;
+            return true;
+            }
+    return false;
+    }
+
+unsigned int VectorKernels::threadCount()
+    {
+    auto& pool = threadPool();
+    return pool ? pool->threadCount() : 1;
+    }
+
+void VectorKernels::setThreadCount( unsigned int threadCount )
+    {
+    auto& pool = threadPool();
+    if( threadCount > 1 )
+        pool.reset( new sys::ThreadPool( threadCount ) );
+    else
+        pool.reset();
+    }
+
+void VectorKernels::parallelFor( std::size_t count, const std::function<void(std::size_t)>& f )
+    {
+    auto& pool = threadPool();
+    if( pool )
+        pool->parallelFor( count, f );
+    else
+        for( std::size_t i=0; i<count; ++i )
+            f( i );
+    }
+
+void VectorKernels::parallelForEachChunk( std::size_t n, const std::function<void(std::size_t, std::size_t)>& f )
+    {
+    auto body = [&]( std::size_t chunk ) {
+        auto begin = chunk * ChunkSize;
+        f( begin, std::min( begin + ChunkSize, n ) );
+        };
+    threadPool()->parallelFor( chunkCount( n ), std::ref( body ) );
+    }
+
+} // end namespace math
+} // end namespace ctm
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include "ode_num_int/OdeNumIntClassesRegistrator.h"
+#include "ode_num_int/OdeTestModelClassesRegistrator.h"
+#include "ode_num_int/EnsembleOdeRhs.h"
+
+using namespace ctm;
+using namespace ctm::math;
+
+namespace {
+
+const unsigned int M = 4;
+typedef VectorData<double> VD;
+typedef EnsembleVectorData<double, M> EVD;
+
+std::shared_ptr< OdeRhs<VD> > newOscillator(unsigned int member)
+{
+    auto result = Factory< OdeRhs<VD> >::newInstance("oscillator");
+    OptionalParameters::Parameters p;
+    p["c"] = 1e3*(member + 1);
+    result->setParameters(p);
+    return result;
+}
+
+// Makes the solver do its next step with the specified step size; note that embedded RK solvers
+// only take the initial step size at the first step after the initial state is set
+template< class VD >
+void setNextStepSize(OdeSolver<VD>& solver, double h)
+{
+    solver.setInitialStepSize(h);
+    solver.setInitialState(solver.initialTime(), solver.initialState());
+}
+
+} // anonymous namespace
+
+TEST(EnsembleVectorData, StoresMembersInterleaved) {
+    VectorTemplate<EVD> x(3*M);
+    ASSERT_EQ(x.memberSize(), 3u);
+    Vector<double> member(3);
+    member[0] = 1;   member[1] = 2;   member[2] = 3;
+    x.setMember(1, member);
+    EXPECT_EQ(x[1], 1);
+    EXPECT_EQ(x[M+1], 2);
+    EXPECT_EQ(x.at(2, 1), 3);
+    x += x;
+    x.getMember(member, 1);
+    EXPECT_EQ(member[2], 6);
+}
+
+TEST(EnsembleVectorData, IntegratesMembersInLockstep) {
+    OdeNumIntClassesRegistrator<VD> r;
+    testmodels::OdeTestModelClassesRegistrator<VD> mr;
+    OdeNumIntClassesRegistrator<EVD> er;
+
+    std::vector< std::shared_ptr< OdeRhs<VD> > > members;
+    for (unsigned int i=0; i<M; ++i)
+        members.push_back(newOscillator(i));
+    auto ensembleRhs = std::make_shared< EnsembleOdeRhs<double, M> >(members);
+
+    VectorTemplate<EVD> x0(ensembleRhs->varCount());
+    for (unsigned int i=0; i<M; ++i)
+        x0.at(0, i) = 0.1*(i+1);
+
+    auto solver = Factory< OdeSolver<EVD> >::newInstance("rk4");
+    solver->setOdeRhs(ensembleRhs);
+    solver->setInitialStepSize(1e-3);
+    solver->setInitialState(0, x0);
+    for (int step=0; step<100; ++step)
+        solver->doStep();
+    auto x = solver->initialState();
+
+    // With the fixed step size, each member must evolve exactly as if it was integrated alone
+    for (unsigned int i=0; i<M; ++i) {
+        auto memberSolver = Factory< OdeSolver<VD> >::newInstance("rk4");
+        memberSolver->setOdeRhs(members[i]);
+        memberSolver->setInitialStepSize(1e-3);
+        Vector<double> y0;
+        x0.getMember(y0, i);
+        memberSolver->setInitialState(0, y0);
+        for (int step=0; step<100; ++step)
+            memberSolver->doStep();
+        Vector<double> y;
+        x.getMember(y, i);
+        auto yExpected = memberSolver->initialState();
+        for (unsigned int j=0; j<y.size(); ++j)
+            EXPECT_EQ(y[j], yExpected[j]);
+    }
+}
+
+TEST(EnsembleVectorData, SharesStepSizeOfEmbeddedMethod) {
+    OdeNumIntClassesRegistrator<VD> r;
+    testmodels::OdeTestModelClassesRegistrator<VD> mr;
+    OdeNumIntClassesRegistrator<EVD> er;
+
+    std::vector< std::shared_ptr< OdeRhs<VD> > > members;
+    for (unsigned int i=0; i<M; ++i)
+        members.push_back(newOscillator(i));
+    auto ensembleRhs = std::make_shared< EnsembleOdeRhs<double, M> >(members);
+
+    VectorTemplate<EVD> x0(ensembleRhs->varCount());
+    for (unsigned int i=0; i<M; ++i)
+        x0.at(0, i) = 0.1*(i+1);
+
+    // Integrate the ensemble with step size control, recording the accepted steps and their error norms
+    auto solver = Factory< OdeSolver<EVD> >::newInstance("dopri_45");
+    solver->setOdeRhs(ensembleRhs);
+    solver->setInitialStepSize(1e-3);
+    solver->setInitialState(0, x0);
+    std::vector<double> stepSizes, errorNorms;
+    solver->odeSolverPostObservers.add([&](const OdeSolverPostObserverArg<EVD>& arg) {
+        if (arg.stepAccepted()) {
+            stepSizes.push_back(arg.stepSize());
+            errorNorms.push_back(arg.errorNorm());
+        }
+    });
+    for (int step=0; step<200; ++step)
+        solver->doStep();
+    ASSERT_EQ(stepSizes.size(), 200u);
+    auto finalTime = solver->initialTime();
+    auto x = solver->initialState();
+
+    std::vector<double> maxMemberErrorNorms(stepSizes.size(), 0);
+    for (unsigned int i=0; i<M; ++i) {
+        Vector<double> y0, y;
+        x0.getMember(y0, i);
+        x.getMember(y, i);
+
+        // Each member must evolve exactly as if it was integrated alone with the steps of the ensemble
+        auto memberSolver = Factory< OdeSolver<VD> >::newInstance("dopri_45");
+        OptionalParameters::Parameters p;
+        p["disable_error_check"] = true;
+        p["force_error_calc"] = true;
+        memberSolver->setParameters(p);
+        memberSolver->setOdeRhs(members[i]);
+        memberSolver->setInitialState(0, y0);
+        double errorNorm = 0;
+        memberSolver->odeSolverPostObservers.add([&](const OdeSolverPostObserverArg<VD>& arg) {
+            errorNorm = arg.errorNorm();
+        });
+        for (unsigned int step=0; step<stepSizes.size(); ++step) {
+            setNextStepSize(*memberSolver, stepSizes[step]);
+            memberSolver->doStep();
+            maxMemberErrorNorms[step] = std::max(maxMemberErrorNorms[step], errorNorm);
+        }
+        auto yReplayed = memberSolver->initialState();
+        for (unsigned int j=0; j<y.size(); ++j)
+            EXPECT_EQ(y[j], yReplayed[j]);
+
+        // Each member must match its own run with step size control up to the tolerance
+        auto adaptiveSolver = Factory< OdeSolver<VD> >::newInstance("dopri_45");
+        adaptiveSolver->setOdeRhs(members[i]);
+        adaptiveSolver->setInitialStepSize(1e-3);
+        adaptiveSolver->setInitialState(0, y0);
+        while (adaptiveSolver->initialTime() < finalTime*(1 - 1e-12)) {
+            // Redo the step ending past the final time so that it ends exactly there
+            auto t = adaptiveSolver->initialTime();
+            auto yPrev = adaptiveSolver->initialState();
+            adaptiveSolver->doStep();
+            if (adaptiveSolver->initialTime() > finalTime) {
+                adaptiveSolver->setInitialState(t, yPrev);
+                setNextStepSize(*adaptiveSolver, finalTime - t);
+                adaptiveSolver->doStep();
+            }
+        }
+        EXPECT_DOUBLE_EQ(adaptiveSolver->initialTime(), finalTime);
+        auto yAlone = adaptiveSolver->initialState();
+        for (unsigned int j=0; j<y.size(); ++j)
+            EXPECT_NEAR(y[j], yAlone[j], 1e-4*(1 + std::fabs(yAlone[j]))) << "member " << i;
+    }
+
+    // The error norm controlling the shared step size must be the worst one over the members
+    for (unsigned int step=0; step<stepSizes.size(); ++step)
+        EXPECT_EQ(errorNorms[step], maxMemberErrorNorms[step]);
+}
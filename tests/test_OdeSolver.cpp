@@ -0,0 +1,516 @@
+#include <gtest/gtest.h>
+#include "ode_num_int/OdeNumIntClassesRegistrator.h"
+#include "ode_num_int/OdeTestModelClassesRegistrator.h"
+#include "ode_num_int/OdeSolverExtrapolator.h"
+#include "ode_num_int/ExtrapolatorStepSequenceHarmonic.h"
+#include "ode_num_int/SparseMatrixIO.h"
+#include "ode_num_int/FixedVectorData.h"
+#include "ode_num_int/VectorNarrowingMapping.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+using namespace ctm;
+using namespace ctm::math;
+
+namespace {
+
+std::atomic<bool> countingAllocations( false );
+std::atomic<unsigned long> allocationCount( 0 );
+
+// Counts the calls of the global operator new while alive
+class AllocationCounter
+{
+public:
+    AllocationCounter() {
+        allocationCount = 0;
+        countingAllocations = true;
+    }
+    ~AllocationCounter() {
+        countingAllocations = false;
+    }
+    unsigned long count() const {
+        return allocationCount;
+    }
+};
+
+typedef VectorData<double> VD;
+
+} // anonymous namespace
+
+// The replacements of all the usual forms of the global operators new and delete, so that
+// allocations and deallocations always pair with each other
+void *operator new(std::size_t size)
+{
+    if (countingAllocations)
+        ++allocationCount;
+    if (auto result = std::malloc(size ? size : 1))
+        return result;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+namespace {
+
+// Sets the coupled nonlinear oscillators model with 20 degrees of freedom as the ODE right hand side,
+// the initial state with small displacements, and the initial step size 1e-4
+void initCoupledOscillators(OdeSolver<VD>& solver, unsigned int stride = 1)
+{
+    auto rhs = Factory< OdeRhs<VD> >::newInstance("coupled_nl_osc");
+    OptionalParameters::Parameters p;
+    p["n"] = 20u;
+    p["stride"] = stride;
+    rhs->setParameters(p);
+    solver.setOdeRhs(rhs);
+    solver.setInitialStepSize(1e-4);
+    Vector<double> x0(rhs->varCount());
+    for (unsigned int i=0; i<x0.size(); ++i)
+        x0[i] = 0.01*(i%7);
+    solver.setInitialState(0, x0);
+}
+
+// Does the specified number of steps and returns the final state
+Vector<double> doSteps(OdeSolver<VD>& solver, int stepCount)
+{
+    for (int step=0; step<stepCount; ++step)
+        solver.doStep();
+    return solver.initialState();
+}
+
+} // anonymous namespace
+
+TEST(OdeSolver, DoesNotAllocateMemoryInSteps) {
+    OdeNumIntClassesRegistrator<VD> r;
+    testmodels::OdeTestModelClassesRegistrator<VD> mr;
+
+    for (auto solverName : { "rk4", "dopri_45", "rosenbrock_sw2_4", "i_euler", "extrapolator" }) {
+        auto solver = Factory< OdeSolver<VD> >::newInstance(solverName);
+        if (auto extrapolator = std::dynamic_pointer_cast< OdeSolverExtrapolator<VD> >(solver)) {
+            extrapolator->setReferenceSolver(Factory< OdeSolver<VD> >::newInstance("gragg"));
+            extrapolator->setStepSequence(std::make_shared<ExtrapolatorStepSequenceHarmonic>());
+        }
+        if (std::dynamic_pointer_cast< OdeSolverLUSettings<VD> >(solver)) {
+            // Each new step size needs a new decomposition of W, which only reuses memory
+            // once the cache of decompositions is full
+            OptionalParameters::Parameters sp;
+            sp["lu_cache"] = 4u;
+            solver->setParameters(sp);
+        }
+        initCoupledOscillators(*solver);
+
+        // Warm-up steps, during which solvers allocate their buffers and caches
+        doSteps(*solver, 100);
+
+        auto arenaAllocationCount = solver->vectorArena()->heapAllocationCount();
+        AllocationCounter counter;
+        doSteps(*solver, 1000);
+        EXPECT_EQ(counter.count(), 0u) << solverName;
+        EXPECT_EQ(solver->vectorArena()->heapAllocationCount(), arenaAllocationCount) << solverName;
+    }
+}
+
+namespace {
+
+// Solves the linear oscillator x'' = f - c*x, x(0) = x'(0) = 0 until time 0.1,
+// and returns the relative error, computed using the exact solution x = f/c*(1 - cos(w*t)), w^2 = c.
+template< class VD >
+double oscillatorSolutionError(const std::string& solverName)
+{
+    auto rhs = Factory< OdeRhs<VD> >::newInstance("oscillator");
+    auto solver = Factory< OdeSolver<VD> >::newInstance(solverName);
+    if (auto extrapolator = std::dynamic_pointer_cast< OdeSolverExtrapolator<VD> >(solver)) {
+        extrapolator->setReferenceSolver(Factory< OdeSolver<VD> >::newInstance("gragg"));
+        extrapolator->setStepSequence(std::make_shared<ExtrapolatorStepSequenceHarmonic>());
+    }
+    solver->setOdeRhs(rhs);
+    solver->setInitialStepSize(1e-3f);
+    solver->setInitialState(0, VectorTemplate<VD>(rhs->varCount()));
+    while (solver->initialTime() < 0.1f)
+        solver->doStep();
+
+    const double c = 1e3,   f = 100;
+    auto w = std::sqrt(c);
+    double t = solver->initialTime();
+    auto x = solver->initialState();
+    return std::max(
+        std::fabs(x[0] - f/c*(1 - std::cos(w*t))) / (f/c),
+        std::fabs(x[1] - f/c*w*std::sin(w*t)) / (f/c*w));
+}
+
+} // anonymous namespace
+
+TEST(OdeSolver, WorksInSinglePrecision) {
+    typedef VectorData<float> FVD;
+    OdeNumIntClassesRegistrator<FVD> r;
+    testmodels::OdeTestModelClassesRegistrator<FVD> mr;
+    OdeNumIntClassesRegistrator<VD> dr;
+    testmodels::OdeTestModelClassesRegistrator<VD> dmr;
+
+    // Single precision must not notably increase the error of any solver
+    for (auto solverName : { "euler", "rk4", "dopri_45", "dopri_56", "dopri_78", "gragg",
+                             "rosenbrock_w1", "rosenbrock_sw2_4", "i_euler", "extrapolator" }) {
+        auto error = oscillatorSolutionError<FVD>(solverName);
+        auto doubleError = oscillatorSolutionError<VD>(solverName);
+        EXPECT_LT(error, 2*doubleError + 1e-4) << solverName;
+    }
+}
+
+namespace {
+
+// Solves the specified model with the specified solver from the state x[i] = 0.1*(i+1) until time 0.1,
+// and returns the final time followed by the final state
+template< class VD >
+std::vector<double> finalTimeAndState(const std::string& modelName, const std::string& solverName)
+{
+    auto rhs = Factory< OdeRhs<VD> >::newInstance(modelName);
+    auto solver = Factory< OdeSolver<VD> >::newInstance(solverName);
+    if (auto extrapolator = std::dynamic_pointer_cast< OdeSolverExtrapolator<VD> >(solver)) {
+        extrapolator->setReferenceSolver(Factory< OdeSolver<VD> >::newInstance("gragg"));
+        extrapolator->setStepSequence(std::make_shared<ExtrapolatorStepSequenceHarmonic>());
+    }
+    solver->setOdeRhs(rhs);
+    solver->setInitialStepSize(1e-3);
+    VectorTemplate<VD> x0(rhs->varCount());
+    for (unsigned int i=0; i<x0.size(); ++i)
+        x0[i] = 0.1*(i+1);
+    solver->setInitialState(0, x0);
+    while (solver->initialTime() < 0.1)
+        solver->doStep();
+    std::vector<double> result(1, solver->initialTime());
+    auto x = solver->initialState();
+    result.insert(result.end(), x.begin(), x.end());
+    return result;
+}
+
+template< std::size_t N >
+void expectSameSolutionWithFixedVectorData(const std::string& modelName)
+{
+    typedef FixedVectorData<double, N> FVD;
+    OdeNumIntClassesRegistrator<FVD> r;
+    testmodels::OdeTestModelClassesRegistrator<FVD> mr;
+
+    for (auto solverName : { "euler", "rk4", "dopri_45", "dopri_56", "dopri_78", "gragg",
+                             "rosenbrock_w1", "rosenbrock_sw2_4", "i_euler", "extrapolator" }) {
+        auto x = finalTimeAndState<VD>(modelName, solverName);
+        auto y = finalTimeAndState<FVD>(modelName, solverName);
+        ASSERT_EQ(x.size(), N+1) << modelName << ", " << solverName;
+        ASSERT_EQ(y.size(), N+1) << modelName << ", " << solverName;
+        for (unsigned int i=0; i<=N; ++i)
+            EXPECT_EQ(x[i], y[i]) << modelName << ", " << solverName << ", " << i;
+    }
+}
+
+} // anonymous namespace
+
+TEST(OdeSolver, WorksWithFixedVectorData) {
+    OdeNumIntClassesRegistrator<VD> r;
+    testmodels::OdeTestModelClassesRegistrator<VD> mr;
+
+    // Solvers instantiated with the fixed size vector data must give bitwise identical results
+    expectSameSolutionWithFixedVectorData<2>("oscillator");
+    expectSameSolutionWithFixedVectorData<4>("sliding_point");
+}
+
+TEST(OdeSolver, ReordersLinearSystems) {
+    OdeNumIntClassesRegistrator<VD> r;
+    testmodels::OdeTestModelClassesRegistrator<VD> mr;
+
+    // The oscillators are scrambled in the state, so that the Jacobian is not banded;
+    // reordering must reduce the envelope and must not notably change the solution
+    for (auto solverName : { "rosenbrock_sw2_4", "i_euler" }) {
+        std::vector< Vector<double> > solutions;
+        for (bool reorder : { false, true }) {
+            auto solver = Factory< OdeSolver<VD> >::newInstance(solverName);
+            if (reorder) {
+                OptionalParameters::Parameters sp;
+                sp["reorder"] = std::string(solverName) == "i_euler"? "auto": "rcm";
+                solver->setParameters(sp);
+            }
+            initCoupledOscillators(*solver, 7);
+            solutions.push_back(doSteps(*solver, 100));
+            if (reorder) {
+                EXPECT_GT(solver->reorderingStats.envelopeBefore, 0u) << solverName;
+                EXPECT_LT(solver->reorderingStats.envelopeAfter, solver->reorderingStats.envelopeBefore) << solverName;
+            }
+        }
+        auto& x = solutions[0];
+        auto& y = solutions[1];
+        for (unsigned int i=0; i<x.size(); ++i)
+            EXPECT_NEAR(x[i], y[i], 1e-9*(1 + std::fabs(x[i]))) << solverName;
+    }
+}
+
+TEST(OdeSolver, SupportsLUFactorizerKinds) {
+    OdeNumIntClassesRegistrator<VD> r;
+    testmodels::OdeTestModelClassesRegistrator<VD> mr;
+
+    // The sparse and the mixed precision LU factorizers must not notably change the solution
+    for (auto solverName : { "rosenbrock_sw2_4", "i_euler" }) {
+        std::vector< Vector<double> > solutions;
+        for (auto luKind : { "skyline", "sparse", "mixed" }) {
+            auto solver = Factory< OdeSolver<VD> >::newInstance(solverName);
+            OptionalParameters::Parameters sp;
+            sp["lu"] = luKind;
+            if (auto ie = std::dynamic_pointer_cast< OdeSolverImplicitEuler<VD> >(solver))
+                ie->newtonSolver()->iterationPerformer()->newtonDescentDirection()->setParameters(sp);
+            else
+                solver->setParameters(sp);
+            initCoupledOscillators(*solver);
+            solutions.push_back(doSteps(*solver, 100));
+        }
+        auto& x = solutions[0];
+        for (unsigned int k=1; k<solutions.size(); ++k) {
+            auto& y = solutions[k];
+            for (unsigned int i=0; i<x.size(); ++i)
+                EXPECT_NEAR(x[i], y[i], 1e-9*(1 + std::fabs(x[i]))) << solverName << ", " << k;
+        }
+    }
+}
+
+TEST(OdeSolver, SupportsLimitedMemoryBroydenDescentDirection) {
+    OdeNumIntClassesRegistrator<VD> r;
+    testmodels::OdeTestModelClassesRegistrator<VD> mr;
+
+    // The Newton's method with Broyden updates must converge to the same solution
+    std::vector< Vector<double> > solutions;
+    for (auto ddirName : { "simple", "lm-broyden" }) {
+        auto solver = std::make_shared< OdeSolverImplicitEuler<VD> >();
+        auto newton = solver->newtonSolver();
+        auto ddir = Factory< NewtonDescentDirection<VD> >::newInstance(ddirName);
+        OptionalParameters::Parameters dp;
+        dp["memory"] = 3u;
+        if (ddirName == std::string("lm-broyden"))
+            ddir->setParameters(dp);
+        ddir->setJacobianProvider(newton->iterationPerformer()->newtonDescentDirection()->jacobianProvider());
+        newton->setComponent(ddir);
+        initCoupledOscillators(*solver);
+        solutions.push_back(doSteps(*solver, 100));
+    }
+    auto& x = solutions[0];
+    auto& y = solutions[1];
+    for (unsigned int i=0; i<x.size(); ++i)
+        EXPECT_NEAR(x[i], y[i], 1e-6*(1 + std::fabs(x[i])));
+}
+
+namespace {
+
+// Jacobian provider returning the same matrix each time the Jacobian is computed
+class ConstantJacobianProvider : public JacobianProvider<VD>
+{
+public:
+    explicit ConstantJacobianProvider(const FastSparseMatrix& J) : m_J0(J) {}
+    void computeJacobian(const V&) {
+        m_J = m_J0;
+    }
+    FastSparseMatrix& jacobian() {
+        return m_J;
+    }
+private:
+    FastSparseMatrix m_J0;
+    FastSparseMatrix m_J;
+};
+
+} // anonymous namespace
+
+TEST(NewtonDescentDirection, AppliesLimitedMemoryBroydenUpdates) {
+    typedef VectorTemplate<VD> V;
+    typedef JacobianProvider<VD>::FastSparseMatrix FastSparseMatrix;
+    const unsigned int n = 5, memory = 3, pointCount = 9;
+
+    // Points x[k] and the values f[k] of a nonlinear function at them, and the Jacobian of the function at x[0]
+    auto fun = [](const V& x) {
+        V f(n);
+        for (unsigned int i=0; i<n; ++i)
+            f[i] = 4*x[i] + x[(i+1)%n] - 0.5*x[(i+3)%n] + 0.3*std::sin(2*x[i]) + 0.2*x[i]*x[(i+2)%n];
+        return f;
+    };
+    std::vector<V> x(pointCount), f(pointCount);
+    for (unsigned int k=0; k<pointCount; ++k) {
+        x[k].resize(n);
+        for (unsigned int i=0; i<n; ++i)
+            x[k][i] = 0.3*std::sin(1.3*k + 0.7*i) + 0.1*k;
+        f[k] = fun(x[k]);
+    }
+    // Note: the pattern of J is dense, as the dense Broyden method needs it
+    sparse::SparseMatrix<double> Jd(n, n);
+    for (unsigned int i=0; i<n; ++i)
+        for (unsigned int j=0; j<n; ++j)
+            Jd.at(i, j) = 0;
+    for (unsigned int i=0; i<n; ++i) {
+        Jd.at(i, i) += 4 + 0.6*std::cos(2*x[0][i]) + 0.2*x[0][(i+2)%n];
+        Jd.at(i, (i+1)%n) += 1;
+        Jd.at(i, (i+3)%n) += -0.5;
+        Jd.at(i, (i+2)%n) += 0.2*x[0][i];
+    }
+    FastSparseMatrix J;
+    J = Jd;
+
+    // Directions of the dense Broyden method started with J at x[begin] and updated at each next point up to x[end]
+    auto denseDirection = [&](unsigned int begin, unsigned int end) {
+        JacobianBroydenUpdateNewtonDescentDirection<VD> dense;
+        dense.setJacobianProvider(std::make_shared<ConstantJacobianProvider>(J));
+        V dir;
+        for (unsigned int k=begin; k<=end; ++k)
+            dense.computeDescentDirection(dir, x[k], f[k], k-begin);
+        return dir;
+    };
+    auto expectNear = [](const V& a, const V& b, unsigned int k) {
+        for (unsigned int i=0; i<n; ++i)
+            EXPECT_NEAR(a[i], b[i], 1e-12*(1 + std::fabs(b[i]))) << "point " << k;
+    };
+
+    LimitedMemoryBroydenNewtonDescentDirection<VD> lm;
+    OptionalParameters::Parameters p;
+    p["memory"] = memory;
+    lm.setParameters(p);
+    lm.setJacobianProvider(std::make_shared<ConstantJacobianProvider>(J));
+    V dir, frozenDir;
+    for (unsigned int k=0; k<pointCount; ++k) {
+        lm.computeDescentDirection(dir, x[k], f[k], k);
+        EXPECT_EQ(lm.pairCount(), std::min(k, memory));
+        if (k <= memory)
+            // All pairs are kept, so the updates must be those of the dense Broyden method
+            expectNear(dir, denseDirection(0, k), k);
+        else
+            // Only the last 'memory' pairs are kept, so the updates must be those of the dense Broyden method restarted from J
+            expectNear(dir, denseDirection(k-memory, k), k);
+
+        // The updates must make a difference compared to the frozen Jacobian
+        frozenDir = denseDirection(k, k);
+        if (k > 0) {
+            double diff = 0;
+            for (unsigned int i=0; i<n; ++i)
+                diff = std::max(diff, std::fabs(dir[i] - frozenDir[i]));
+            EXPECT_GT(diff, 1e-3) << "point " << k;
+        }
+    }
+}
+
+namespace {
+
+// Mapping from R^4 to R^5, y[i] = 10*i + x[0] + 2*x[1] + 3*x[2] + 4*x[3]
+class AffineTestMapping : public VectorMapping<VD>
+{
+public:
+    unsigned int inputSize() const {
+        return 4;
+    }
+    unsigned int outputSize() const {
+        return 5;
+    }
+    void map(V& dst, const V& x) const {
+        dst.resize(5);
+        for (unsigned int i=0; i<5; ++i)
+            dst[i] = 10*i + x[0] + 2*x[1] + 3*x[2] + 4*x[3];
+    }
+};
+
+} // anonymous namespace
+
+TEST(VectorNarrowingMapping, NarrowsInputAndOutputIndependently) {
+    typedef VectorTemplate<VD> V;
+    VectorNarrowingMapping<VD> m;
+    m.setMapping(std::make_shared<AffineTestMapping>());
+    V state(4);
+    state[1] = 100;
+    m.setInputNarrowing({ 1 }, state);
+    m.setOutputNarrowing({ 3, 0 });
+    ASSERT_EQ(m.inputSize(), 3u);
+    ASSERT_EQ(m.outputSize(), 3u);
+
+    // The output must consist of the elements 1, 2, 4 of the full output,
+    // computed at the full input (1, 100, 2, 3)
+    V x(3), y;
+    x[0] = 1;
+    x[1] = 2;
+    x[2] = 3;
+    m.map(y, x);
+    ASSERT_EQ(y.size(), 3u);
+    const double s = 1 + 2*100 + 3*2 + 4*3;
+    EXPECT_EQ(y[0], 10 + s);
+    EXPECT_EQ(y[1], 20 + s);
+    EXPECT_EQ(y[2], 40 + s);
+}
+
+TEST(OdeSolver, DumpsJacobians) {
+    OdeNumIntClassesRegistrator<VD> r;
+    testmodels::OdeTestModelClassesRegistrator<VD> mr;
+    typedef JacobianDumper<VD>::SparseMatrix SparseMatrix;
+
+    // The matrices read back from the dump must be the ones passed to the LU factorizer
+    for (auto format : { "mtx", "bin" }) {
+        auto prefix = ::testing::TempDir() + "ode_num_int_jacobian_";
+        OdeSolverConfiguration<VD> config;
+        config.setValue("rhs", "coupled_nl_osc");
+        config.setValue("rhs.n", 20u);
+        config.setValue("solver", "rosenbrock_sw2_4");
+        config.setValue("time", 0.01);
+        config.setValue("output_jacobian", "jacobian_dump");
+        config.setValue("output_jacobian.file_name", prefix);
+        config.setValue("output_jacobian.format", format);
+        auto rhs = config.parameterProvider()->odeRhs();
+        Vector<double> x0(rhs->varCount());
+        for (unsigned int i=0; i<x0.size(); ++i)
+            x0[i] = 0.01*(i%7);
+        auto components = config.apply(std::set<unsigned int>(), 0, x0);
+
+        std::vector< sparse::SparseMatrix<double> > matrices;
+        cxx::ScopedIdentifiedElement< JacobianObservers<VD>::cb_type > cb(
+                    components.solver()->jacobianObservers,
+                    [&matrices](const SparseMatrix& J, const VectorTemplate<VD>&, const VectorTemplate<VD>&) {
+            sparse::SparseMatrix<double> m(J.size());
+            for (auto v : J)
+                m.at(v.first.first, v.first.second) = v.second;
+            matrices.push_back(m);
+        });
+        solveOde(&config, &components);
+        ASSERT_FALSE(matrices.empty()) << format;
+
+        for (unsigned int k=0; k<matrices.size(); ++k) {
+            auto fileName = prefix + cxx::FormatInt(k) + "." + format;
+            std::ifstream is(fileName, std::ios::binary);
+            ASSERT_TRUE(is.is_open()) << fileName;
+            sparse::CsrSparseMatrix<double> m;
+            if (format == std::string("bin"))
+                sparse::readBinary(is, m);
+            else
+                sparse::readMatrixMarket(is, m);
+            is.close();
+            std::remove(fileName.c_str());
+            auto& expected = matrices[k];
+            ASSERT_EQ(m.size(), expected.size()) << fileName;
+            ASSERT_EQ(m.count(), expected.count()) << fileName;
+            for (auto v : expected)
+                EXPECT_EQ(m.get(v.first.first, v.first.second), v.second) << fileName;
+        }
+        auto fileName = prefix + cxx::FormatInt(matrices.size()) + "." + format;
+        EXPECT_FALSE(std::ifstream(fileName).is_open()) << fileName;
+    }
+}
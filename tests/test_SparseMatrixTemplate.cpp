@@ -0,0 +1,857 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include "ode_num_int/SparseMatrixTemplate.h"
+#include "ode_num_int/SparseMatrixBuilder.h"
+#include "ode_num_int/SparsePatternUnion.h"
+#include "ode_num_int/SparseMatrixBsrData.h"
+#include "ode_num_int/LUFactorizer.h"
+#include "ode_num_int/BlockLUFactorizer.h"
+#include "ode_num_int/SparseLUFactorizer.h"
+#include "ode_num_int/GenericLUFactorizer.h"
+#include "ode_num_int/MixedPrecisionLUFactorizer.h"
+#include "ode_num_int/SparseMatrixIO.h"
+#include "ode_num_int/SparseMatrixReordering.h"
+
+using namespace ctm::math;
+using namespace ctm::math::sparse;
+
+namespace {
+
+// 0 1 0 2
+// 0 0 0 0
+// 3 0 4 0
+SparseMatrix<double> makeMatrix()
+{
+    SparseMatrix<double> result(3, 4);
+    result.at(2, 2) = 4;
+    result.at(0, 3) = 2;
+    result.at(2, 0) = 3;
+    result.at(0, 1) = 1;
+    return result;
+}
+
+template< class D >
+void expectEqual(const SparseMatrixTemplate<D>& actual, const SparseMatrix<double>& expected)
+{
+    ASSERT_EQ(actual.size(), expected.size());
+    ASSERT_EQ(actual.count(), expected.count());
+    for (auto v : expected)
+        EXPECT_EQ(actual.checkedGet(v.first), std::make_pair(v.second, true));
+    for (auto v : actual)
+        EXPECT_EQ(expected.checkedGet(v.first), std::make_pair(double(v.second), true));
+}
+
+template< class D >
+void testCompressedMatrix()
+{
+    typedef SparseMatrixTemplate<D> M;
+    typedef SparseMatrixCommonTypes::Index Index;
+    auto m0 = makeMatrix();
+    M m(m0);
+    expectEqual(m, m0);
+    EXPECT_EQ(m.get(1, 1), 0);
+    EXPECT_FALSE(m.hasIndex(Index(1, 3)));
+
+    // Row ranges
+    for (unsigned int r=0; r<3; ++r) {
+        std::vector<unsigned int> columns, expectedColumns;
+        for (auto it=m.rowBegin(r), end=m.rowEnd(r); it!=end; ++it) {
+            EXPECT_EQ(it->first.first, r);
+            columns.push_back(it->first.second);
+        }
+        for (auto it=m0.rowBegin(r), end=m0.rowEnd(r); it!=end; ++it)
+            expectedColumns.push_back(it->first.second);
+        EXPECT_EQ(columns, expectedColumns);
+    }
+
+    // Modification of elements
+    m.at(1, 2) = 5;
+    m0.at(1, 2) = 5;
+    m.at(2, 0) *= 2;
+    m0.at(2, 0) *= 2;
+    m.removeAt(Index(0, 3));
+    m0.removeAt(Index(0, 3));
+    expectEqual(m, m0);
+
+    // Arithmetic
+    M w = M::identity(3);
+    w -= m.block(0, 0, 3, 3).scaled(2);
+    SparseMatrix<double> w0 = SparseMatrix<double>::identity(3);
+    w0 -= m0.block(0, 0, 3, 3).scaled(2);
+    expectEqual(w, w0);
+    w.makeZero();
+    EXPECT_EQ(w.count(), w0.count());
+    EXPECT_EQ(w.infNorm(), 0);
+
+    std::vector<double> x = { 1, 2, 3, 4 }, y(3), y0(3);
+    m.mulVectRight(x.begin(), y.begin());
+    m0.mulVectRight(x.begin(), y0.begin());
+    EXPECT_EQ(y, y0);
+
+    m.resize(3, 2);
+    m0.resize(3, 2);
+    expectEqual(m, m0);
+    m.clear();
+    EXPECT_TRUE(m.empty());
+    EXPECT_EQ(m.rowBegin(0), m.rowEnd(0));
+}
+
+} // anonymous namespace
+
+TEST(SparseMatrixTemplate, SupportsCsrData) {
+    testCompressedMatrix< SparseMatrixCsrData<double> >();
+}
+
+TEST(SparseMatrixTemplate, SupportsCscData) {
+    testCompressedMatrix< SparseMatrixCscData<double> >();
+}
+
+TEST(SparseMatrixTemplate, SupportsRowRangesOfFastData) {
+    auto m0 = makeMatrix();
+    SparseMatrixTemplate< SparseMatrixFastData<double> > m(SparseMatrixFastData<double>(m0), m0.size());
+    EXPECT_EQ(std::distance(m.rowBegin(0), m.rowEnd(0)), 2);
+    EXPECT_EQ(m.rowBegin(1), m.rowEnd(1));
+    EXPECT_EQ(m.rowBegin(2)->second, 3);
+    m.removeAt(SparseMatrixCommonTypes::Index(2, 0));
+    EXPECT_EQ(m.rowBegin(2)->second, 4);
+}
+
+TEST(SparseMatrixTemplate, MultipliesCompressedMatricesByVectors) {
+    // Banded matrix with rows of different lengths, large enough to be processed by several threads
+    const unsigned int n = 3*VectorKernels::ChunkSize;
+    SparseMatrixTemplate< SparseMatrixFastData<double> > m0(n, n);
+    for (unsigned int r=0; r<n; ++r)
+        for (unsigned int c=r<3? 0: r-3, cend=std::min(n, r+1+r%5); c<cend; ++c)
+            m0.append(SparseMatrixCommonTypes::Index(r, c), 1 + 0.001*r - 0.01*c);
+    Vector<double> x(n);
+    for (unsigned int i=0; i<n; ++i)
+        x[i] = std::sin(0.1*i);
+    Vector<double> y0 = m0*x, z0 = x*m0;
+
+    CsrSparseMatrix<double> csr(SparseMatrixCsrData<double>(m0), m0.size());
+    CscSparseMatrix<double> csc(SparseMatrixCscData<double>(m0), m0.size());
+    for (auto threadCount : { 1u, 4u }) {
+        VectorKernels::setThreadCount(threadCount);
+        // All kernels accumulate the sum for each element of the result in the same order
+        EXPECT_TRUE((csr*x).data() == y0.data());
+        EXPECT_TRUE((x*csr).data() == z0.data());
+        EXPECT_TRUE((csc*x).data() == y0.data());
+        EXPECT_TRUE((x*csc).data() == z0.data());
+    }
+    VectorKernels::setThreadCount(1);
+}
+
+TEST(SparseMatrixTemplate, MultipliesSparseMatrices) {
+    typedef SparseMatrixCommonTypes::Index Index;
+    SparseMatrix<double> a(5, 4), b(4, 6);
+    for (unsigned int r=0; r<5; ++r)
+        for (unsigned int c=0; c<4; ++c)
+            if ((r*7 + c*3) % 4 != 0)
+                a.at(r, c) = 1 + r - 0.5*c;
+    for (unsigned int r=0; r<4; ++r)
+        for (unsigned int c=0; c<6; ++c)
+            if ((r*5 + c) % 3 == 0)
+                b.at(r, c) = 2 - r + 0.25*c;
+    a.removeAt(Index(4, 1));
+
+    auto ab = a*b;
+    ASSERT_EQ(ab.size(), Index(5, 6));
+    for (unsigned int r=0; r<5; ++r)
+        for (unsigned int c=0; c<6; ++c) {
+            double expected = 0;
+            bool nonzero = false;
+            for (unsigned int k=0; k<4; ++k)
+                if (a.hasIndex(Index(r, k)) && b.hasIndex(Index(k, c))) {
+                    expected += a.get(r, k) * b.get(k, c);
+                    nonzero = true;
+                }
+            EXPECT_EQ(ab.hasIndex(Index(r, c)), nonzero);
+            EXPECT_DOUBLE_EQ(ab.get(r, c), expected);
+        }
+
+    // Pattern computed once, values computed for updated operands
+    CsrSparseMatrix<double> c;
+    productPattern(c, a, b);
+    EXPECT_EQ(c.count(), ab.count());
+    EXPECT_EQ(c.infNorm(), 0);
+    std::vector<double> accumulator(6, 0.);
+    CsrSparseMatrix<double> csrA(a), csrB(b);
+    csrA.values()[0] = 10;
+    product(c, csrA, csrB, accumulator);
+    expectEqual(c, SparseMatrix<double>(csrA*csrB));
+    EXPECT_EQ(std::count(accumulator.begin(), accumulator.end(), 0.), 6);
+
+    // Products with proxies
+    expectEqual(a.transposed()*a, SparseMatrix<double>(a.transposed().clone()*a));
+}
+
+TEST(SparseMatrixTemplate, IsAssembledFromUnsortedEntries) {
+    SparseMatrixBuilder<double> builder;
+    SparseMatrix<double> expected(4, 5);
+    auto addEntries = [&](bool updateExpected) {
+        for (unsigned int i=0; i<40; ++i) {
+            unsigned int r = (i*7) % 4,   c = (i*3 + i/4) % 5;
+            double v = 0.5*i - 3;
+            builder.add(r, c, v);
+            if (updateExpected)
+                expected.at(r, c) += v;
+        }
+    };
+
+    addEntries(true);
+    EXPECT_EQ(builder.count(), 40u);
+    SparseMatrixTemplate< SparseMatrixFastData<double> > fast;
+    builder.build(fast, expected.size());
+    EXPECT_EQ(builder.count(), 0u);
+    expectEqual(fast, expected);
+    EXPECT_TRUE(std::is_sorted(fast.begin(), fast.end()));
+
+    CsrSparseMatrix<double> csr;
+    addEntries(false);
+    builder.build(csr, expected.size());
+    expectEqual(csr, expected);
+
+    CscSparseMatrix<double> csc;
+    addEntries(false);
+    builder.build(csc, expected.size());
+    expectEqual(csc, expected);
+
+    builder.add(4, 0, 1.);
+    EXPECT_THROW(builder.build(csr, expected.size()), ctm::cxx::exception);
+}
+
+TEST(SparseMatrixTemplate, CombinesMatricesWithSharedPattern) {
+    CsrSparseMatrix<double> a(4, 4), b(4, 4), w;
+    a.at(0, 1) = 1;
+    a.at(2, 2) = 2;
+    a.at(3, 0) = 3;
+    b.at(0, 1) = 4;
+    b.at(1, 3) = 5;
+    b.at(3, 3) = 6;
+    SparsePatternUnion<double> pattern;
+    pattern.init(w, a, b);
+    EXPECT_EQ(w.count(), 7u);
+
+    for (double h : { 0.1, 0.3 }) {
+        a.at(2, 2) = h;
+        pattern.combine(w, 1, a, -h, b, -h*h);
+        SparseMatrix<double> expected = SparseMatrix<double>::identity(4);
+        expected -= a.scaled(h);
+        expected -= b.scaled(h*h);
+        expectEqual(w, expected);
+    }
+}
+
+TEST(SparseMatrixTemplate, SupportsBsrData) {
+    typedef SparseMatrixCommonTypes::Index Index;
+    // Block tridiagonal matrix of 2x2 blocks, with the first block row shorter than the others
+    const unsigned int n = 12;
+    SparseMatrix<double> m0(n, n);
+    for (unsigned int r=0; r<n; ++r)
+        for (unsigned int c=r/2*2 < 2? 0: r/2*2-2, cend=std::min(n, r/2*2+4); c<cend; ++c)
+            if (r >= 2 || c < 2)
+                m0.at(r, c) = r == c? 10 + r: 1 + 0.1*r - 0.2*c;
+    BsrSparseMatrix<double, 2> m(SparseMatrixBsrData<double, 2>(m0), m0.size());
+    expectEqual(m, m0);
+    EXPECT_EQ(m.blockCount(), m0.count()/4);
+    EXPECT_TRUE(std::is_sorted(m.begin(), m.end()));
+    EXPECT_EQ(std::distance(m.rowBegin(0), m.rowEnd(0)), 2);
+    EXPECT_EQ(std::distance(m.rowBegin(5), m.rowEnd(5)), 6);
+
+    Vector<double> x(n);
+    for (unsigned int i=0; i<n; ++i)
+        x[i] = std::sin(0.1*i);
+    EXPECT_TRUE((m*x).data() == (m0*x).data());
+    EXPECT_TRUE((x*m).data() == (x*m0).data());
+
+    // Inserting an element inserts a zero block; removing all elements of a block removes it
+    m.at(0, 11) = 5;
+    EXPECT_EQ(m.count(), m0.count() + 4);
+    EXPECT_EQ(m.get(1, 10), 0);
+    EXPECT_TRUE(m.hasIndex(Index(1, 10)));
+    m.at(1, 10) = 6;
+    m.removeAt(Index(0, 11));
+    EXPECT_EQ(m.count(), m0.count() + 4);
+    m.removeAt(Index(1, 10));
+    expectEqual(m, m0);
+    EXPECT_THROW(m.resize(n, n-1), ctm::cxx::exception);
+
+    // Block LU factorization gives the same solution as the scalar one
+    std::vector<double> b(n), b0(n);
+    for (unsigned int i=0; i<n; ++i)
+        b[i] = b0[i] = std::cos(0.3*i);
+    LUFactorizer<double> lu0(m0);
+    BlockLUFactorizer<double, 2> lu(m);
+    EXPECT_EQ(lu.size(), n);
+    lu0.solve(b0.data());
+    lu.solve(b.data());
+    for (unsigned int i=0; i<n; ++i)
+        EXPECT_NEAR(b[i], b0[i], 1e-12);
+    EXPECT_THROW((BlockLUFactorizer<double, 5>(m0)), ctm::cxx::exception);
+}
+
+TEST(SparseMatrixTemplate, IsWrittenAndReadBack) {
+    auto m0 = makeMatrix();
+    m0.at(1, 1) = 1./3;
+
+    std::stringstream mtx;
+    writeMatrixMarket(mtx, m0);
+    CsrSparseMatrix<double> csr;
+    readMatrixMarket(mtx, csr);
+    expectEqual(csr, m0);
+
+    std::stringstream bin(std::ios::in | std::ios::out | std::ios::binary);
+    writeBinary(bin, csr);
+    SparseMatrixTemplate< SparseMatrixFastData<double> > fast;
+    readBinary(bin, fast);
+    expectEqual(fast, m0);
+
+    std::istringstream symmetric(
+        "%%MatrixMarket matrix coordinate real symmetric\n"
+        "% comment\n"
+        "3 3 3\n"
+        "1 1 2.5\n"
+        "3 1 -1\n"
+        "2 2 4\n");
+    readMatrixMarket(symmetric, csr);
+    EXPECT_EQ(csr.count(), 4u);
+    EXPECT_EQ(csr.get(0, 2), -1);
+    EXPECT_EQ(csr.get(2, 0), -1);
+
+    std::istringstream truncated("%%MatrixMarket matrix coordinate real general\n2 2 2\n1 1 1\n");
+    EXPECT_THROW(readMatrixMarket(truncated, csr), ctm::cxx::exception);
+
+    // The size line must be validated before the memory for the elements is allocated
+    for (auto sizeLine : { "5000000000 2 1", "2 2 5", "100000 100000 1000000000",
+                           "4294967295 4294967295 18446744073709551615" }) {
+        std::istringstream badSize(std::string("%%MatrixMarket matrix coordinate real symmetric\n") + sizeLine + "\n1 1 1\n");
+        EXPECT_THROW(readMatrixMarket(badSize, csr), ctm::cxx::exception) << sizeLine;
+    }
+    std::istringstream garbage("not a matrix");
+    EXPECT_THROW(readBinary(garbage, csr), ctm::cxx::exception);
+
+    // The number of elements in the header must fit both the matrix and the data
+    auto withCount = [&](std::uint64_t count) {
+        auto data = bin.str();
+        std::memcpy(&data[offsetof(priv::BinaryMatrixHeader, count)], &count, sizeof(count));
+        return data;
+    };
+    std::istringstream tooManyForSize(withCount(m0.size().first * m0.size().second + 1));
+    EXPECT_THROW(readBinary(tooManyForSize, csr), ctm::cxx::exception);
+    std::istringstream tooManyForData(withCount(m0.count() + 1));
+    EXPECT_THROW(readBinary(tooManyForData, csr), ctm::cxx::exception);
+    std::istringstream huge(withCount(~std::uint64_t(0)));
+    EXPECT_THROW(readBinary(huge, csr), ctm::cxx::exception);
+    std::istringstream exact(withCount(m0.count()));
+    readBinary(exact, fast);
+    expectEqual(fast, m0);
+}
+
+TEST(SparseMatrixTemplate, IsReorderedToReduceEnvelope) {
+    // Pentadiagonal matrix with rows and columns scrambled by the permutation i -> 7*i mod n
+    const unsigned int n = 30;
+    SparseMatrix<double> banded(n, n);
+    for (unsigned int r=0; r<n; ++r)
+        for (unsigned int c=r<2? 0: r-2; c<std::min(n, r+3); ++c)
+            banded.at(r, c) = r == c? 10: 1 + 0.01*r - 0.02*c;
+    auto scramble = [](unsigned int i) { return (7*i) % n; };
+    CsrSparseMatrix<double> m(n, n);
+    for (auto v : banded)
+        m.at(scramble(v.first.first), scramble(v.first.second)) = v.second;
+
+    auto bandedEnvelope = envelopeSize(banded);
+    EXPECT_EQ(bandedEnvelope, 2*(2*n - 3));
+    EXPECT_GT(envelopeSize(m), 3*bandedEnvelope);
+    SparsePatternGraph g(m);
+    for (auto ordering : { reverseCuthillMcKeeOrdering(g), sloanOrdering(g) }) {
+        auto sorted = ordering;
+        std::sort(sorted.begin(), sorted.end());
+        for (unsigned int i=0; i<n; ++i)
+            ASSERT_EQ(sorted[i], i);
+        EXPECT_LE(envelopeSize(m, ordering), bandedEnvelope);
+    }
+
+    ReorderingStats stats;
+    auto ordering = computeReordering(m, BestReordering, &stats);
+    ASSERT_EQ(ordering.size(), n);
+    EXPECT_EQ(stats.envelopeBefore, envelopeSize(m));
+    EXPECT_EQ(stats.envelopeAfter, envelopeSize(m, ordering));
+    EXPECT_TRUE(computeReordering(banded, BestReordering).empty());
+
+    // Solution of the reordered system is the same
+    CsrSparseMatrix<double> reordered;
+    std::vector<std::size_t> positions;
+    permutePattern(reordered, positions, m, ordering);
+    permuteValues(reordered, positions, m);
+    std::vector<double> b(n), b0(n);
+    for (unsigned int i=0; i<n; ++i)
+        b0[i] = std::cos(0.3*i);
+    for (unsigned int i=0; i<n; ++i)
+        b[i] = b0[ordering[i]];
+    LUFactorizer<double>(m).solve(b0.data());
+    LUFactorizer<double> lu(reordered);
+    lu.solve(b.data());
+    for (unsigned int i=0; i<n; ++i)
+        EXPECT_NEAR(b[i], b0[ordering[i]], 1e-12);
+}
+
+TEST(SparseMatrixTemplate, IsFactorizedWithFillBeyondRowOfMatrix) {
+    // 2 0 1
+    // 1 2 0
+    // 0 1 2
+    // Row 1 of U gets fill in column 2, beyond the last element of row 1 of the matrix
+    SparseMatrix<double> m(3, 3);
+    m.at(0, 0) = 2;   m.at(0, 2) = 1;
+    m.at(1, 0) = 1;   m.at(1, 1) = 2;
+    m.at(2, 1) = 1;   m.at(2, 2) = 2;
+    std::vector<double> x = { 1, 2, 3 },   b(3),   b1(3);
+    m.mulVectRight(x.begin(), b.begin());
+    b1 = b;
+    LUFactorizer<double>(m).solve(b.data());
+    BlockLUFactorizer<double, 1>(m).solve(b1.data());
+    for (unsigned int i=0; i<3; ++i) {
+        EXPECT_NEAR(b[i], x[i], 1e-14);
+        EXPECT_NEAR(b1[i], x[i], 1e-14);
+    }
+}
+
+TEST(SparseMatrixTemplate, IsFactorizedWithPivoting) {
+    // Matrix with zero diagonal: rows of a diagonally dominant matrix are cyclically shifted
+    const unsigned int n = 20;
+    SparseMatrix<double> m(n, n);
+    auto shift = [](unsigned int r) { return (r + 3) % n; };
+    for (unsigned int r=0; r<n; ++r) {
+        m.at(shift(r), r) = 4 + 0.1*r;
+        m.at(shift(r), (r+7) % n) = 1;
+        m.at(shift(r), (r*5) % n) += -0.5;
+    }
+    EXPECT_THROW(LUFactorizer<double>{m}, ctm::cxx::exception);
+
+    auto residual = [&m](const std::vector<double>& x, const std::vector<double>& b) {
+        std::vector<double> ax(n);
+        for (auto v : m)
+            ax[v.first.first] += v.second * x[v.first.second];
+        double result = 0;
+        for (unsigned int i=0; i<n; ++i)
+            result = std::max(result, std::fabs(ax[i] - b[i]));
+        return result;
+    };
+    std::vector<double> b(n);
+    for (unsigned int i=0; i<n; ++i)
+        b[i] = std::sin(0.7*i);
+
+    SparseLUFactorizer<double> lu(m);
+    auto x = b;
+    lu.solve(x.data());
+    EXPECT_LT(residual(x, b), 1e-13);
+    EXPECT_LT(lu.factorsSize(), n*n);
+
+    // Numeric factorization with the same pattern
+    for (auto& v : m)
+        v.second *= 1.5;
+    lu.setMatrixFast(m);
+    x = b;
+    lu.solve(x.data());
+    EXPECT_LT(residual(x, b), 1e-13);
+
+    // Secant update
+    std::vector<double> s(n), y(n);
+    for (unsigned int i=0; i<n; ++i)
+        s[i] = std::cos(0.3*i);
+    for (auto v : m)
+        y[v.first.first] += 1.1 * v.second * s[v.first.second];
+    lu.secantUpdateHart(s.data(), y.data());
+    lu.solve(y.data());
+    for (unsigned int i=0; i<n; ++i)
+        EXPECT_NEAR(y[i], s[i], 1e-12);
+}
+
+TEST(SparseMatrixTemplate, IsRefactorizedWithCachedSymbolicAnalysis) {
+    const unsigned int n = 10;
+    auto makeTridiagonal = [](double scale) {
+        SparseMatrix<double> m(n, n);
+        for (unsigned int r=0; r<n; ++r) {
+            m.at(r, r) = 4*scale;
+            if (r > 0)
+                m.at(r, r-1) = -scale;
+            if (r+1 < n)
+                m.at(r, r+1) = -2*scale;
+        }
+        return m;
+    };
+    auto solve = [](LUFactorizer<double>& lu, const SparseMatrix<double>& m) {
+        std::vector<double> b(n), x(n);
+        for (unsigned int i=0; i<n; ++i)
+            x[i] = 1 + 0.1*i;
+        m.mulVectRight(x.begin(), b.begin());
+        lu.solve(b.data());
+        for (unsigned int i=0; i<n; ++i)
+            EXPECT_NEAR(b[i], x[i], 1e-12);
+    };
+
+    auto m = makeTridiagonal(1);
+    LUFactorizer<double> lu(m);
+    auto hash = lu.symbolic().patternHash;
+    solve(lu, m);
+
+    // Same pattern: pure scatter, the symbolic analysis is kept
+    m = makeTridiagonal(2);
+    lu.setMatrixFast(m);
+    EXPECT_EQ(lu.symbolic().patternHash, hash);
+    solve(lu, m);
+
+    // Elements dropped: the pattern fits into the profile, which is kept
+    auto lSize = lu.symbolic().lSize(),   uSize = lu.symbolic().uSize();
+    SparseMatrix<double> m1(n, n);
+    for (auto& v : m)
+        if (v.first.first != 3 || v.first.second != 4)
+            m1.at(v.first) = v.second;
+    lu.setMatrixFast(m1);
+    EXPECT_NE(lu.symbolic().patternHash, hash);
+    EXPECT_EQ(lu.symbolic().count, m1.count());
+    EXPECT_EQ(lu.symbolic().uSize(), uSize);
+    solve(lu, m1);
+
+    // Changed pattern: detected by the hash, the symbolic analysis is redone
+    m.at(n-1, 0) = 0.5;
+    lu.setMatrixFast(m);
+    EXPECT_NE(lu.symbolic().patternHash, hash);
+    EXPECT_EQ(lu.firstCol(n-1), 0u);
+    EXPECT_GT(lu.symbolic().lSize(), lSize);
+    solve(lu, m);
+}
+
+TEST(SparseMatrixTemplate, IsFactorizedInParallelByLevels) {
+    // Independent banded diagonal blocks, coupled by the last rows and columns (arrow matrix)
+    const unsigned int blockCount = 8, blockSize = 200, bandwidth = 80, arrowSize = 4;
+    const unsigned int n = blockCount*blockSize + arrowSize;
+    SparseMatrix<double> m(n, n);
+    for (unsigned int b=0; b<blockCount; ++b)
+        for (unsigned int i=0; i<blockSize; ++i) {
+            auto r = b*blockSize + i;
+            for (unsigned int j=(i>bandwidth? i-bandwidth: 0); j<std::min(i+bandwidth+1, blockSize); ++j)
+                m.at(r, b*blockSize+j) = r == b*blockSize+j?   4*bandwidth:   std::sin(0.3*r + 0.7*j);
+        }
+    for (unsigned int r=n-arrowSize; r<n; ++r)
+        for (unsigned int c=0; c<n; ++c) {
+            m.at(r, c) = r == c?   4.0*n:   std::cos(0.1*c + r);
+            m.at(c, r) = c == r?   4.0*n:   std::cos(0.2*c - r);
+        }
+
+    std::vector<double> x(n), firstResult;
+    for (unsigned int i=0; i<n; ++i)
+        x[i] = 1 + 0.01*i;
+    for (auto threadCount : { 1u, 4u }) {
+        VectorKernels::setThreadCount(threadCount);
+        LUFactorizer<double> lu(m);
+        EXPECT_LT(lu.symbolic().factorizeLevels.levelCount(), n/2);
+        std::vector<double> b(n);
+        m.mulVectRight(x.begin(), b.begin());
+        lu.solve(b.data());
+        if (threadCount == 1) {
+            for (unsigned int i=0; i<n; ++i)
+                EXPECT_NEAR(b[i], x[i], 1e-10);
+            firstResult = b;
+        }
+        else {
+            // Results must be bitwise identical to the serial ones
+            for (unsigned int i=0; i<n; ++i)
+                ASSERT_EQ(b[i], firstResult[i]);
+        }
+    }
+    VectorKernels::setThreadCount(1);
+}
+
+TEST(SparseMatrixTemplate, IsSubstitutedInParallelByLevels) {
+    // Many small dense diagonal blocks coupled by the last rows and columns, so that the
+    // substitution levels are wide enough to run in parallel
+    const unsigned int blockCount = 1024, blockSize = 40, arrowSize = 2;
+    const unsigned int n = blockCount*blockSize + arrowSize;
+    SparseMatrix<double> m(n, n);
+    for (unsigned int b=0; b<blockCount; ++b)
+        for (unsigned int i=0; i<blockSize; ++i)
+            for (unsigned int j=0; j<blockSize; ++j) {
+                auto r = b*blockSize + i, c = b*blockSize + j;
+                m.at(r, c) = r == c?   4*blockSize:   std::sin(0.3*r + 0.7*c);
+            }
+    for (unsigned int r=n-arrowSize; r<n; ++r)
+        for (unsigned int c=0; c<n; ++c) {
+            m.at(r, c) = r == c?   4.0*n:   std::cos(0.1*c + r);
+            m.at(c, r) = c == r?   4.0*n:   std::cos(0.2*c - r);
+        }
+
+    std::vector<double> x(n), firstResult;
+    for (unsigned int i=0; i<n; ++i)
+        x[i] = 1 + 0.01*i;
+    for (auto threadCount : { 1u, 4u }) {
+        VectorKernels::setThreadCount(threadCount);
+        LUFactorizer<double> lu(m);
+        // Backward steps depend only on the nonzero columns of U, not on all columns up to the arrow
+        auto& symbolic = lu.symbolic();
+        EXPECT_LE(symbolic.forwardLevels.levelCount(), blockSize + arrowSize);
+        EXPECT_LE(symbolic.backwardLevels.levelCount(), blockSize + arrowSize);
+        std::vector<double> b(n);
+        m.mulVectRight(x.begin(), b.begin());
+        lu.solve(b.data());
+        if (threadCount == 1) {
+            for (unsigned int i=0; i<n; ++i)
+                EXPECT_NEAR(b[i], x[i], 1e-10);
+            firstResult = b;
+        }
+        else {
+            for (unsigned int i=0; i<n; ++i)
+                ASSERT_EQ(b[i], firstResult[i]);
+        }
+    }
+    VectorKernels::setThreadCount(1);
+}
+
+TEST(SparseMatrixTemplate, IsSolvedForMultipleRightHandSides) {
+    const unsigned int n = 50, nrhs = 11, ldb = n + 3;
+    SparseMatrix<double> m(n, n);
+    for (unsigned int r=0; r<n; ++r) {
+        m.at(r, r) = 10;
+        if (r > 0)
+            m.at(r, r-1) = -1;
+        if (r+1 < n)
+            m.at(r, r+1) = -2;
+        m.at(r, (r*7)%n) += 0.5;
+    }
+    LUFactorizer<double> lu(m);
+    std::vector<double> B(ldb*nrhs, -1);
+    for (unsigned int j=0; j<nrhs; ++j)
+        for (unsigned int i=0; i<n; ++i)
+            B[j*ldb+i] = std::sin(0.3*i + j);
+    auto X = B;
+    lu.solve(X.data(), nrhs, ldb);
+    for (unsigned int j=0; j<nrhs; ++j) {
+        std::vector<double> x(B.begin()+j*ldb, B.begin()+j*ldb+n);
+        lu.solve(x.data());
+        for (unsigned int i=0; i<n; ++i)
+            EXPECT_DOUBLE_EQ(X[j*ldb+i], x[i]);
+        // Elements beyond the leading dimension are left untouched
+        for (unsigned int i=n; i<ldb; ++i)
+            EXPECT_EQ(X[j*ldb+i], -1);
+    }
+}
+
+TEST(SparseMatrixTemplate, IsFactorizedDenselyWhenEnvelopeIsFull) {
+    // Dense matrix with a zero diagonal element, requiring pivoting
+    const unsigned int n = 70;
+    SparseMatrix<double> m(n, n);
+    for (unsigned int r=0; r<n; ++r)
+        for (unsigned int c=0; c<n; ++c)
+            m.at(r, c) = r == c?   (r == 5? 0.0: 2.0):   std::sin(1.3*r + 0.7*c);
+    std::vector<double> x(n), b(n);
+    for (unsigned int i=0; i<n; ++i)
+        x[i] = 1 - 0.02*i;
+    m.mulVectRight(x.begin(), b.begin());
+
+    GenericLUFactorizer<double> lu(AutoLU);
+    lu.setMatrix(m);
+    EXPECT_EQ(lu.activeKind(), DenseLU);
+    auto y = b;
+    lu.solve(y.data());
+    for (unsigned int i=0; i<n; ++i)
+        EXPECT_NEAR(y[i], x[i], 1e-10);
+
+    // Secant update
+    std::vector<double> s(n), ys(n);
+    for (unsigned int i=0; i<n; ++i) {
+        s[i] = std::cos(0.1*i);
+        ys[i] = std::sin(0.2*i);
+    }
+    DenseLUFactorizer<double> dense(m);
+    dense.secantUpdateHart(s.data(), ys.data());
+    for (unsigned int r=0; r<n; ++r) {
+        double sum = 0;
+        for (unsigned int c=0; c<n; ++c)
+            sum += dense.elementAt(r, c) * s[c];
+        EXPECT_NEAR(sum, ys[r], 1e-10);
+    }
+
+    // A tridiagonal matrix with a corner element is factorized by the skyline factorizer
+    SparseMatrix<double> t(n, n);
+    for (unsigned int r=0; r<n; ++r) {
+        t.at(r, r) = 4;
+        if (r > 0)
+            t.at(r, r-1) = -1;
+        if (r+1 < n)
+            t.at(r, r+1) = -1;
+    }
+    t.at(n-1, 0) = 1;
+    lu.setMatrix(t);
+    EXPECT_EQ(lu.activeKind(), SkylineLU);
+    t.mulVectRight(x.begin(), b.begin());
+    lu.solve(b.data());
+    for (unsigned int i=0; i<n; ++i)
+        EXPECT_NEAR(b[i], x[i], 1e-12);
+}
+
+TEST(SparseMatrixTemplate, IsFactorizedAsBandMatrix) {
+    const unsigned int n = 200, kl = 2, ku = 3;
+    SparseMatrix<double> m(n, n);
+    for (unsigned int r=0; r<n; ++r)
+        for (unsigned int c=(r>kl? r-kl: 0); c<=std::min(n-1, r+ku); ++c)
+            m.at(r, c) = r == c?   10.0:   std::sin(0.9*r + 0.4*c);
+
+    GenericLUFactorizer<double> lu(AutoLU);
+    lu.setMatrix(m);
+    ASSERT_EQ(lu.activeKind(), BandedLU);
+    EXPECT_EQ(lu.bandedFactorizer().lowerBandwidth(), kl);
+    EXPECT_EQ(lu.bandedFactorizer().upperBandwidth(), ku);
+
+    // Solve for several right-hand sides; the results agree with the skyline factorizer
+    const unsigned int nrhs = 9;
+    std::vector<double> B(n*nrhs);
+    for (unsigned int i=0; i<B.size(); ++i)
+        B[i] = std::cos(0.01*i);
+    auto X = B,   Y = B;
+    lu.solve(X.data(), nrhs, n);
+    LUFactorizer<double> skyline(m);
+    skyline.solve(Y.data(), nrhs, n);
+    for (unsigned int i=0; i<B.size(); ++i)
+        EXPECT_NEAR(X[i], Y[i], 1e-12);
+
+    // Secant update
+    std::vector<double> s(n), y(n);
+    for (unsigned int i=0; i<n; ++i) {
+        s[i] = std::cos(0.1*i);
+        y[i] = std::sin(0.2*i);
+    }
+    lu.secantUpdateHart(s.data(), y.data());
+    lu.solve(y.data());
+    for (unsigned int i=0; i<n; ++i)
+        EXPECT_NEAR(y[i], s[i], 1e-10);
+
+    // A stray element far from the band: the factorization is chosen again, instead of widening the band
+    m.at(n-1, 0) = 0.5;
+    lu.setMatrixFast(m);
+    EXPECT_EQ(lu.activeKind(), SkylineLU);
+    std::vector<double> z(n), b(n);
+    for (unsigned int i=0; i<n; ++i)
+        z[i] = 1 + 0.01*i;
+    m.mulVectRight(z.begin(), b.begin());
+    lu.solve(b.data());
+    for (unsigned int i=0; i<n; ++i)
+        EXPECT_NEAR(b[i], z[i], 1e-10);
+}
+
+TEST(SparseMatrixTemplate, IsSolvedInMixedPrecision) {
+    const unsigned int n = 100;
+    SparseMatrix<double> m(n, n);
+    for (unsigned int r=0; r<n; ++r) {
+        m.at(r, r) = 3 + 0.01*r;
+        if (r > 0)
+            m.at(r, r-1) = -1.1;
+        if (r+1 < n)
+            m.at(r, r+1) = -0.9;
+        if (r >= 10)
+            m.at(r, r-10) = 0.3;
+    }
+    std::vector<double> x(n), b(n);
+    for (unsigned int i=0; i<n; ++i)
+        x[i] = std::sin(0.37*i);
+    m.mulVectRight(x.begin(), b.begin());
+
+    MixedPrecisionLUFactorizer<double> lu(m);
+    for (unsigned int steps : { 0u, 2u }) {
+        lu.setRefinementSteps(steps);
+        lu.setMatrixFast(m);
+        auto y = b;
+        lu.solve(y.data());
+        double err = 0;
+        for (unsigned int i=0; i<n; ++i)
+            err = std::max(err, std::fabs(y[i] - x[i]));
+        // Iterative refinement recovers double precision accuracy
+        if (steps == 0)
+            EXPECT_GT(err, 1e-10);
+        else {
+            EXPECT_LT(err, 1e-13);
+            EXPECT_TRUE(lu.refinementConverged());
+        }
+    }
+}
+
+namespace {
+
+// Matrix of the 1D Laplacian; its condition number is about 0.4*n^2
+SparseMatrix<double> makeLaplacian(unsigned int n)
+{
+    SparseMatrix<double> m(n, n);
+    for (unsigned int r=0; r<n; ++r) {
+        m.at(r, r) = 2;
+        if (r > 0)
+            m.at(r, r-1) = -1;
+        if (r+1 < n)
+            m.at(r, r+1) = -1;
+    }
+    return m;
+}
+
+} // anonymous namespace
+
+TEST(SparseMatrixTemplate, IsSolvedInMixedPrecisionWithIllConditionedMatrix) {
+    // The condition number, about 4e6, is close to the inverse of the single precision epsilon
+    const unsigned int n = 3000;
+    auto m = makeLaplacian(n);
+    std::vector<double> x(n), b(n);
+    for (unsigned int i=0; i<n; ++i)
+        x[i] = std::sin(0.37*i);
+    m.mulVectRight(x.begin(), b.begin());
+    auto error = [&](const std::vector<double>& y) {
+        double result = 0;
+        for (unsigned int i=0; i<n; ++i)
+            result = std::max(result, std::fabs(y[i] - x[i]));
+        return result;
+    };
+
+    // Two refinement steps are not enough here
+    MixedPrecisionLUFactorizer<double> lu(m);
+    lu.setRefinementSteps(2);
+    lu.setMatrixFast(m);
+    auto y = b;
+    lu.solve(y.data());
+    EXPECT_FALSE(lu.refinementConverged());
+    EXPECT_GT(error(y), 1e-9);
+
+    // Refinement goes on until the residual is at the level of double precision rounding errors
+    lu.setRefinementSteps(MixedPrecisionLUFactorizer<double>::DefaultRefinementSteps);
+    lu.setMatrixFast(m);
+    y = b;
+    lu.solve(y.data());
+    EXPECT_TRUE(lu.refinementConverged());
+    EXPECT_GT(lu.lastRefinementSteps(), 2u);
+    EXPECT_LT(error(y), 1e-9);
+}
+
+TEST(SparseMatrixTemplate, KeepsBestMixedPrecisionRefinement) {
+    // The condition number, about 4e8, is too large for refinement to converge,
+    // so it stops once a correction makes the residual larger
+    const unsigned int n = 30000;
+    auto m = makeLaplacian(n);
+    std::vector<double> b(n), r(n);
+    for (unsigned int i=0; i<n; ++i)
+        b[i] = std::sin(0.37*i);
+    MixedPrecisionLUFactorizer<double> lu(m);
+    double prevResidual = 0;
+    for (unsigned int steps=1; steps<=15; ++steps) {
+        lu.setRefinementSteps(steps);
+        lu.setMatrixFast(m);
+        auto y = b;
+        lu.solve(y.data());
+        EXPECT_FALSE(lu.refinementConverged());
+        EXPECT_LE(lu.lastRefinementSteps(), steps);
+        m.mulVectRight(y.begin(), r.begin());
+        double residual = 0;
+        for (unsigned int i=0; i<n; ++i)
+            residual = std::max(residual, std::fabs(r[i] - b[i]));
+        // More steps allowed must never give a worse solution
+        if (steps > 1)
+            EXPECT_LE(residual, prevResidual) << steps;
+        prevResidual = residual;
+    }
+    EXPECT_LT(lu.lastRefinementSteps(), 15u);
+}
@@ -1,7 +1,13 @@
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <cmath>
+#include <string>
+#include <cstdint>
 #include "ode_num_int/VectorTemplate.h"
+#include "ode_num_int/FixedVectorData.h"
+#include "ode_num_int/ThreadPool.h"
 
 using namespace ctm::math;
 
@@ -24,4 +30,218 @@ TEST(VectorTemplate, CopiesCtorInput) {
     ASSERT_TRUE(std::equal(v.begin(), v.end(), input_vector.begin()));
 }
 
+TEST(VectorTemplate, EvaluatesLazyExpressions) {
+    Vector<double> x0( VectorData<double>( std::vector<double>{ 1, 2, 3 } ) );
+    Vector<double> k1( VectorData<double>( std::vector<double>{ 1, 0, -1 } ) );
+    Vector<double> k2( VectorData<double>( std::vector<double>{ 2, 4, 8 } ) );
+
+    Vector<double> x = x0 + 0.5*( 2*k1 - k2*0.25 );
+    ASSERT_EQ(x.size(), 3u);
+    EXPECT_DOUBLE_EQ(x[0], 1.75);
+    EXPECT_DOUBLE_EQ(x[1], 1.5);
+    EXPECT_DOUBLE_EQ(x[2], 1);
+
+    x += k1 - k2;
+    EXPECT_DOUBLE_EQ(x[0], 0.75);
+    EXPECT_DOUBLE_EQ(x[1], -2.5);
+    EXPECT_DOUBLE_EQ(x[2], -8);
+
+    EXPECT_DOUBLE_EQ((k2 - k1).infNorm(), 9);
+    EXPECT_DOUBLE_EQ((x0 + k1).dot(k2), 4 + 8 + 16);
+}
+
+TEST(VectorTemplate, EvaluatesExpressionsOnBlocks) {
+    Vector<double> x( VectorData<double>( std::vector<double>{ 1, 2, 3, 4 } ) );
+    x.block(0, 2) = x.block(2, 2) + x.block(0, 2).scaled(2);
+    EXPECT_DOUBLE_EQ(x[0], 5);
+    EXPECT_DOUBLE_EQ(x[1], 8);
+    EXPECT_DOUBLE_EQ(x[2], 3);
+    EXPECT_DOUBLE_EQ(x[3], 4);
+
+    auto y = (x.block(0, 2) - x.block(2, 2)).clone();
+    EXPECT_DOUBLE_EQ(y[0], 2);
+    EXPECT_DOUBLE_EQ(y[1], 4);
+}
+
+TEST(VectorTemplate, KeepsTemporaryOperandsOfExpressions) {
+    auto filled = [](double value) {
+        return Vector<double>( VectorData<double>( std::vector<double>( 3, value ) ) );
+    };
+    auto a = filled(1);
+
+    // The temporaries are destroyed before the expressions are evaluated,
+    // and their memory is likely to be reused by the vectors allocated next
+    auto sum = a + filled(2);
+    auto difference = filled(10) - a;
+    auto scaled = 3*filled(4);
+    auto nested = (filled(5) - a).scaled(2) + filled(6)*0.5;
+    std::vector< Vector<double> > others;
+    for (int i=0; i<8; ++i)
+        others.push_back(filled(-100));
+
+    for (unsigned int i=0; i<3; ++i) {
+        EXPECT_EQ(sum[i], 3);
+        EXPECT_EQ(difference[i], 9);
+        EXPECT_EQ(scaled[i], 12);
+        EXPECT_EQ(nested[i], 11);
+    }
+    Vector<double> x = nested - sum;
+    EXPECT_EQ(x[0], 8);
+}
+
+TEST(VectorTemplate, KernelImplementationsAgree) {
+    const unsigned int n = 103;
+    Vector<double> a(n), b(n);
+    for (unsigned int i=0; i<n; ++i) {
+        a[i] = std::sin(1.1*i) * (i+1);
+        b[i] = std::cos(0.7*i) / (i+1);
+    }
+    Vector<double> scalarSum(n);
+    auto scalarDot = 0.;
+    for (unsigned int i=0; i<n; ++i) {
+        scalarSum[i] = a[i] + b[i];
+        scalarDot += a[i] * b[i];
+    }
+
+    std::string original = VectorKernels::implementation();
+    Vector<double> firstResult;
+    double firstNorms[4];
+    bool first = true;
+    for (auto name : { "avx512", "avx2", "portable" }) {
+        if (!VectorKernels::setImplementation(name))
+            continue;
+        Vector<double> x = a;
+        x += b;
+        for (unsigned int i=0; i<n; ++i)
+            EXPECT_EQ(x[i], scalarSum[i]);
+        x.block(1, n-2) *= 3;
+        x.block(1, n-2) -= b.block(0, n-2);
+        double norms[4] = { a.dot(b), x.infNorm(), x.oneNorm(), x.block(3, n-5).euclideanNormSquare() };
+        EXPECT_NEAR(norms[0], scalarDot, 1e-12*a.euclideanNorm()*b.euclideanNorm());
+        if (first) {
+            firstResult = x;
+            std::copy(norms, norms+4, firstNorms);
+            first = false;
+        }
+        else {
+            // Results must be bitwise identical regardless of the implementation
+            for (unsigned int i=0; i<n; ++i)
+                EXPECT_EQ(x[i], firstResult[i]);
+            for (unsigned int i=0; i<4; ++i)
+                EXPECT_EQ(norms[i], firstNorms[i]);
+        }
+    }
+    EXPECT_FALSE(VectorKernels::setImplementation("unknown"));
+    VectorKernels::setImplementation(original.c_str());
+}
+
+TEST(VectorTemplate, ParallelKernelsAreReproducible) {
+    const unsigned int n = 5*VectorKernels::ChunkSize + 103;
+    Vector<double> a(n), b(n);
+    for (unsigned int i=0; i<n; ++i) {
+        a[i] = std::sin(1.1*i) * (i%1000+1);
+        b[i] = std::cos(0.7*i) / (i%1000+1);
+    }
+    Vector<double> firstResult;
+    double firstNorms[4];
+    for (auto threadCount : { 1u, 2u, 4u }) {
+        VectorKernels::setThreadCount(threadCount);
+        EXPECT_EQ(VectorKernels::threadCount(), threadCount);
+        Vector<double> x = a;
+        x *= 3;
+        x -= b;
+        double norms[4] = { a.dot(b), x.infNorm(), x.oneNorm(), x.euclideanNormSquare() };
+        if (threadCount == 1) {
+            firstResult = x;
+            std::copy(norms, norms+4, firstNorms);
+        }
+        else {
+            // Results must be bitwise identical regardless of the number of threads
+            for (unsigned int i=0; i<n; ++i)
+                ASSERT_EQ(x[i], firstResult[i]);
+            for (unsigned int i=0; i<4; ++i)
+                EXPECT_EQ(norms[i], firstNorms[i]);
+        }
+    }
+    VectorKernels::setThreadCount(1);
+}
+
+TEST(ThreadPool, RunsNestedCallsInline) {
+    ctm::sys::ThreadPool pool(4);
+    std::atomic<unsigned int> count(0);
+    pool.parallelFor(8, [&](std::size_t) {
+        pool.parallelFor(10, [&](std::size_t) { ++count; });
+    });
+    EXPECT_EQ(count, 80u);
+}
+
+TEST(VectorTemplate, TakesAlignedMemoryFromArena) {
+    Vector<double> heapVector(5);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(heapVector.data().data()) % VectorArena::Alignment, 0u);
+    EXPECT_FALSE(heapVector.data().get_allocator().arena());
+
+    auto arena = std::make_shared<VectorArena>();
+    Vector<double> persistent;
+    {
+        VectorArena::Scope scope(arena);
+        for (int i=0; i<10; ++i) {
+            Vector<double> a(100), b(100);
+            b = a + b;
+            EXPECT_EQ(reinterpret_cast<std::uintptr_t>(b.data().data()) % VectorArena::Alignment, 0u);
+        }
+        persistent = Vector<double>(7);
+    }
+    EXPECT_EQ(arena->heapAllocationCount(), 3u);
+    EXPECT_EQ(VectorArena::current(), nullptr);
+    EXPECT_EQ(persistent.size(), 7u);
+
+    // Vectors share the ownership of the arena their memory comes from
+    std::weak_ptr<VectorArena> weakArena = arena;
+    arena.reset();
+    EXPECT_FALSE(weakArena.expired());
+    persistent = Vector<double>();
+    EXPECT_TRUE(weakArena.expired());
+}
+
+TEST(VectorTemplate, SupportsFixedSizeData) {
+    typedef VectorTemplate< FixedVectorData<double, 3> > V3;
+    static_assert(V3::size() == 3, "Fixed vector size must be known at compile time");
+
+    V3 x, y(3);
+    for (unsigned int i=0; i<3; ++i) {
+        EXPECT_EQ(x[i], 0);
+        x[i] = i + 1;
+        y[i] = 2;
+    }
+    V3 z = x + y.scaled(0.5);
+    EXPECT_DOUBLE_EQ(z[0], 2);
+    EXPECT_DOUBLE_EQ(z[2], 4);
+    EXPECT_DOUBLE_EQ(z.dot(x), 2 + 6 + 12);
+    EXPECT_DOUBLE_EQ(z.block(1, 2).infNorm(), 4);
+
+    EXPECT_NO_THROW(z.resize(3));
+    EXPECT_THROW(z.resize(2), ctm::cxx::exception);
+    EXPECT_THROW(V3(4), ctm::cxx::exception);
+}
+
+TEST(VectorTemplate, GathersAndScattersThroughViews) {
+    Vector<double> x(6);
+    for (unsigned int i=0; i<6; ++i)
+        x[i] = i;
+    std::vector<unsigned int> indices = { 4, 1, 3 };
+
+    Vector<double> y = x.indexed(indices);
+    ASSERT_EQ(y.size(), 3u);
+    EXPECT_EQ(y[0], 4);
+    EXPECT_EQ(y[1], 1);
+    EXPECT_EQ(y[2], 3);
+    EXPECT_EQ(x.indexed(indices).infNorm(), 4);
+
+    x.indexed(indices) = y.scaled(-1);
+    EXPECT_EQ(x[4], -4);
+    EXPECT_EQ(x[1], -1);
+    EXPECT_EQ(x[0], 0);
+    EXPECT_EQ(x[5], 5);
+}
+
 // TODO: More tests covering VectorTemplate interface